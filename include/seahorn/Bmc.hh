@@ -17,6 +17,9 @@
 
 #include "seahorn/Transforms/Instrumentation/ShadowMemDsa.hh"
 
+#include <map>
+#include <tuple>
+
 namespace seahorn
 {
   using namespace expr;
@@ -47,6 +50,8 @@ namespace seahorn
     
     /// path-condition for m_cps
     ExprVector m_side;
+    /// m_side [m_sideEnd [i-1], m_sideEnd [i]) is the encoding of m_edges [i]
+    std::vector<unsigned> m_sideEnd;
     
     
   public:
@@ -87,6 +92,12 @@ namespace seahorn
     /// Dump unsat core 
     /// Exposes internal details. Intendent to be used for debugging only
     void unsatCore (ExprVector &out);
+    /// A minimal unsat core of the path condition, and the positions
+    /// of the edges whose encoding it uses (edge i goes from cut point
+    /// i to i+1). The edges are minimized first, then the
+    /// constraints. Stops early, with a larger core, when the budget
+    /// of --horn-bmc-core-timeout runs out
+    void unsatCore (ExprVector &out, SmallVectorImpl<unsigned> &edges);
 
     friend class BmcTrace;
     
@@ -95,9 +106,17 @@ namespace seahorn
 
   class BmcTrace 
   {
+  public:
+    /// a value at a location on the trace
+    typedef std::pair<unsigned, const llvm::Value*> Point;
+
+  private:
     BmcEngine &m_bmc;
     
     ufo::ZModel<ufo::EZ3> m_model;
+
+    /// memoized values, by location, value, and model completion
+    std::map<std::tuple<unsigned, const llvm::Value*, bool>, Expr> m_values;
     
     /// the trace of basic blocks
     SmallVector<const BasicBlock *, 8> m_bbs;
@@ -122,6 +141,7 @@ namespace seahorn
     
     BmcTrace (const BmcTrace &other) :
       m_bmc (other.m_bmc), m_model (other.m_model),
+      m_values (other.m_values),
       m_bbs (other.m_bbs), m_cpId (other.m_cpId) {}
     
     /// underlying BMC engine
@@ -136,6 +156,16 @@ namespace seahorn
     Expr symb (unsigned loc, const llvm::Value &inst);
     Expr eval (unsigned loc, const llvm::Value &inst, bool complete=false);
     Expr eval (unsigned loc, Expr v, bool complete=false);
+
+    /// Evaluates a batch of values with a single call to the model.
+    /// The results are memoized, and later calls to eval() use them
+    void eval (const std::vector<Point> &pts, ExprVector &out,
+               bool complete=false);
+    /// Evaluates every instruction at a location
+    void evalLoc (unsigned loc, bool complete=false);
+    /// Evaluates every instruction on the trace
+    void evalAll (bool complete=false);
+
     template <typename Out> Out &print (Out &out);
     friend class BmcEngine;
   };
@@ -144,7 +174,8 @@ namespace seahorn
   Out &BmcTrace::print (Out &out) 
   {
     using namespace llvm;
-    
+
+    evalAll ();
     for (unsigned loc = 0; loc < size (); ++loc)
     {
       const BasicBlock &BB = *bb(loc);
@@ -0,0 +1,43 @@
+#ifndef _CEX_REPLAY__HH_
+#define _CEX_REPLAY__HH_
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "seahorn/Bmc.hh"
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  enum ReplayResult
+  {
+    /// -- execution reached an error
+    REPLAY_REACHED,
+    /// -- main returned, or the program exited, without an error
+    REPLAY_NOT_REACHED,
+    /// -- an assumption did not hold on the replayed values
+    REPLAY_ASSUME_FAILED,
+    REPLAY_TIMEOUT,
+    /// -- the program crashed (e.g., through a pointer of the harness)
+    REPLAY_CRASHED,
+    /// -- the program could not be linked or compiled
+    REPLAY_ERROR
+  };
+
+  /**
+   * Replays a counterexample natively.
+   *
+   * The harness of the trace is linked with a copy of M (without
+   * shadow memory), compiled with MCJIT and main is run. Execution
+   * happens in a forked child so that a crash, a call to exit() or a
+   * timeout of the program does not affect seahorn.
+   */
+  ReplayResult replayCex (const Module &M, BmcTrace &trace,
+                          const DataLayout &dl, const TargetLibraryInfo &tli,
+                          unsigned timeout);
+
+  const char *replayResultStr (ReplayResult r);
+}
+
+#endif
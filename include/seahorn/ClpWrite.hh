@@ -4,6 +4,7 @@
 #include <vector>
 #include "seahorn/HornClauseDB.hh"
 #include "ufo/Expr.hpp"
+#include "llvm/Support/raw_ostream.h"
 
 namespace seahorn
 {
@@ -38,21 +39,37 @@ namespace seahorn
       bool isFact () const { return !m_body; }
       
       void normalize ();
+
+      Expr head () const { return m_head; }
+      Expr body () const { return m_body; }
       
-      void print (ostream &o) const;
+      void print (raw_ostream &o) const;
     };
     
    private:
 
+    HornClauseDB &m_db;
     const HornClauseDB::expr_set_type &m_rels;
-    vector<ClpRule> m_rules;
     ExprFactory &m_efac;
 
+    /// -- constraints shared by several conjuncts or rules, mapped to
+    /// -- the application of the auxiliary predicate that defines them
+    ExprMap m_aux;
+    unsigned m_auxCount;
+
+    /// -- defines shared sub-formulas of body as auxiliary predicates
+    /// -- (printed to o) and returns body with them replaced
+    Expr shareSubterms (Expr body, raw_ostream &o);
+    void write (ClpRule &rule, raw_ostream &o);
+
    public:
 
     ClpWrite (HornClauseDB &db, ExprFactory &efac);
 
-    string toString () const;
+    /// Normalizes and prints the rules one at a time to o
+    void write (raw_ostream &o);
+
+    string toString ();
   };
 }
 
@@ -2,6 +2,7 @@
 #define GUESS_CANDIDATES__HH_
 
 #include "seahorn/HornifyModule.hh"
+#include "seahorn/HornSampler.hh"
 
 #include "ufo/Expr.hpp"
 #include "ufo/Smt/Z3n.hpp"
@@ -19,6 +20,44 @@ namespace seahorn
                                               const std::string &filepath);
   void parseLemmasFromExpFile(Expr bvar, ExprVector& lemmas,
                               const std::string &filepath);
+
+  /**
+   * Candidates from templates over the integer arguments of a
+   * relation: intervals (x <= c, x >= c), equalities (x = c, x = y)
+   * and octagons (+-x +-y <= c). Constants are mined from the rules.
+   *
+   * Reachable states (from HornSampler or
+   * Houdini::generatePositiveWitness) are kept in columns, one per
+   * argument. A candidate violated by a
+   * state never reaches the solver, and of the bounds that hold in
+   * all states only the tightest is kept.
+   */
+  class TemplateCands
+  {
+  public:
+    /// -- integer arguments of a relation in the known states
+    typedef StateSamples Samples;
+
+  private:
+    HornClauseDB &m_db;
+    std::vector<mpz_class> m_consts;
+    std::map<Expr, Samples> m_samples;
+
+    Samples &samples (Expr fdecl);
+
+  public:
+    TemplateCands (HornClauseDB &db);
+
+    /// adds a reachable state: an application of a relation to values
+    void addState (Expr state);
+
+    /// adds the simulated states of a relation
+    void addSamples (Expr fdecl, const StateSamples &s);
+
+    /// candidates of every relation, over its bound variables. A
+    /// relation without candidates gets true
+    void candidates (std::map<Expr, ExprVector> &out);
+  };
 }
 
 #endif
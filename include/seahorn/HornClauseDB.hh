@@ -218,6 +218,10 @@ namespace seahorn
     
     /// Returns the current constraints for the predicate
     Expr getConstraints (Expr pred) const;
+
+    /// Constraints of every relation, over its bound variables
+    const std::map<Expr, ExprVector> &getConstraintMap () const
+    {return m_constraints;}
     
 
     raw_ostream& write (raw_ostream& o) const;
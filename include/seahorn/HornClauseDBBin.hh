@@ -0,0 +1,51 @@
+#ifndef _HORN_CLAUSE_DB_BIN__H_
+#define _HORN_CLAUSE_DB_BIN__H_
+
+/// Binary format of a HornClauseDB
+
+#include "seahorn/HornClauseDB.hh"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <string>
+
+namespace seahorn
+{
+  typedef llvm::DenseMap<const llvm::BasicBlock*, Expr> BbPredMap;
+
+  /**
+   * A versioned binary image of a HornClauseDB: relations, rules,
+   * queries and constraints, and the predicates of the basic blocks.
+   *
+   * The hash-consed Expr DAG is written once, children before
+   * parents, and every node refers to its children by index. All
+   * fields are 32-bit little-endian words in fixed-size records, so a
+   * memory-mapped file is read in place. LLVM values (variables,
+   * blocks and functions) are written by position in their module. A
+   * file can only be loaded with the same module, which is checked
+   * with moduleFingerprint.
+   */
+
+  /// A hash of the functions and globals of M (not of its name)
+  std::string moduleFingerprint (const llvm::Module &M);
+
+  /// Writes db. Returns false, with a reason in err, if some
+  /// expression cannot be written
+  bool writeHornClauseDB (const HornClauseDB &db, const BbPredMap &bbPreds,
+                          const llvm::Module &M, const std::string &fingerprint,
+                          raw_ostream &out, std::string &err);
+
+  /// true if buf is a DB of this version written for fingerprint
+  bool matchesHornClauseDB (const llvm::MemoryBuffer &buf,
+                            const std::string &fingerprint);
+
+  /// Loads a DB written by writeHornClauseDB into an empty db. Nothing
+  /// is added to db or bbPreds unless the whole file is valid
+  bool readHornClauseDB (const llvm::MemoryBuffer &buf, const llvm::Module &M,
+                         const std::string &fingerprint,
+                         HornClauseDB &db, BbPredMap &bbPreds, std::string &err);
+}
+
+#endif
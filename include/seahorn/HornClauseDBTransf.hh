@@ -5,10 +5,41 @@
 
 namespace seahorn
 {
+  class ArgElimHornModelConverter;
+  class SliceHornModelConverter;
+  class InlineHornModelConverter;
 
   // Ensure all horn clause heads have only variables
   void normalizeHornClauseHeads (HornClauseDB &db);
 
+  /// Simplifies the Boolean skeleton of every rule body with an
+  /// and-inverter graph. Relation applications are kept as they are.
+  /// The graphs are built with the given number of threads
+  void aigHornClauseDB (HornClauseDB &db, unsigned threads);
+
+  /// Copies db into out without the arguments of relations that are
+  /// constant on every derivation or that never constrain anything.
+  /// Iterates to a fixpoint. Relations keep their names, so rules of a
+  /// counterexample still name the original relations; the converter
+  /// maps a model of out back to db. Relations with queries or
+  /// constraints are left alone. Returns false if nothing was removed
+  bool eliminateArgs (HornClauseDB &db, HornClauseDB &out,
+                      ArgElimHornModelConverter &converter);
+
+  /// Copies into out only the relations that some query depends on
+  /// and that have a derivation, and the rules between them. Returns
+  /// false if nothing was removed
+  bool sliceHornClauseDB (HornClauseDB &db, HornClauseDB &out,
+                          SliceHornModelConverter &converter);
+
+  /// Copies db into out with every relation that has a single rule and
+  /// a single use, as the source of that use, inlined into it. A
+  /// relation is only inlined if the resulting rule is the only one
+  /// between its source and head, so that counterexamples can be
+  /// expanded back. Returns false if nothing was inlined
+  bool inlineHornClauseDB (HornClauseDB &db, HornClauseDB &out,
+                           InlineHornModelConverter &converter);
+
 }
 
 
@@ -16,8 +16,99 @@ namespace seahorn
   public:
     // converts a model from one database to another. returns false on failure.
     virtual bool convert (HornDbModel &in, HornDbModel &out) = 0;
+    // converts the rules of a counterexample of one database (as
+    // returned by ZFixedPoint::getCexRules) to rules of the other
+    virtual void convertCex (ExprVector &rules) {}
     virtual ~HornModelConverter() {}
   };
+
+  /// Maps a model of a database in which relations lost some of their
+  /// arguments (see eliminateArgs) back to the original relations
+  class ArgElimHornModelConverter : public HornModelConverter
+  {
+  public:
+    struct ArgMap
+    {
+      /// -- relation of the original database
+      Expr orig;
+      /// -- for every original argument, its position in the new
+      /// -- relation, or -1 if it was removed
+      std::vector<int> pos;
+      /// -- value of a removed argument, or null if it was unconstrained
+      ExprVector vals;
+    };
+
+  private:
+    /// -- by relation of the new database
+    std::map<Expr, ArgMap> m_args;
+    HornClauseDB *m_db;
+
+  public:
+    ArgElimHornModelConverter () : m_db (nullptr) {}
+    virtual ~ArgElimHornModelConverter () {}
+
+    std::map<Expr, ArgMap> &getArgMaps () {return m_args;}
+    void setNewDB (HornClauseDB &db) {m_db = &db;}
+    bool convert (HornDbModel &in, HornDbModel &out);
+  };
+
+  /// Maps a model of a sliced database (see sliceHornClauseDB) back.
+  /// Removed relations without a derivation are false, the others are
+  /// not needed by any query and are true
+  class SliceHornModelConverter : public HornModelConverter
+  {
+    /// -- removed relations and their definitions
+    ExprMap m_removed;
+    HornClauseDB *m_db;
+
+  public:
+    SliceHornModelConverter () : m_db (nullptr) {}
+    virtual ~SliceHornModelConverter () {}
+
+    void addRemoved (Expr rel, Expr def) {m_removed [rel] = def;}
+    void setNewDB (HornClauseDB &db) {m_db = &db;}
+    bool convert (HornDbModel &in, HornDbModel &out);
+  };
+
+  /// Maps a model and counterexamples of a database with inlined
+  /// relations (see inlineHornClauseDB) back. An inlined relation is
+  /// defined as the projection of the body of its only rule, computed
+  /// by quantifier elimination. Rules of a counterexample that skip
+  /// inlined relations are expanded into a chain through them
+  class InlineHornModelConverter : public HornModelConverter
+  {
+  public:
+    typedef std::pair<Expr, Expr> Key;
+
+  private:
+    struct Inlined
+    {
+      Expr rel;
+      ExprVector vars;
+      Expr head;
+      ExprVector apps;
+      ExprVector constraints;
+    };
+
+    /// -- in the order they were inlined
+    std::vector<Inlined> m_inlined;
+    /// -- (name of the first relation of the body or null, name of the
+    /// -- head) of a rule to the relations it skips
+    std::map<Key, ExprVector> m_paths;
+    EZ3 &m_zctx;
+    HornClauseDB *m_db;
+
+  public:
+    InlineHornModelConverter (EZ3 &zctx) : m_zctx (zctx), m_db (nullptr) {}
+    virtual ~InlineHornModelConverter () {}
+
+    void addInlined (Expr rel, const ExprVector &vars, Expr head,
+                     const ExprVector &apps, const ExprVector &constraints);
+    void addPath (const Key &k, const ExprVector &rels) {m_paths [k] = rels;}
+    void setNewDB (HornClauseDB &db) {m_db = &db;}
+    bool convert (HornDbModel &in, HornDbModel &out);
+    void convertCex (ExprVector &rules);
+  };
 }
 
 #endif
@@ -0,0 +1,107 @@
+#ifndef HORN_SAMPLER__HH_
+#define HORN_SAMPLER__HH_
+
+#include "seahorn/HornClauseDB.hh"
+
+#include "ufo/Expr.hpp"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace seahorn
+{
+  using namespace expr;
+
+  /// Reachable states of a relation, one column per integer argument:
+  /// cols[i][n] is argument args[i] of the n-th state
+  struct StateSamples
+  {
+    std::vector<unsigned> args;
+    std::vector<std::vector<long> > cols;
+    size_t size () const { return cols.empty () ? 0 : cols [0].size (); }
+  };
+
+  namespace sampler
+  {
+    struct ArrayVal;
+
+    /// A concrete value: a Boolean (num is 0 or 1), an integer, a
+    /// bit-vector of a given width (0 <= num < 2^width) or an array
+    struct Val
+    {
+      enum Kind {BOOL, INT, BV, ARRAY};
+      Kind kind;
+      mpz_class num;
+      unsigned width;
+      std::shared_ptr<const ArrayVal> arr;
+
+      Val () : kind (BOOL), width (0) {}
+
+      bool operator< (const Val &o) const;
+      bool operator== (const Val &o) const;
+      bool operator!= (const Val &o) const { return !(*this == o); }
+    };
+
+    /// An array is a default value and the indices that differ from
+    /// it, so equal arrays have equal representations
+    struct ArrayVal
+    {
+      Val def;
+      std::map<mpz_class, Val> elems;
+    };
+
+    typedef std::vector<Val> State;
+  }
+
+  /**
+   * Concrete forward simulation of a Horn clause database.
+   *
+   * Starting from the facts, a rule fires on known states of the
+   * relations in its body. Variables that nothing determines (nondet
+   * values) get random values: small integers and the constants of
+   * the rules. A constraint x = e with e known assigns x, the others
+   * are checked once all their variables are known. Terms are
+   * evaluated natively, without a solver, so a rule fires in
+   * microseconds and a relation collects hundreds of states.
+   *
+   * Every state is reachable. A candidate invariant that a state
+   * violates is not an invariant.
+   */
+  class HornSampler
+  {
+    HornClauseDB &m_db;
+    std::mt19937 m_rng;
+    std::vector<mpz_class> m_consts;
+
+    std::map<Expr, std::vector<sampler::State> > m_states;
+    std::map<Expr, std::set<sampler::State> > m_known;
+    std::map<Expr, StateSamples> m_samples;
+
+    StateSamples &columns (Expr fdecl);
+    bool addState (Expr fdecl, const sampler::State &s);
+    bool fire (const HornRule &r, const ExprVector &apps,
+               const ExprVector &conds, bool &unsupported);
+    sampler::Val random (Expr ty, bool &ok);
+
+  public:
+    HornSampler (HornClauseDB &db, unsigned seed = 0);
+
+    /// simulates until every relation has enough states or no rule
+    /// finds new ones
+    void run ();
+
+    size_t numStates (Expr fdecl) const;
+
+    /// integer arguments of the states of a relation
+    const StateSamples &samples (Expr fdecl);
+
+    /// true if some state of fdecl violates cand, a formula over the
+    /// bound variables of fdecl
+    bool refutes (Expr fdecl, Expr cand);
+  };
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "llvm/IR/Module.h"
 #include "boost/logic/tribool.hpp"
 #include "seahorn/HornDbModel.hh"
+#include "seahorn/HornModelConverter.hh"
 
 #include "ufo/Smt/EZ3.hh"
 
@@ -16,7 +17,16 @@ namespace seahorn
   {
     boost::tribool m_result;
     std::unique_ptr<ufo::ZFixedPoint <ufo::EZ3> >  m_fp;
+    /// -- databases derived from the one of HornifyModule, in order.
+    /// -- The last one is solved
+    std::vector<std::unique_ptr<HornClauseDB> > m_dbs;
+    /// -- maps a model of m_dbs[i] back to the database before it
+    std::vector<std::unique_ptr<HornModelConverter> > m_converters;
     
+    HornClauseDB *addStage (std::unique_ptr<HornClauseDB> &db,
+                            HornModelConverter *converter);
+    /// model of db, the database of HornifyModule
+    void getModel (HornClauseDB &db, HornDbModel &model);
     void printCex ();
     void estimateSizeInvars (Module &M);
 
@@ -35,7 +45,14 @@ namespace seahorn
     ufo::ZFixedPoint<ufo::EZ3>& getZFixedPoint () {return *m_fp;}
     
     boost::tribool getResult () {return m_result;}
-    void releaseMemory () {m_fp.reset (nullptr);}
+    /// rules of the counterexample over the database of HornifyModule
+    void getCexRules (ExprVector &rules);
+    void releaseMemory ()
+    {
+      m_fp.reset (nullptr);
+      m_converters.clear ();
+      m_dbs.clear ();
+    }
     
   };
 
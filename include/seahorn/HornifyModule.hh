@@ -38,6 +38,11 @@ namespace seahorn
     
     LiveSymbolsMap m_ls;
     PredDeclMap m_bbPreds;
+    /// -- blocks that --horn-interval-prune found to be dead
+    DenseSet<const BasicBlock*> m_dead;
+
+    /// -- loads the DB of --horn-resume-db instead of hornifying M
+    bool resumeDb (Module &M, const std::string &fingerprint);
     
   public:
     static char ID;
@@ -63,6 +68,10 @@ namespace seahorn
     {assert (bb != NULL); return live (*bb);}
     bool hasBbPredicate (const BasicBlock &BB) const
     {return m_bbPreds.count (&BB);} 
+    /// -- true if BB needs no predicate since no execution through it
+    /// -- reaches the exit
+    bool isDeadBb (const BasicBlock &BB) const
+    {return m_dead.count (&BB) > 0;}
     /// -- predicate declaration for the given basic block
     const Expr bbPredicate (const BasicBlock &bb);
     /// --- BasicBlock corresponding to the predicate
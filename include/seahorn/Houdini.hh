@@ -49,10 +49,14 @@ namespace seahorn
 
       void guessCandidates(HornClauseDB &db);
 
-      //Functions for generating Positive Examples
+      //Reachable states that filter template candidates
+      void sampleStates(TemplateCands &tc);
+
+      //Functions for generating Positive Examples. A state is an
+      //application of a relation to values
       void generatePositiveWitness(std::map<Expr, ExprVector> &relationToPositiveStateMap);
-      void getReachableStates(std::map<Expr, ExprVector> &relationToPositiveStateMap, Expr from_pred, Expr from_pred_state);
-      void getRuleHeadState(std::map<Expr, ExprVector> &relationToPositiveStateMap, HornRule r, Expr from_pred_state);
+      void getReachableStates(std::map<Expr, ExprVector> &relationToPositiveStateMap, Expr from_state, std::list<Expr> &frontier, ZSolver<EZ3> &solver);
+      Expr getRuleHeadState(HornRule r, Expr from_pred_state, ZSolver<EZ3> &solver);
 
       //Add Houdini invs to default solver
       void addInvarCandsToProgramSolver();
@@ -0,0 +1,35 @@
+#ifndef _INC_CHECKER__HH_
+#define _INC_CHECKER__HH_
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Module.h"
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  /*
+   * Inconsistency checker for the encoding produced by
+   * IncSmallHornifyFunction (--horn-step=incsmall).
+   *
+   * For every function, repeatedly asks whether the exit is reachable
+   * with a combination of crumb flags that has not been seen
+   * yet. Blocks whose flag is never set on any path are reported as
+   * infeasible. Functions are checked in parallel, each one on its
+   * own expression factory and Z3 context.
+   */
+  class IncChecker : public llvm::ModulePass
+  {
+  public:
+    static char ID;
+
+    IncChecker () : ModulePass (ID) {}
+    virtual ~IncChecker () {}
+
+    virtual bool runOnModule (Module &M);
+    virtual void getAnalysisUsage (AnalysisUsage &AU) const;
+    virtual const char* getPassName () const {return "IncChecker";}
+  };
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef __INTERVAL_PRUNE_HH_
+#define __INTERVAL_PRUNE_HH_
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/IR/Function.h"
+
+#include "ufo/Expr.hpp"
+#include "seahorn/SymExec.hh"
+#include "seahorn/Analysis/CutPointGraph.hh"
+
+#include <gmpxx.h>
+#include <vector>
+
+namespace seahorn
+{
+  using namespace expr;
+
+  /**
+   * A cheap analysis of a function that runs before it is hornified.
+   *
+   * A forward interval analysis of the integer registers, with the
+   * semantics of UfoSmallSymExec (unbounded integers), finds blocks
+   * that no execution reaches. Branch conditions and assumptions
+   * refine the intervals, and the cut-points are the widening points.
+   * A backward pass then finds the blocks that cannot reach the exit
+   * of the function. A block of either kind needs no predicate.
+   *
+   * Only sound for functions whose error flag is always false, since
+   * with the error flag on the encoding ignores branch conditions and
+   * assumptions.
+   */
+  class IntervalPrune
+  {
+  public:
+    /// an interval of integers, possibly unbounded on either side
+    struct Interval
+    {
+      bool hasLo;
+      bool hasHi;
+      mpz_class lo;
+      mpz_class hi;
+
+      Interval () : hasLo (false), hasHi (false) {}
+      static Interval point (const mpz_class &v);
+      bool isTop () const {return !hasLo && !hasHi;}
+      bool isPoint () const {return hasLo && hasHi && lo == hi;}
+      bool operator== (const Interval &o) const;
+      bool operator!= (const Interval &o) const {return !(*this == o);}
+    };
+    typedef llvm::DenseMap<const llvm::Value*, Interval> Env;
+
+  private:
+    /// abstract state at a program point. A register that is not in
+    /// env can have any value
+    struct State
+    {
+      bool bot;
+      Env env;
+      State () : bot (true) {}
+      bool operator== (const State &o) const;
+    };
+
+    const llvm::Function &m_fn;
+    const CutPointGraph &m_cpg;
+    SmallStepSymExec &m_sem;
+
+    /// -- blocks reachable from the entry, in reverse post-order
+    std::vector<const llvm::BasicBlock*> m_order;
+    /// -- number of times the state of a cut-point was updated
+    llvm::DenseMap<const llvm::BasicBlock*, unsigned> m_visits;
+    /// -- state at the entry of a block, after its PHI nodes
+    llvm::DenseMap<const llvm::BasicBlock*, State> m_in;
+    /// -- state at the end of a block
+    llvm::DenseMap<const llvm::BasicBlock*, State> m_out;
+    llvm::DenseSet<const llvm::BasicBlock*> m_dead;
+
+    bool isInt (const llvm::Value &v) const;
+    Interval eval (const Env &env, const llvm::Value &v) const;
+    void set (Env &env, const llvm::Value &v, const Interval &i) const;
+    bool refine (Env &env, const llvm::Value &cond, bool truth, unsigned depth = 0) const;
+    void exec (const llvm::Instruction &I, State &st) const;
+    State edge (const llvm::BasicBlock &src, const llvm::BasicBlock &dst) const;
+    bool iterate (bool widen);
+
+  public:
+    IntervalPrune (const llvm::Function &F, const CutPointGraph &cpg,
+                   SmallStepSymExec &sem) :
+      m_fn (F), m_cpg (cpg), m_sem (sem) {}
+
+    /// false if the analysis gave up
+    bool run ();
+
+    /// true if bb is not reached or cannot reach the exit. The exit
+    /// is never dead
+    bool isDead (const llvm::BasicBlock &bb) const {return m_dead.count (&bb) > 0;}
+
+    /// the bounds of the integer registers in live that hold at the
+    /// entry of bb
+    Expr invariant (const llvm::BasicBlock &bb, const ExprVector &live,
+                    ExprFactory &efac) const;
+  };
+}
+
+#endif
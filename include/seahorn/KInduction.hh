@@ -0,0 +1,121 @@
+#ifndef __K_INDUCTION__HH_
+#define __K_INDUCTION__HH_
+
+#include "boost/logic/tribool.hpp"
+
+#include "ufo/Expr.hpp"
+#include "ufo/Smt/EZ3.hh"
+
+#include "seahorn/Analysis/CutPointGraph.hh"
+#include "seahorn/SymExec.hh"
+#include "seahorn/SymStore.hh"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace seahorn
+{
+  using namespace expr;
+
+  /**
+   * Unrolls the cut-point graph of a function as a transition system
+   * whose state is the current cut-point and the symbolic store.
+   *
+   * Every step executes all the edges of the graph, each with
+   * UfoLargeSymExec::execCpEdg on its own copy of the store, guarded
+   * by a literal that says that the edge is taken. The copies are
+   * joined at the cut-points: a value that is the same on every edge
+   * is kept, otherwise it is replaced by a fresh constant equal to the
+   * value of the edge that is taken. At most one edge is taken per
+   * step.
+   */
+  class CpgUnroller
+  {
+    SmallStepSymExec &m_sem;
+    ExprFactory &m_efac;
+    const CutPointGraph &m_cpg;
+    unsigned m_numCps;
+
+    /// store after the last step
+    SymStore m_store;
+    /// m_at [i][c] is true iff the state after step i is at cut-point c
+    std::vector<ExprVector> m_at;
+
+    Expr literal (const std::string &name, unsigned step, unsigned idx);
+    void atMostOne (const ExprVector &lits, const std::string &name,
+                    unsigned step, ExprVector &out);
+
+  public:
+    CpgUnroller (SmallStepSymExec &sem, const CutPointGraph &cpg);
+
+    /// number of steps unrolled so far
+    unsigned depth () const {return m_at.size () - 1;}
+    /// literal of cut-point cp after step
+    Expr at (unsigned step, const CutPoint &cp) const
+    {return m_at [step][cp.id ()];}
+
+    /// the state before the first step is at cp
+    void initial (const CutPoint &cp, ExprVector &out);
+    /// the state before the first step is at some cut-point
+    void anyState (ExprVector &out);
+    /// encodes one more step
+    void unroll (ExprVector &out);
+  };
+
+  /**
+   * BMC and k-induction on the cut-point graph of a function.
+   *
+   * Checks whether dst is reachable from src. The base case looks for
+   * a path of length k from src to dst, for k = 0, 1, ... The step
+   * case checks that no path of length k that does not visit dst
+   * before its end can reach dst. The property holds once the step
+   * case holds for some k and the base case has no path shorter than
+   * k. Each case deepens on its own incremental solver, and the two
+   * run on separate threads.
+   *
+   * The base and step encodings must come from different expression
+   * factories and Z3 contexts since neither is thread-safe.
+   */
+  class KInduction
+  {
+    CpgUnroller m_base;
+    CpgUnroller m_step;
+    ufo::EZ3 &m_stepCtx;
+    ufo::ZSolver<ufo::EZ3> m_baseSolver;
+    ufo::ZSolver<ufo::EZ3> m_stepSolver;
+
+    const CutPoint &m_src;
+    const CutPoint &m_dst;
+
+    /// symbolic execution is not thread-safe, only solving is parallel
+    std::mutex m_encode;
+    std::atomic<bool> m_stop;
+    /// no path of length less than m_baseDepth reaches dst
+    std::atomic<unsigned> m_baseDepth;
+    /// k of the step case that holds, 0 if none
+    std::atomic<unsigned> m_stepDepth;
+    /// length of a path to dst, if found
+    bool m_cex;
+    unsigned m_cexDepth;
+
+    void runBase (unsigned maxDepth);
+    void runStep (unsigned maxDepth);
+
+  public:
+    KInduction (SmallStepSymExec &baseSem, ufo::EZ3 &baseCtx,
+                SmallStepSymExec &stepSem, ufo::EZ3 &stepCtx,
+                const CutPoint &src, const CutPoint &dst);
+
+    /// true if dst is reachable, false if it is not, indeterminate if
+    /// maxDepth is reached or a solver fails
+    boost::tribool run (unsigned maxDepth);
+
+    /// length of the path found, or k of the induction
+    unsigned depth () const {return m_cex ? m_cexDepth : (unsigned) m_stepDepth;}
+    /// number of lengths ruled out by the base case
+    unsigned baseDepth () const {return m_baseDepth;}
+  };
+}
+
+#endif
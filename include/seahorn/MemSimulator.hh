@@ -5,6 +5,9 @@
 #include "llvm/IR/DataLayout.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 
+#include <map>
+#include <tuple>
+
 namespace seahorn
 {
   using namespace expr;
@@ -37,6 +40,10 @@ namespace seahorn
     BmcTrace &m_trace;
     ufo::ZModel<ufo::EZ3> m_model;
 
+    /// memoized values of pointers, by location, instruction, and
+    /// model completion
+    std::map<std::tuple<unsigned, const Instruction*, bool>, Expr> m_values;
+
     ufo::EZ3 &zctx () { return m_trace.engine ().zctx (); }
   public:
     MemSimulator (BmcTrace &bmc_trace,
@@ -53,6 +60,10 @@ namespace seahorn
     bool simulate ();
 
     Expr eval (unsigned loc, const llvm::Instruction &inst, bool complete=false);
+    /// Evaluates a batch of values with one call to each model. The
+    /// results are memoized
+    void eval (const std::vector<BmcTrace::Point> &pts, ExprVector &out,
+               bool complete=false);
     
     const DataLayout &getDataLayout () {return m_dl;}
     const TargetLibraryInfo &getTargetLibraryInfo () {return m_tli;}
@@ -39,10 +39,13 @@ namespace seahorn
   llvm::Pass* createDevirtualizeFunctionsPass ();
   llvm::Pass* createAbstractMemoryPass ();
   llvm::Pass* createPromoteMemoryToRegisterPass ();
-  llvm::Pass* createLoadCrabPass ();
+  /// crabOpts are the Crab options on the command line, they are part
+  /// of the key of --horn-crab-cache
+  llvm::Pass* createLoadCrabPass (const std::string &crabOpts = "");
   llvm::Pass* createShadowMemDsaPass (); // llvm dsa
   llvm::Pass* createShadowMemSeaDsaPass (); // seahorn dsa
   llvm::Pass* createStripShadowMemPass ();
+  llvm::Pass* createConeOfInfluencePass ();
 
   llvm::Pass* createCutLoopsPass ();
   llvm::Pass* createMarkFnEntryPass ();
@@ -67,6 +70,7 @@ namespace seahorn
   llvm::Pass *createApiAnalysisPass(std::string &config);
 
   llvm::Pass* createBmcPass (llvm::raw_ostream* out, bool solve);
+  llvm::Pass* createKInductionPass ();
 
   llvm::Pass* createProfilerPass();
   llvm::Pass* createCFGPrinterPass ();
@@ -0,0 +1,38 @@
+#ifndef __LAZY_LOAD_HH_
+#define __LAZY_LOAD_HH_
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include <memory>
+#include <string>
+
+namespace seahorn
+{
+  /**
+   * Reads the input module of a tool.
+   *
+   * By default the whole file is parsed, like llvm::parseIRFile. With
+   * --lazy-load the bitcode is memory-mapped and only the bodies of
+   * the functions reachable from the entry points (--lazy-entry, main
+   * by default) are materialized. A function is reachable if a
+   * reachable body or a global initializer mentions it, so
+   * address-taken functions are kept. The other functions become
+   * declarations, as if sliced away.
+   *
+   * seahorn always hornifies from main, so only seapp is given other
+   * entry points (sea pp turns --slice-functions into --lazy-entry).
+   */
+  std::unique_ptr<llvm::Module> readModule (const std::string &filename,
+                                            llvm::SMDiagnostic &err,
+                                            llvm::LLVMContext &ctx);
+
+  /// Same as above for a module that is already in memory
+  std::unique_ptr<llvm::Module> readModule (std::unique_ptr<llvm::MemoryBuffer> buf,
+                                            llvm::SMDiagnostic &err,
+                                            llvm::LLVMContext &ctx);
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef __PASS_PIPELINE_HH_
+#define __PASS_PIPELINE_HH_
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace seahorn
+{
+  /**
+   * A sequence of passes for seapp.
+   *
+   * Without threads it behaves exactly like a legacy::PassManager.
+   * With threads, every maximal run of function-local passes (added
+   * with addLocal) is applied in parallel, while every other pass is
+   * a barrier that sees the whole module.
+   *
+   * LLVMContext is not thread-safe. Each worker therefore parses its
+   * own copy of the module from bitcode into its own context, runs the
+   * function-local passes on the functions it owns, and drops the
+   * bodies of the other functions. The results are linked back in a
+   * fixed order, and the original linkage and order of functions and
+   * globals are restored, so the output does not depend on
+   * scheduling.
+   */
+  class PassPipeline
+  {
+  public:
+    typedef std::function<llvm::Pass* ()> PassFactory;
+
+  private:
+    struct Step
+    {
+      /// -- a barrier, or null
+      llvm::Pass *pass;
+      /// -- a function-local pass
+      PassFactory local;
+    };
+
+    struct Timing
+    {
+      std::string name;
+      /// -- wall-clock time of the step
+      double wall;
+      /// -- time summed over all workers
+      double cpu;
+      bool local;
+    };
+
+    unsigned m_threads;
+    std::vector<Step> m_steps;
+    std::vector<Timing> m_times;
+
+    void runBarrier (llvm::Pass *pass, llvm::Module &M);
+    void runLocal (const std::vector<PassFactory> &passes,
+                   std::unique_ptr<llvm::Module> &M);
+
+  public:
+    /// threads == 0 runs everything through a single PassManager
+    PassPipeline (unsigned threads) : m_threads (threads) {}
+    ~PassPipeline ();
+
+    /// a pass that needs (or changes) the whole module
+    void add (llvm::Pass *pass);
+    /// a pass that only changes the function it runs on and
+    /// creates no globals other than named declarations
+    void addLocal (PassFactory factory);
+
+    /// runs the pipeline. M might be replaced by a new module
+    void run (std::unique_ptr<llvm::Module> &M);
+
+    /// time spent in every pass (only in parallel mode)
+    void printTimes (llvm::raw_ostream &out) const;
+  };
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef __RESOURCE_GOVERNOR_HH_
+#define __RESOURCE_GOVERNOR_HH_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace seahorn
+{
+  /**
+   * In-process resource governor.
+   *
+   * A phase is a named stage of the pipeline (pp, hornify, solve,
+   * cex) with its own wall-time and memory (RSS) budget, given with
+   * --sea-budget=phase:seconds[:megabytes]. While a phase is active a
+   * watchdog thread samples both. When a budget is exceeded the
+   * interrupt callbacks registered by the phase are called (e.g., to
+   * cancel Z3) so that the phase can stop early and report what it
+   * has.
+   *
+   * Phases do not nest. Stats are recorded on the main thread when a
+   * phase ends.
+   */
+  class ResourceGovernor
+  {
+  public:
+    typedef std::function<void ()> Callback;
+
+  private:
+    struct Budget
+    {
+      unsigned seconds;
+      unsigned megabytes;
+      Budget () : seconds (0), megabytes (0) {}
+    };
+
+    std::map<std::string, Budget> m_budgets;
+
+    std::string m_phase;
+    Budget m_budget;
+    std::chrono::steady_clock::time_point m_start;
+    std::atomic<bool> m_exceeded;
+    /// -- set if any phase so far has exceeded its budget
+    bool m_anyExceeded;
+    std::atomic<unsigned> m_peakRss;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop;
+    std::thread m_watchdog;
+    std::vector<Callback> m_interrupts;
+
+    ResourceGovernor ();
+    void watch ();
+
+  public:
+    static ResourceGovernor &get ();
+    ~ResourceGovernor ();
+
+    /// Sets the budget of a phase. 0 means no limit.
+    void setBudget (const std::string &phase, unsigned seconds, unsigned megabytes);
+    bool hasBudget (const std::string &phase) const
+    {return m_budgets.count (phase) > 0;}
+
+    void enter (const std::string &phase);
+    void leave ();
+
+    /// Registers a callback to run if the current phase goes over
+    /// budget. Callbacks run on the watchdog thread and are dropped
+    /// when the phase ends.
+    void onInterrupt (Callback fn);
+
+    /// true if the current (or last) phase went over budget
+    bool exceeded () const {return m_exceeded;}
+    bool anyExceeded () const {return m_anyExceeded;}
+    /// forgets that phases went over budget, e.g., between the
+    /// requests of seahorn --server. Not inside a phase
+    void reset ();
+
+    /// resident set size of this process in megabytes
+    static unsigned currentRss ();
+  };
+
+  /// Runs a phase for the lifetime of the object
+  class ScopedPhase
+  {
+  public:
+    ScopedPhase (const std::string &phase)
+    {ResourceGovernor::get ().enter (phase);}
+    ~ScopedPhase () {ResourceGovernor::get ().leave ();}
+  };
+}
+
+#endif
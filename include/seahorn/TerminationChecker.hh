@@ -0,0 +1,43 @@
+#ifndef _TERMINATION_CHECKER__HH_
+#define _TERMINATION_CHECKER__HH_
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Module.h"
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  /*
+   * Termination analysis over the HornClauseDB built by HornifyModule.
+   *
+   * Loops are the non-trivial strongly connected components of the
+   * CutPointGraph of each function. For every loop, a lexicographic
+   * linear ranking function is synthesized over the integer arguments
+   * of the predicates in the loop: each component is bounded and
+   * strictly decreasing on some transitions and non-increasing on the
+   * rest; decreasing transitions are removed until no cycle is left.
+   * Components are found by counterexample-guided synthesis with one
+   * incremental solver for the coefficients and one per transition
+   * for validation.
+   *
+   * Transitions are split into the paths of the loop they merge, and
+   * checked in isolation, strengthened only by the constraints already
+   * in the database (e.g., --horn-crab).
+   * Loops are checked in parallel.
+   */
+  class TerminationChecker : public llvm::ModulePass
+  {
+  public:
+    static char ID;
+
+    TerminationChecker () : ModulePass (ID) {}
+    virtual ~TerminationChecker () {}
+
+    virtual bool runOnModule (Module &M);
+    virtual void getAnalysisUsage (AnalysisUsage &AU) const;
+    virtual const char* getPassName () const {return "TerminationChecker";}
+  };
+}
+
+#endif
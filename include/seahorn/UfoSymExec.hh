@@ -3,10 +3,13 @@
 
 #include "llvm/Pass.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/DataLayout.h"
 #include "seahorn/SymExec.hh"
 #include "seahorn/Analysis/CanFail.hh"
 
+#include <map>
+
 namespace seahorn
 {
   /// Small step symbolic execution for integers based on UFO semantics
@@ -17,11 +20,32 @@ namespace seahorn
 
   public:    
     typedef SmallPtrSet<const Function *, 8> FunctionPtrSet;
+
+    /// A memory region all of whose accesses go to known offsets of a
+    /// single object. Each cell of the region is encoded by a scalar
+    /// instead of the region being an array
+    struct MemRegion
+    {
+      /// -- the object (a global or a static alloca)
+      const Value *base;
+      /// -- offset and store size of every cell
+      std::map<int64_t, unsigned> cells;
+      /// -- initial contents if the region is never written, or null
+      const Constant *init;
+      MemRegion () : base (nullptr), init (nullptr) {}
+    };
     
   private:
     FunctionPtrSet m_abs_funcs;
     const DataLayout *m_td;
     const CanFail *m_canFail;
+
+    /// -- split regions of a function, by shadow id
+    std::map<const Function*, std::map<int64_t, MemRegion> > m_regions;
+    /// -- region of a shadow value, or null if it is not split
+    DenseMap<const Value*, const MemRegion*> m_shadowRegion;
+
+    void splitRegions (const Function &F);
         
   public:
     UfoSmallSymExec (ExprFactory &efac, Pass &pass, const DataLayout &dl,
@@ -32,6 +56,7 @@ namespace seahorn
     {
       m_canFail = pass.getAnalysisIfAvailable<CanFail> ();
     }
+    /// split regions are recomputed on demand by the copy
     UfoSmallSymExec (const UfoSmallSymExec& o) : 
       SmallStepSymExec (o), m_pass (o.m_pass),
       m_trackLvl (o.m_trackLvl), m_abs_funcs (o.m_abs_funcs),
@@ -67,6 +92,15 @@ namespace seahorn
                    SmallVectorImpl<const Type *> &ts);
     unsigned storageSize (const llvm::Type *t);
     unsigned fieldOff (const StructType *t, unsigned field);
+
+    /// The region of a shadow value if it is split into cells
+    const MemRegion *splitRegion (const Value &shadow);
+    /// offset of a pointer into the base of its split region
+    int64_t cellOffset (const Value &ptr);
+    /// the cell at a given offset of a version of a split region
+    Expr cell (const Value &shadow, int64_t off);
+    /// the initial value of a cell of a read-only region, if known
+    Expr cellInit (const MemRegion &r, int64_t off);
   }; 
   
 
@@ -35,6 +35,7 @@ DM-0002198
 #include <unordered_map>
 #include <memory>
 #include <array>
+#include <cstdint>
 
 #include <gmpxx.h>
 
@@ -1095,9 +1096,12 @@ namespace expr
   public:
 
     // skipKids or doKids
-    VisitAction (bool kids = false) : 
-      _skipKids (kids), fn (new ExprFunctionoid<IdentityRewriter> 
-                            (std::make_shared<IdentityRewriter> ())) {}
+    VisitAction (bool kids = false) : _skipKids (kids) {}
+
+    // changeTo or doKids without a rewriter
+    VisitAction (Expr e, bool kids) : _skipKids (kids), expr (e) {}
+    VisitAction (Expr e, bool kids, std::shared_ptr<IdentityRewriter>) :
+      _skipKids (kids), expr (e) {}
     
     // changeTo or doKidsRewrite
     template <typename R>
@@ -1110,17 +1114,17 @@ namespace expr
     bool isDoKids () { return !_skipKids && expr.get () == NULL; }
     bool isChangeDoKidsRewrite () { return !_skipKids && expr.get () != NULL; }
 
-    Expr rewrite (Expr v) { return fn->apply (v); }
+    Expr rewrite (Expr v) { return fn ? fn->apply (v) : v; }
 
     Expr getExpr () { return expr; }
 
     static inline VisitAction skipKids () { return VisitAction (true); }
     static inline VisitAction doKids () { return VisitAction (false); }
     static inline VisitAction changeTo (Expr e) 
-    { return VisitAction (e, true, std::make_shared<IdentityRewriter> ());}
+    { return VisitAction (e, true);}
     
     static inline VisitAction changeDoKids (Expr e) 
-    { return VisitAction (e, false, std::make_shared<IdentityRewriter> ());}
+    { return VisitAction (e, false);}
     
     template <typename R> 
     static inline VisitAction changeDoKidsRewrite (Expr e, std::shared_ptr<R> r) 
@@ -1130,71 +1134,102 @@ namespace expr
     bool _skipKids;
     Expr expr;
   private:
+    /// -- null for the identity
     std::shared_ptr<ExprFn> fn;
   };
 
 
-  typedef std::unordered_map<ENode*,Expr> DagVisitCache;
-
-  template <typename ExprVisitor> 
-  Expr visit (ExprVisitor &v, Expr expr, DagVisitCache &cache)
+  /**
+   * Cache of a DAG visit. Maps a visited node to its result.
+   *
+   * A flat, open-addressing table of indices into a vector of
+   * entries, kept in insertion order. clear () is linear in the
+   * number of entries (not in the capacity) and keeps the memory, so
+   * that a cache can be reused across visits.
+   */
+  class DagVisitCache
   {
-    if (!expr) return expr;
-    
-    if (expr->use_count () > 1)
-      {
-	DagVisitCache::const_iterator cit 
-	  = cache.find (&*expr);
-	if (cit != cache.end ()) return cit->second;
-      }
-    
-    
-    VisitAction va = v(expr);
-    Expr res;
+  public:
+    typedef std::pair<ENode*,Expr> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
 
-    if (va.isSkipKids ())
-      res = expr;
-    else if (va.isChangeTo ())
-      res = va.getExpr ();
-    else
-      {
-	res = va.isChangeDoKidsRewrite () ? va.getExpr () : expr;
-	if (res->arity () > 0) 
-	  {
-	    bool changed = false;
-            std::vector<Expr> kids;
+  private:
+    enum : unsigned { EMPTY = ~0U };
 
-	    for (ENode::args_iterator b = res->args_begin (), 
-		   e = res->args_end (); 
-		 b != e; ++b)
-	      {
-		Expr k = visit (v, *b, cache);
-		kids.push_back (k);
-		changed  = (changed || k.get () != *b);
-	      }
-	    
-	    if (changed)
-	      {
-		if (!res->isMutable ())
-		  res = res->getFactory ().mkNary (res->op (),
-						   kids.begin (),
-						   kids.end ());
-		else
-		  res->renew_args (kids.begin (), kids.end ());
-	      }
-	  }
-    
-	res = va.rewrite (res);
-      }
+    std::vector<value_type> m_entries;
+    std::vector<unsigned> m_slots;
+
+    static size_t hash (const ENode *n)
+    {
+      uint64_t h = reinterpret_cast<uintptr_t> (n);
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    /// slot of n, or the empty slot where it goes
+    size_t slot (const ENode *n) const
+    {
+      size_t mask = m_slots.size () - 1;
+      for (size_t i = hash (n) & mask; ; i = (i + 1) & mask)
+        if (m_slots [i] == EMPTY || m_entries [m_slots [i]].first == n)
+          return i;
+    }
+
+    void grow ()
+    {
+      m_slots.assign (m_slots.empty () ? 64 : 2 * m_slots.size (), EMPTY);
+      for (unsigned i = 0, sz = m_entries.size (); i < sz; ++i)
+        m_slots [slot (m_entries [i].first)] = i;
+    }
+
+  public:
+    iterator begin () { return m_entries.begin (); }
+    iterator end () { return m_entries.end (); }
+    const_iterator begin () const { return m_entries.begin (); }
+    const_iterator end () const { return m_entries.end (); }
+    size_t size () const { return m_entries.size (); }
+    size_t capacity () const { return m_slots.size (); }
+    bool empty () const { return m_entries.empty (); }
+
+    iterator find (const ENode *n)
+    {
+      if (m_entries.empty ()) return end ();
+      unsigned idx = m_slots [slot (n)];
+      return idx == EMPTY ? end () : begin () + idx;
+    }
 
-    if (expr->use_count () > 1)
+    Expr &operator[] (ENode *n)
+    {
+      // -- keep the load below 3/4
+      if (4 * (m_entries.size () + 1) > 3 * m_slots.size ()) grow ();
+      size_t s = slot (n);
+      if (m_slots [s] == EMPTY)
       {
-	expr->Ref ();
-	cache[&*expr] = res;
+        m_slots [s] = m_entries.size ();
+        m_entries.push_back (value_type (n, Expr ()));
       }
-    
-    return res;
-  }  
+      return m_entries [m_slots [s]].second;
+    }
+
+    void clear ()
+    {
+      // -- the probe sequence of an entry only goes through the
+      // -- slots of older entries. Remove the newest first
+      for (auto it = m_entries.rbegin (), end = m_entries.rend (); it != end; ++it)
+        m_slots [slot (it->first)] = EMPTY;
+      m_entries.clear ();
+    }
+
+    /// clears the cache and releases its memory
+    void reset ()
+    {
+      std::vector<value_type> ().swap (m_entries);
+      std::vector<unsigned> ().swap (m_slots);
+    }
+  };
 
   inline void clearDagVisitCache (DagVisitCache &cache)
   {
@@ -1203,18 +1238,201 @@ namespace expr
     cache.clear ();
   }
 
+  namespace details
+  {
+    /// a node whose kids are being visited
+    struct VisitFrame
+    {
+      /// -- the visited node
+      Expr expr;
+      /// -- the node whose kids are visited
+      Expr res;
+      VisitAction va;
+      /// -- next kid to visit
+      unsigned next;
+      /// -- results of the kids start here
+      size_t kids;
+    };
+
+    /**
+     * Explicit stack of expression visits on this thread. A visitor
+     * may start another visit, which then works on top of the stack.
+     * The memory is kept from one visit to the next.
+     */
+    struct VisitStack
+    {
+      std::vector<VisitFrame> frames;
+      std::vector<Expr> results;
+
+      /// restores the stack on exit, even by an exception
+      struct Scope
+      {
+        VisitStack &st;
+        size_t frames;
+        size_t results;
+        Scope (VisitStack &s) :
+          st (s), frames (s.frames.size ()), results (s.results.size ()) {}
+        ~Scope ()
+        {
+          st.frames.erase (st.frames.begin () + frames, st.frames.end ());
+          st.results.erase (st.results.begin () + results, st.results.end ());
+        }
+      };
+    };
+
+    inline VisitStack &visitStack ()
+    {
+      static thread_local VisitStack st;
+      return st;
+    }
+
+    /// caches of finished DagVisits, reused by the next ones
+    inline std::vector<std::unique_ptr<DagVisitCache> > &visitCachePool ()
+    {
+      static thread_local std::vector<std::unique_ptr<DagVisitCache> > pool;
+      return pool;
+    }
+
+    /// records the result res of the node expr
+    inline void visitDone (VisitStack &st, DagVisitCache *cache, 
+                           const Expr &expr, Expr res)
+    {
+      if (cache && expr->use_count () > 1)
+      {
+        expr->Ref ();
+        (*cache) [&*expr] = res;
+      }
+      st.results.push_back (res);
+    }
+
+    /// visits expr, or pushes a frame to visit its kids
+    template <typename ExprVisitor>
+    void visitEnter (ExprVisitor &v, VisitStack &st, DagVisitCache *cache, 
+                     const Expr &expr)
+    {
+      if (cache && expr->use_count () > 1)
+      {
+        DagVisitCache::const_iterator cit = cache->find (&*expr);
+        if (cit != cache->end ()) 
+        {
+          st.results.push_back (cit->second);
+          return;
+        }
+      }
+
+      VisitAction va = v (expr);
+      if (va.isSkipKids ()) 
+        visitDone (st, cache, expr, expr);
+      else if (va.isChangeTo ())
+        visitDone (st, cache, expr, va.getExpr ());
+      else
+      {
+        Expr res = va.isChangeDoKidsRewrite () ? va.getExpr () : expr;
+        if (res->arity () == 0)
+          visitDone (st, cache, expr, va.rewrite (res));
+        else
+        {
+          st.frames.push_back (VisitFrame ());
+          VisitFrame &f = st.frames.back ();
+          f.expr = expr;
+          f.res = res;
+          f.va = va;
+          f.next = 0;
+          f.kids = st.results.size ();
+        }
+      }
+    }
+
+    /**
+     * Iterative post-order visit of expr. Without a cache, shared
+     * sub-expressions are visited once per occurrence.
+     *
+     * References into the stack are not held across calls to the
+     * visitor, which may start another visit and grow the stack.
+     */
+    template <typename ExprVisitor>
+    Expr visit (ExprVisitor &v, Expr expr, DagVisitCache *cache)
+    {
+      if (!expr) return expr;
+
+      VisitStack &st = visitStack ();
+      VisitStack::Scope scope (st);
+
+      visitEnter (v, st, cache, expr);
+      while (st.frames.size () > scope.frames)
+      {
+        VisitFrame &f = st.frames.back ();
+        if (f.next < f.res->arity ())
+        {
+          Expr kid (f.res->arg (f.next++));
+          visitEnter (v, st, cache, kid);
+          continue;
+        }
+
+        Expr key = f.expr;
+        Expr res = f.res;
+        VisitAction va = f.va;
+        size_t kids = f.kids;
+        st.frames.pop_back ();
+
+        std::vector<Expr>::iterator b = st.results.begin () + kids;
+        bool changed = false;
+        for (unsigned i = 0, sz = res->arity (); !changed && i < sz; ++i)
+          changed = b [i].get () != res->arg (i);
+        
+        if (changed)
+        {
+          if (!res->isMutable ())
+            res = res->getFactory ().mkNary (res->op (), b, st.results.end ());
+          else
+            res->renew_args (b, st.results.end ());
+        }
+        st.results.erase (b, st.results.end ());
+        
+        visitDone (st, cache, key, va.rewrite (res));
+      }
+
+      Expr res = st.results.back ();
+      st.results.pop_back ();
+      return res;
+    }
+  }
+
+  template <typename ExprVisitor> 
+  Expr visit (ExprVisitor &v, Expr expr, DagVisitCache &cache)
+  {
+    return details::visit (v, expr, &cache);
+  }  
 
   template <typename ExprVisitor>
   struct DagVisit : public std::unary_function<Expr,Expr>
   {
     ExprVisitor &m_v;
-    DagVisitCache m_cache;
+    std::unique_ptr<DagVisitCache> m_cache;
     
-    DagVisit (ExprVisitor &v) : m_v (v) {}
-    DagVisit (const DagVisit &o) : m_v (o.m_v) {} 
-    ~DagVisit () { clearDagVisitCache (m_cache); }
+    DagVisit (ExprVisitor &v) : m_v (v) { init (); }
+    DagVisit (const DagVisit &o) : m_v (o.m_v) { init (); } 
+    ~DagVisit () 
+    { 
+      clearDagVisitCache (*m_cache); 
+      auto &pool = details::visitCachePool ();
+      // -- do not hold on to the memory of large visits
+      if (m_cache->capacity () > (1U << 16)) m_cache->reset ();
+      if (pool.size () < 8) pool.push_back (std::move (m_cache));
+    }
+
+    void init ()
+    {
+      auto &pool = details::visitCachePool ();
+      if (pool.empty ()) m_cache.reset (new DagVisitCache ());
+      else
+      {
+        m_cache = std::move (pool.back ());
+        pool.pop_back ();
+      }
+    }
     
-    Expr operator() (Expr e)  { return visit (m_v, e, m_cache); }
+    Expr operator() (Expr e)  { return visit (m_v, e, *m_cache); }
     
   };
   
@@ -1235,41 +1453,7 @@ namespace expr
   template <typename ExprVisitor>
   Expr visit (ExprVisitor &v, Expr expr)
   {
-    VisitAction va = v (expr);
-    
-    if (va.isSkipKids ()) return expr;
-
-    if (va.isChangeTo ()) return va.getExpr ();
-    
-    Expr res = va.isChangeDoKidsRewrite () ? va.getExpr () : expr;
-    
-    if (res->arity () == 0) return va.rewrite (res);
-
-    bool changed = false;
-    std::vector<Expr> kids;
-
-    for (ENode::args_iterator b = res->args_begin (), 
-	   e = res->args_end (); 
-	 b != e; ++b)
-      {
-	Expr k = visit (v, *b);
-	kids.push_back (k);
-	changed  = (changed || k.get () != *b);
-      }
-
-    if (changed)
-      {
-	if (!res->isMutable ())
-	  res = res->getFactory ().mkNary (res->op (),
-					   kids.begin (),
-					   kids.end ());
-	else
-	  res->renew_args (kids.begin (), kids.end ());
-      }
-    
-    res = va.rewrite (res);
-
-    return res;
+    return details::visit (v, expr, nullptr);
   }
 
   /**********************************************************************/
@@ -2965,6 +3149,31 @@ namespace expr
     CV cv(e2);
     dagVisit (cv, e1);
     return cv.found;
+  }
+
+  /**
+   * Copies exp into the factory efac. The cache maps nodes of the
+   * source DAG to their copies so that shared sub-expressions are
+   * copied once across multiple calls. Keys of the cache are not
+   * referenced, so it must not be released with clearDagVisitCache.
+   *
+   * ExprFactory is not thread-safe. This is the way to hand an
+   * expression over to a worker that owns its own factory.
+   */
+  inline Expr copyTo (Expr exp, ExprFactory &efac, DagVisitCache &cache)
+  {
+    DagVisitCache::const_iterator it = cache.find (&*exp);
+    if (it != cache.end ()) return it->second;
+
+    ExprVector kids;
+    kids.reserve (exp->arity ());
+    for (ENode::args_iterator b = exp->args_begin (), e = exp->args_end ();
+         b != e; ++b)
+      kids.push_back (copyTo (Expr (*b), efac, cache));
+
+    Expr res = efac.mkNary (exp->op (), kids.begin (), kids.end ());
+    cache [&*exp] = res;
+    return res;
   }  
 
 
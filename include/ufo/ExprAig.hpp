@@ -2,6 +2,10 @@
 #define _EXPR_AIG__HPP_
 #include "ufo/Expr.hpp"
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 /** a basic simplifier */
 
 namespace expr
@@ -10,6 +14,55 @@ namespace expr
   {
     namespace boolop
     {
+      /**
+       * An and-inverter graph with structural hashing.
+       *
+       * The Boolean skeleton (AND, OR, NEG, IMPL, IFF, XOR and ITE in
+       * a Boolean position) of an expression becomes a graph of
+       * two-input AND gates and negated edges. Everything else is an
+       * input. Building a graph only reads the expression: no Expr is
+       * created and no reference count changes, so graphs of
+       * different expressions can be built in parallel. Converting
+       * back needs the ExprFactory and is not thread-safe.
+       */
+      class AigGraph
+      {
+      public:
+        /// 2 * node + negated. Literals 0 and 1 are false and true
+        typedef unsigned Lit;
+
+      private:
+        struct Node
+        {
+          Lit left;
+          Lit right;
+          /// -- the expression of an input, or null for a gate
+          ENode *input;
+        };
+
+        std::vector<Node> m_nodes;
+        std::unordered_map<ENode*, Lit> m_cache;
+        std::unordered_map<ENode*, unsigned> m_inputs;
+        std::unordered_map<uint64_t, unsigned> m_gates;
+        std::unordered_map<Lit, Expr> m_exprs;
+
+        Lit mkInput (ENode *e);
+        Lit mkOr (Lit a, Lit b) { return mkAnd (a ^ 1, b ^ 1) ^ 1; }
+        bool isGate (Lit a) const { return m_nodes [a >> 1].input == nullptr && a > 1; }
+
+      public:
+        AigGraph ();
+
+        Lit mkAnd (Lit a, Lit b);
+        /// adds the Boolean skeleton of e
+        Lit build (ENode *e);
+        /// number of gates and inputs reachable from a
+        unsigned size (Lit a) const;
+        /// converts back. With gather, nested binary operators are
+        /// gathered into n-ary ones
+        Expr toExpr (Lit a, ExprFactory &efac, bool gather = false);
+      };
+
       /// aig-fy an expression and simplify it
       Expr aig (Expr e, bool gather = false);
       
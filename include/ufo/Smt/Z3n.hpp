@@ -252,13 +252,20 @@ namespace ufo
     z3::ast toAst (Expr e)
     {
       expr_ast_map seen;
-      return M::marshal (e, get_ctx (), cache.left, seen);
+      return toAst (e, seen);
     }
+    /// marshals e sharing seen with other terms of the same batch
+    z3::ast toAst (Expr e, expr_ast_map &seen)
+    { return M::marshal (e, get_ctx (), cache.left, seen); }
+
     Expr toExpr (z3::ast a)
     {
-      if (!a) return Expr();
-
       ast_expr_map seen;
+      return toExpr (a, seen);
+    }
+    Expr toExpr (z3::ast a, ast_expr_map &seen)
+    {
+      if (!a) return Expr();
       return U::unmarshal (a, get_efac (), cache.right, seen);
     }
 
@@ -292,6 +299,9 @@ namespace ufo
     template <typename V>
     void set (char const *p, V v) { ctx.set (p, v); }
 
+    /// Stops any check in progress. Safe to call from another thread
+    void interrupt () { Z3_interrupt (ctx); }
+
     std::string toSmtLib (Expr e)
     { return boost::lexical_cast<std::string> (this->toAst (e)); }
 
@@ -351,6 +361,13 @@ namespace ufo
       return Z3_get_decl_kind (ctx, fdecl) == Z3_OP_AS_ARRAY;
     }
 
+    /// true if v is a numeral, a Boolean constant or an array
+    bool isValue (const z3::ast &v)
+    {
+      return Z3_is_numeral_ast (ctx, v) ||
+        Z3_get_bool_value (ctx, v) != Z3_L_UNDEF || isAsArray (v);
+    }
+
     Expr finterpToExpr (const z3::func_interp &zfunc)
     {
       ExprVector entries;
@@ -429,6 +446,67 @@ namespace ufo
       return mk<NONDET> (efac);
     }
 
+    /// Evaluates a batch of terms with a single call to Z3, and
+    /// converts the values back sharing one cache. The terms are
+    /// wrapped as arguments of a fresh function that the model does
+    /// not interpret, so that evaluation only rewrites the
+    /// arguments. With completion, terms that are left open by the
+    /// model are completed one at a time.
+    void eval (const ExprVector &es, ExprVector &out, bool completion = false)
+    {
+      assert (model);
+      out.clear ();
+      if (es.empty ()) return;
+
+      expr_ast_map seen;
+      std::vector<z3::ast> asts;
+      std::vector<z3::sort> sorts;
+      std::vector<Z3_ast> args;
+      std::vector<Z3_sort> domain;
+      asts.reserve (es.size ());
+      sorts.reserve (es.size ());
+      for (Expr e : es)
+      {
+        asts.push_back (z3.toAst (e, seen));
+        sorts.push_back (z3::sort (ctx, Z3_get_sort (ctx, asts.back ())));
+        args.push_back (asts.back ());
+        domain.push_back (sorts.back ());
+      }
+
+      z3::func_decl batch (ctx, Z3_mk_fresh_func_decl (ctx, "batch", domain.size (),
+                                                       &domain [0],
+                                                       Z3_mk_bool_sort (ctx)));
+      z3::ast app (ctx, Z3_mk_app (ctx, batch, args.size (), &args [0]));
+      ctx.check_error ();
+
+      Z3_ast raw_val = NULL;
+      bool ok = Z3_model_eval (ctx, model, app, false, &raw_val) && raw_val;
+      z3::ast val (ctx, ok ? raw_val : static_cast<Z3_ast> (app));
+      ctx.check_error ();
+      ok = ok && val.kind () == Z3_APP_AST &&
+        Z3_get_app_decl (ctx, Z3_to_app (ctx, val)) == static_cast<Z3_func_decl> (batch) &&
+        Z3_get_app_num_args (ctx, Z3_to_app (ctx, val)) == es.size ();
+
+      ast_expr_map back;
+      for (unsigned i = 0, sz = es.size (); i < sz; ++i)
+      {
+        if (!ok) { out.push_back (eval (es [i], completion)); continue; }
+
+        z3::ast v (ctx, Z3_get_app_arg (ctx, Z3_to_app (ctx, val), i));
+        if (completion && !isValue (v))
+          out.push_back (eval (es [i], completion));
+        else if (isAsArray (v))
+        {
+          Z3_func_decl fdecl = Z3_get_as_array_func_decl (ctx, v);
+          z3::func_interp zfunc (ctx, Z3_model_get_func_interp (ctx, model, fdecl));
+          ctx.check_error ();
+          out.push_back (finterpToExpr (zfunc));
+        }
+        else
+          out.push_back (z3.toExpr (v, back));
+      }
+    }
+
     ExprFactory &getExprFactory () { return z3.getExprFactory (); }
     Expr operator() (Expr e) { return eval (e); }
 
@@ -691,6 +769,10 @@ namespace ufo
                  std::back_inserter (m_queries));
     }
 
+    /// forget all queries so that the next query() is checked alone.
+    /// Rules and lemmas learned so far are kept.
+    void resetQueries () {m_queries.clear ();}
+
     boost::tribool query (Expr q = Expr())
     {
       if (q) m_queries.push_back (q);
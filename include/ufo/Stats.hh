@@ -158,6 +158,9 @@ namespace ufo
     static void Print (std::ostream &OS);
     static void Print (llvm::raw_ostream &OS);
     static void PrintBrunch (llvm::raw_ostream &OS);
+
+    /** Forgets all statistics */
+    static void reset ();
   };
 
 
@@ -0,0 +1,155 @@
+#include "ufo/ExprAig.hpp"
+
+namespace expr
+{
+  namespace op
+  {
+    namespace boolop
+    {
+      AigGraph::AigGraph ()
+      {
+        // -- node 0 is the constant false
+        Node n;
+        n.left = n.right = 0;
+        n.input = nullptr;
+        m_nodes.push_back (n);
+      }
+
+      AigGraph::Lit AigGraph::mkInput (ENode *e)
+      {
+        auto it = m_inputs.find (e);
+        if (it != m_inputs.end ()) return 2 * it->second;
+
+        Node n;
+        n.left = n.right = 0;
+        n.input = e;
+        m_nodes.push_back (n);
+        m_inputs [e] = m_nodes.size () - 1;
+        return 2 * (m_nodes.size () - 1);
+      }
+
+      AigGraph::Lit AigGraph::mkAnd (Lit a, Lit b)
+      {
+        if (a > b) std::swap (a, b);
+
+        // -- constants and trivial cases
+        if (a == 0) return 0;
+        if (a == 1) return b;
+        if (a == b) return a;
+        if (a == (b ^ 1)) return 0;
+
+        // -- one level of lookahead: a & (a & y) and a & (!a & y)
+        for (int i = 0; i < 2; ++i)
+        {
+          Lit x = i == 0 ? a : b;
+          Lit g = i == 0 ? b : a;
+          if (!isGate (g) || (g & 1)) continue;
+          const Node &n = m_nodes [g >> 1];
+          if (n.left == x || n.right == x) return g;
+          if (n.left == (x ^ 1) || n.right == (x ^ 1)) return 0;
+        }
+
+        uint64_t key = (static_cast<uint64_t> (a) << 32) | b;
+        auto it = m_gates.find (key);
+        if (it != m_gates.end ()) return 2 * it->second;
+
+        Node n;
+        n.left = a;
+        n.right = b;
+        n.input = nullptr;
+        m_nodes.push_back (n);
+        m_gates [key] = m_nodes.size () - 1;
+        return 2 * (m_nodes.size () - 1);
+      }
+
+      AigGraph::Lit AigGraph::build (ENode *e)
+      {
+        auto it = m_cache.find (e);
+        if (it != m_cache.end ()) return it->second;
+
+        Lit res;
+        if (isOpX<TRUE> (e)) res = 1;
+        else if (isOpX<FALSE> (e)) res = 0;
+        else if (isOpX<AND> (e) || isOpX<OR> (e))
+        {
+          bool isAnd = isOpX<AND> (e);
+          res = isAnd ? 1 : 0;
+          for (auto a = e->args_begin (), end = e->args_end (); a != end; ++a)
+            res = isAnd ? mkAnd (res, build (*a)) : mkOr (res, build (*a));
+        }
+        else if (isOpX<NEG> (e)) res = build (e->left ()) ^ 1;
+        else if (isOpX<IMPL> (e) && e->arity () == 2)
+          res = mkOr (build (e->left ()) ^ 1, build (e->right ()));
+        else if ((isOpX<IFF> (e) || isOpX<XOR> (e)) && e->arity () == 2)
+        {
+          Lit a = build (e->left ());
+          Lit b = build (e->right ());
+          res = mkOr (mkAnd (a, b), mkAnd (a ^ 1, b ^ 1));
+          if (isOpX<XOR> (e)) res ^= 1;
+        }
+        // -- only reached in a Boolean position
+        else if (isOpX<ITE> (e) && e->arity () == 3)
+        {
+          Lit c = build (e->arg (0));
+          res = mkOr (mkAnd (c, build (e->arg (1))),
+                      mkAnd (c ^ 1, build (e->arg (2))));
+        }
+        else res = mkInput (e);
+
+        m_cache [e] = res;
+        return res;
+      }
+
+      unsigned AigGraph::size (Lit a) const
+      {
+        std::vector<char> seen (m_nodes.size (), 0);
+        std::vector<unsigned> wl (1, a >> 1);
+        unsigned res = 0;
+        while (!wl.empty ())
+        {
+          unsigned n = wl.back ();
+          wl.pop_back ();
+          if (n == 0 || seen [n]) continue;
+          seen [n] = 1;
+          ++res;
+          if (m_nodes [n].input) continue;
+          wl.push_back (m_nodes [n].left >> 1);
+          wl.push_back (m_nodes [n].right >> 1);
+        }
+        return res;
+      }
+
+      Expr AigGraph::toExpr (Lit a, ExprFactory &efac, bool gather)
+      {
+        auto it = m_exprs.find (a);
+        if (it != m_exprs.end ()) return it->second;
+
+        Expr res;
+        const Node &n = m_nodes [a >> 1];
+        if (a <= 1) res = a ? mk<TRUE> (efac) : mk<FALSE> (efac);
+        else if (n.input)
+          res = (a & 1) ? lneg (Expr (n.input)) : Expr (n.input);
+        // -- a negated gate is a disjunction of the negated inputs
+        else if (a & 1)
+          res = mk<OR> (toExpr (n.left ^ 1, efac), toExpr (n.right ^ 1, efac));
+        else
+          res = mk<AND> (toExpr (n.left, efac), toExpr (n.right, efac));
+
+        m_exprs [a] = res;
+        return gather ? boolop::gather (res) : res;
+      }
+
+      Expr aig (Expr e, bool gather)
+      {
+        AigGraph g;
+        return g.toExpr (g.build (e.get ()), e->efac (), gather);
+      }
+
+      unsigned aigSize (Expr e)
+      {
+        AigGraph g;
+        return g.size (g.build (e.get ()));
+      }
+    }
+  }
+}
@@ -0,0 +1,159 @@
+#include "seahorn/Support/LazyLoad.hh"
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "ufo/Stats.hh"
+#include "avy/AvyDebug.h"
+
+#include <vector>
+
+static llvm::cl::opt<bool>
+LazyLoad ("lazy-load",
+          llvm::cl::desc ("Materialize only the functions reachable "
+                          "from the entry points of the input bitcode"),
+          llvm::cl::init (false));
+
+static llvm::cl::list<std::string>
+LazyEntries ("lazy-entry",
+             llvm::cl::desc ("Entry point for --lazy-load (default: main). "
+                             "sea pp passes the functions of --slice-functions"),
+             llvm::cl::ZeroOrMore);
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  namespace
+  {
+    /// Materializes every function reachable from the entry points and
+    /// drops the bodies of the others
+    class Materializer
+    {
+      Module &m_mod;
+      SmallPtrSet<const Constant*, 32> m_seen;
+      std::vector<Constant*> m_work;
+
+      void visit (Value *v)
+      {
+        Constant *c = dyn_cast<Constant> (v);
+        if (c && m_seen.insert (c).second) m_work.push_back (c);
+      }
+
+      std::error_code scan (Function &F)
+      {
+        if (F.isMaterializable ())
+          if (std::error_code ec = F.materialize ()) return ec;
+        if (F.hasPersonalityFn ()) visit (F.getPersonalityFn ());
+        for (BasicBlock &bb : F)
+          for (Instruction &I : bb)
+            for (Value *op : I.operands ()) visit (op);
+        return std::error_code ();
+      }
+
+    public:
+      Materializer (Module &M) : m_mod (M) {}
+
+      /// false if no entry point is in the module
+      bool addEntries ()
+      {
+        if (LazyEntries.empty ())
+        {
+          if (Function *main = m_mod.getFunction ("main")) visit (main);
+        }
+        else
+          for (const std::string &name : LazyEntries)
+            if (Function *fn = m_mod.getFunction (name)) visit (fn);
+            else errs () << "WARNING: lazy-load: no function " << name << "\n";
+
+        if (m_work.empty ()) return false;
+
+        // -- llvm.global_ctors, llvm.used and the like
+        for (GlobalVariable &gv : m_mod.globals ())
+          if (gv.hasAppendingLinkage ()) visit (&gv);
+        return true;
+      }
+
+      std::error_code run ()
+      {
+        while (!m_work.empty ())
+        {
+          Constant *c = m_work.back ();
+          m_work.pop_back ();
+
+          if (Function *fn = dyn_cast<Function> (c))
+          { if (std::error_code ec = scan (*fn)) return ec; }
+          else if (GlobalVariable *gv = dyn_cast<GlobalVariable> (c))
+          { if (gv->hasInitializer ()) visit (gv->getInitializer ()); }
+          else if (GlobalAlias *ga = dyn_cast<GlobalAlias> (c))
+            visit (ga->getAliasee ());
+          else
+            for (Value *op : c->operands ()) visit (op);
+        }
+
+        unsigned dropped = 0;
+        for (Function &F : m_mod)
+        {
+          if (m_seen.count (&F) || (F.isDeclaration () && !F.isMaterializable ()))
+            continue;
+          LOG ("lazy-load",
+               errs () << "lazy-load: dropped body of " << F.getName () << "\n";);
+          F.deleteBody ();
+          ++dropped;
+        }
+        ufo::Stats::uset ("LazyLoadDroppedFns", dropped);
+
+        // -- nothing is left to load, the reader releases the file
+        return m_mod.materializeAll ();
+      }
+    };
+  }
+
+  std::unique_ptr<Module> readModule (std::unique_ptr<MemoryBuffer> buf,
+                                      SMDiagnostic &err, LLVMContext &ctx)
+  {
+    if (!LazyLoad) return parseIR (buf->getMemBufferRef (), err, ctx);
+
+    std::string name = buf->getBufferIdentifier ().str ();
+    std::unique_ptr<Module> M = getLazyIRModule (std::move (buf), err, ctx);
+    if (!M) return nullptr;
+
+    Materializer mat (*M);
+    std::error_code ec;
+    if (mat.addEntries ())
+      ec = mat.run ();
+    else
+    {
+      errs () << "WARNING: lazy-load: no entry point, loading everything\n";
+      ec = M->materializeAll ();
+    }
+
+    if (ec)
+    {
+      err = SMDiagnostic (name, SourceMgr::DK_Error, ec.message ());
+      return nullptr;
+    }
+    return M;
+  }
+
+  std::unique_ptr<Module> readModule (const std::string &filename,
+                                      SMDiagnostic &err, LLVMContext &ctx)
+  {
+    if (!LazyLoad) return parseIRFile (filename, err, ctx);
+
+    // -- large files are memory-mapped
+    ErrorOr<std::unique_ptr<MemoryBuffer> > buf =
+      MemoryBuffer::getFileOrSTDIN (filename);
+    if (std::error_code ec = buf.getError ())
+    {
+      err = SMDiagnostic (filename, SourceMgr::DK_Error,
+                          "Could not open input file: " + ec.message ());
+      return nullptr;
+    }
+    return readModule (std::move (*buf), err, ctx);
+  }
+}
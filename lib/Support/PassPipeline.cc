@@ -0,0 +1,322 @@
+#include "seahorn/Support/PassPipeline.hh"
+
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
+
+namespace seahorn
+{
+  using namespace llvm;
+
+  namespace
+  {
+    typedef std::chrono::steady_clock clock_type;
+
+    double secondsSince (clock_type::time_point start)
+    {return std::chrono::duration<double> (clock_type::now () - start).count ();}
+
+    /// Runs every pass, one after the other, on the given functions of M
+    void runOnFunctions (Module &M, const std::vector<std::string> &fns,
+                         const std::vector<PassPipeline::PassFactory> &passes,
+                         std::vector<double> &times)
+    {
+      for (unsigned i = 0, sz = passes.size (); i < sz; ++i)
+      {
+        clock_type::time_point start = clock_type::now ();
+        legacy::FunctionPassManager fpm (&M);
+        fpm.add (passes [i] ());
+        fpm.doInitialization ();
+        for (const std::string &name : fns)
+          if (Function *F = M.getFunction (name))
+            if (!F->isDeclaration ()) fpm.run (*F);
+        fpm.doFinalization ();
+        times [i] += secondsSince (start);
+      }
+    }
+
+    void writeBitcode (const Module &M, std::string &out)
+    {
+      raw_string_ostream os (out);
+      // -- keep use-lists so that passes see the same order of users
+      WriteBitcodeToFile (&M, os, true);
+      os.flush ();
+    }
+
+    /// Moves the globals in list to the order of names. Globals that
+    /// are not named go last, in their current order
+    template <typename List>
+    void restoreOrder (List &list, const std::vector<std::string> &names)
+    {
+      typedef typename List::value_type T;
+      std::map<std::string, T*> byName;
+      for (T &v : list) byName [v.getName ()] = &v;
+
+      std::vector<T*> order;
+      std::set<T*> seen;
+      for (const std::string &name : names)
+      {
+        auto it = byName.find (name);
+        if (it != byName.end () && seen.insert (it->second).second)
+          order.push_back (it->second);
+      }
+      for (T &v : list)
+        if (seen.count (&v) <= 0) order.push_back (&v);
+
+      for (T *v : order)
+      {
+        list.remove (v);
+        list.push_back (v);
+      }
+    }
+  }
+
+  PassPipeline::~PassPipeline ()
+  {
+    // -- barriers that never ran
+    for (Step &s : m_steps) delete s.pass;
+  }
+
+  void PassPipeline::add (Pass *pass)
+  {
+    Step s;
+    s.pass = pass;
+    m_steps.push_back (s);
+  }
+
+  void PassPipeline::addLocal (PassFactory factory)
+  {
+    Step s;
+    s.pass = nullptr;
+    s.local = factory;
+    m_steps.push_back (s);
+  }
+
+  void PassPipeline::run (std::unique_ptr<Module> &M)
+  {
+    if (m_threads == 0)
+    {
+      legacy::PassManager pm;
+      for (Step &s : m_steps)
+      {
+        pm.add (s.pass ? s.pass : s.local ());
+        s.pass = nullptr;
+      }
+      pm.run (*M);
+      return;
+    }
+
+    std::vector<PassFactory> locals;
+    for (Step &s : m_steps)
+    {
+      if (!s.pass)
+      {
+        locals.push_back (s.local);
+        continue;
+      }
+
+      if (!locals.empty ()) runLocal (locals, M);
+      locals.clear ();
+      Pass *pass = s.pass;
+      s.pass = nullptr;
+      runBarrier (pass, *M);
+    }
+    if (!locals.empty ()) runLocal (locals, M);
+  }
+
+  void PassPipeline::runBarrier (Pass *pass, Module &M)
+  {
+    Timing t;
+    t.name = pass->getPassName ();
+    t.local = false;
+
+    clock_type::time_point start = clock_type::now ();
+    legacy::PassManager pm;
+    pm.add (pass);
+    pm.run (M);
+    t.wall = t.cpu = secondsSince (start);
+    m_times.push_back (t);
+  }
+
+  void PassPipeline::runLocal (const std::vector<PassFactory> &passes,
+                               std::unique_ptr<Module> &M)
+  {
+    clock_type::time_point start = clock_type::now ();
+
+    std::vector<Timing> times (passes.size ());
+    for (unsigned i = 0, sz = passes.size (); i < sz; ++i)
+    {
+      std::unique_ptr<Pass> p (passes [i] ());
+      times [i].name = p->getPassName ();
+      times [i].local = true;
+      times [i].wall = times [i].cpu = 0.0;
+    }
+
+    // -- distribute functions by size. Aliases, comdats and unnamed
+    // -- globals are not split
+    bool canSplit = M->alias_empty ();
+    std::vector<std::string> fnOrder, gvOrder;
+    std::vector<std::pair<std::string, GlobalValue::LinkageTypes> > locals;
+    std::vector<std::pair<Function*, unsigned> > defs;
+    for (Function &F : *M)
+    {
+      if (!F.hasName () || F.hasComdat ()) canSplit = false;
+      fnOrder.push_back (F.getName ());
+      if (F.hasLocalLinkage ()) locals.push_back (std::make_pair (F.getName (), F.getLinkage ()));
+      if (F.isDeclaration ()) continue;
+      unsigned sz = 0;
+      for (BasicBlock &bb : F) sz += bb.size ();
+      defs.push_back (std::make_pair (&F, sz));
+    }
+    for (GlobalVariable &gv : M->globals ())
+    {
+      if (!gv.hasName () || gv.hasComdat ()) canSplit = false;
+      gvOrder.push_back (gv.getName ());
+      if (gv.hasLocalLinkage ()) locals.push_back (std::make_pair (gv.getName (), gv.getLinkage ()));
+    }
+
+    unsigned parts = std::min<size_t> (m_threads, defs.size ());
+    if (!canSplit || parts < 2)
+    {
+      std::vector<std::string> fns;
+      for (auto &kv : defs) fns.push_back (kv.first->getName ());
+      std::vector<double> t (passes.size (), 0.0);
+      runOnFunctions (*M, fns, passes, t);
+      for (unsigned i = 0, sz = passes.size (); i < sz; ++i)
+        times [i].wall = times [i].cpu = t [i];
+      m_times.insert (m_times.end (), times.begin (), times.end ());
+      return;
+    }
+
+    std::vector<std::vector<std::string> > owned (parts);
+    std::vector<unsigned> load (parts, 0);
+    for (auto &kv : defs)
+    {
+      unsigned p = std::min_element (load.begin (), load.end ()) - load.begin ();
+      owned [p].push_back (kv.first->getName ());
+      load [p] += kv.second + 1;
+    }
+
+    // -- linking needs all symbols to be visible. M itself is
+    // -- restored right away
+    std::string bitcode;
+    for (auto &kv : locals)
+      M->getNamedValue (kv.first)->setLinkage (GlobalValue::ExternalLinkage);
+    writeBitcode (*M, bitcode);
+    for (auto &kv : locals)
+      M->getNamedValue (kv.first)->setLinkage (kv.second);
+
+    std::vector<std::string> results (parts);
+    std::vector<std::vector<double> > workerTimes
+      (parts, std::vector<double> (passes.size (), 0.0));
+    std::vector<char> failed (parts, 0);
+    {
+      ThreadPool pool (parts);
+      for (unsigned p = 0; p < parts; ++p)
+        pool.async ([&, p] {
+            LLVMContext ctx;
+            auto mod = parseBitcodeFile (MemoryBufferRef (bitcode, "seapp"), ctx);
+            if (!mod) { failed [p] = 1; return; }
+            Module &PM = **mod;
+
+            runOnFunctions (PM, owned [p], passes, workerTimes [p]);
+
+            // -- keep only what this worker is responsible for
+            std::set<std::string> mine (owned [p].begin (), owned [p].end ());
+            for (Function &F : PM)
+              if (!F.isDeclaration () && mine.count (F.getName ()) <= 0)
+                F.deleteBody ();
+            if (p > 0)
+            {
+              for (GlobalVariable &gv : PM.globals ())
+                if (gv.hasInitializer ())
+                {
+                  gv.setInitializer (nullptr);
+                  gv.setLinkage (GlobalValue::ExternalLinkage);
+                }
+              std::vector<NamedMDNode*> named;
+              for (NamedMDNode &nmd : PM.named_metadata ())
+                if (nmd.getName () != "llvm.module.flags") named.push_back (&nmd);
+              for (NamedMDNode *nmd : named) nmd->eraseFromParent ();
+            }
+            writeBitcode (PM, results [p]);
+          });
+      pool.wait ();
+    }
+
+    bool ok = true;
+    std::unique_ptr<Module> linked;
+    for (unsigned p = 0; ok && p < parts; ++p)
+    {
+      if (failed [p]) { ok = false; break; }
+      auto mod = parseBitcodeFile (MemoryBufferRef (results [p], "seapp"),
+                                   M->getContext ());
+      if (!mod) ok = false;
+      else if (!linked) linked = std::move (*mod);
+      else if (Linker::linkModules (*linked, std::move (*mod))) ok = false;
+    }
+
+    if (!ok)
+    {
+      errs () << "WARNING: seapp: could not merge the parallel pipeline."
+              << " Running it serially\n";
+      std::vector<std::string> fns;
+      for (auto &kv : defs) fns.push_back (kv.first->getName ());
+      std::vector<double> t (passes.size (), 0.0);
+      runOnFunctions (*M, fns, passes, t);
+      for (unsigned i = 0, sz = passes.size (); i < sz; ++i)
+        times [i].wall = times [i].cpu = t [i];
+      m_times.insert (m_times.end (), times.begin (), times.end ());
+      return;
+    }
+
+    for (auto &kv : locals)
+      if (GlobalValue *gv = linked->getNamedValue (kv.first))
+        gv->setLinkage (kv.second);
+    restoreOrder (linked->getFunctionList (), fnOrder);
+    restoreOrder (linked->getGlobalList (), gvOrder);
+    M = std::move (linked);
+
+    for (unsigned i = 0, sz = passes.size (); i < sz; ++i)
+      for (unsigned p = 0; p < parts; ++p)
+      {
+        times [i].wall = std::max (times [i].wall, workerTimes [p][i]);
+        times [i].cpu += workerTimes [p][i];
+      }
+    m_times.insert (m_times.end (), times.begin (), times.end ());
+
+    Timing merge;
+    merge.name = "split and merge (" + std::to_string (parts) + " threads)";
+    merge.local = false;
+    merge.wall = secondsSince (start);
+    for (unsigned i = 0, sz = passes.size (); i < sz; ++i)
+      merge.wall -= times [i].wall;
+    merge.cpu = merge.wall;
+    m_times.push_back (merge);
+  }
+
+  void PassPipeline::printTimes (raw_ostream &out) const
+  {
+    double wall = 0.0, cpu = 0.0;
+    out << "===-------------------------------------------------------------------------===\n"
+        << "                        seapp pass execution timing\n"
+        << "===-------------------------------------------------------------------------===\n"
+        << "    Wall (s)   Total (s)  Name\n";
+    for (const Timing &t : m_times)
+    {
+      out << format ("%12.4f%12.4f  ", t.wall, t.cpu) << t.name
+          << (t.local ? " [parallel]" : "") << "\n";
+      wall += t.wall;
+      cpu += t.cpu;
+    }
+    out << format ("%12.4f%12.4f  ", wall, cpu) << "Total\n";
+  }
+}
@@ -0,0 +1,173 @@
+#include "seahorn/Support/ResourceGovernor.hh"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "ufo/Stats.hh"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+#include <cassert>
+#include <fstream>
+#include <unistd.h>
+#include <sys/resource.h>
+
+static llvm::cl::list<std::string>
+Budgets ("sea-budget",
+         llvm::cl::desc ("Budget of a phase (pp, hornify, solve, cex) "
+                         "as phase:seconds[:megabytes]. 0 means no limit"),
+         llvm::cl::CommaSeparated, llvm::cl::ZeroOrMore);
+
+namespace seahorn
+{
+  using namespace ufo;
+
+  ResourceGovernor &ResourceGovernor::get ()
+  {
+    static ResourceGovernor gov;
+    return gov;
+  }
+
+  ResourceGovernor::ResourceGovernor () :
+    m_exceeded (false), m_anyExceeded (false), m_peakRss (0), m_stop (true)
+  {
+    for (const std::string &b : Budgets)
+    {
+      std::vector<std::string> parts;
+      boost::split (parts, b, boost::is_any_of (":"));
+      if (parts.size () < 2 || parts.size () > 3)
+      {
+        llvm::errs () << "WARNING: ignoring budget " << b
+                      << ". Expected phase:seconds[:megabytes]\n";
+        continue;
+      }
+
+      try
+      {
+        unsigned secs = boost::lexical_cast<unsigned> (parts [1]);
+        unsigned mb = parts.size () == 3 ? boost::lexical_cast<unsigned> (parts [2]) : 0;
+        setBudget (parts [0], secs, mb);
+      }
+      catch (boost::bad_lexical_cast &)
+      {
+        llvm::errs () << "WARNING: ignoring budget " << b
+                      << ". Expected phase:seconds[:megabytes]\n";
+      }
+    }
+  }
+
+  ResourceGovernor::~ResourceGovernor ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      m_stop = true;
+    }
+    m_cv.notify_all ();
+    if (m_watchdog.joinable ()) m_watchdog.join ();
+  }
+
+  void ResourceGovernor::setBudget (const std::string &phase,
+                                    unsigned seconds, unsigned megabytes)
+  {
+    Budget &b = m_budgets [phase];
+    b.seconds = seconds;
+    b.megabytes = megabytes;
+  }
+
+  void ResourceGovernor::enter (const std::string &phase)
+  {
+    assert (!m_watchdog.joinable () && "Phases do not nest");
+
+    m_phase = phase;
+    m_exceeded = false;
+    m_peakRss = currentRss ();
+    m_start = std::chrono::steady_clock::now ();
+
+    auto it = m_budgets.find (phase);
+    m_budget = it != m_budgets.end () ? it->second : Budget ();
+    if (m_budget.seconds == 0 && m_budget.megabytes == 0) return;
+
+    m_stop = false;
+    m_watchdog = std::thread (&ResourceGovernor::watch, this);
+  }
+
+  void ResourceGovernor::leave ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      m_stop = true;
+      m_interrupts.clear ();
+    }
+    m_cv.notify_all ();
+    if (m_watchdog.joinable ()) m_watchdog.join ();
+
+    unsigned rss = currentRss ();
+    if (rss > m_peakRss) m_peakRss = rss;
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>
+      (std::chrono::steady_clock::now () - m_start).count ();
+
+    Stats::uset (m_phase + ".WallMs", ms);
+    Stats::uset (m_phase + ".PeakRssMb", m_peakRss);
+    if (m_exceeded)
+    {
+      m_anyExceeded = true;
+      Stats::sset (m_phase + ".Budget", "EXCEEDED");
+      llvm::errs () << "WARNING: " << m_phase << " exceeded its budget\n";
+    }
+    m_phase.clear ();
+  }
+
+  void ResourceGovernor::reset ()
+  {
+    assert (m_phase.empty () && "Cannot reset inside a phase");
+    m_exceeded = false;
+    m_anyExceeded = false;
+    m_peakRss = 0;
+  }
+
+  void ResourceGovernor::onInterrupt (Callback fn)
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    // -- too late to wait for the watchdog
+    if (m_exceeded) fn ();
+    else m_interrupts.push_back (fn);
+  }
+
+  void ResourceGovernor::watch ()
+  {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    // -- the first check is at once, so that a phase that starts over
+    // -- its memory budget is stopped even if it is short
+    for (bool first = true; !m_stop && !m_exceeded; first = false)
+    {
+      if (!first) m_cv.wait_for (lock, std::chrono::milliseconds (100));
+      if (m_stop) break;
+
+      unsigned rss = currentRss ();
+      if (rss > m_peakRss) m_peakRss = rss;
+      auto secs = std::chrono::duration_cast<std::chrono::seconds>
+        (std::chrono::steady_clock::now () - m_start).count ();
+
+      if ((m_budget.seconds > 0 && secs >= m_budget.seconds) ||
+          (m_budget.megabytes > 0 && rss >= m_budget.megabytes))
+      {
+        m_exceeded = true;
+        for (Callback &fn : m_interrupts) fn ();
+      }
+    }
+  }
+
+  unsigned ResourceGovernor::currentRss ()
+  {
+    std::ifstream statm ("/proc/self/statm");
+    unsigned long size, resident;
+    if (statm >> size >> resident)
+      return resident * sysconf (_SC_PAGESIZE) / (1024 * 1024);
+
+    // -- no procfs. Fall back to the peak, in kilobytes on Linux
+    struct rusage ru;
+    getrusage (RUSAGE_SELF, &ru);
+    return ru.ru_maxrss / 1024;
+  }
+}
@@ -17,6 +17,14 @@ namespace ufo
   void Stats::sset (const std::string &n, std::string v) {ss [n] = v;}
   std::string& Stats::sget (const std::string &n) {return ss[n];}
   
+  void Stats::reset ()
+  {
+    counters.clear ();
+    sw.clear ();
+    av.clear ();
+    ss.clear ();
+  }
+
   void Stats::start (const std::string &name) { sw[name].start (); }
   void Stats::stop (const std::string &name) { sw[name].stop (); }
   void Stats::resume (const std::string &name) { sw[name].resume (); }
@@ -0,0 +1,540 @@
+//===-- Property-directed slicing (cone of influence) ----------------------===//
+//
+// Removes instructions that cannot affect whether verifier.error is
+// reached. Must run after ShadowMemSeaDsa and after shadow memory has
+// been promoted to registers: memory dependences are then def-use
+// chains of shadow.mem values, one chain per memory region.
+//
+// An instruction is relevant if it is a call to a verifier function
+// (error, assume, ...), a call to a function that may block or fail,
+// a control-flow decision that a relevant instruction is control
+// dependent on, or a (data or memory) dependence of a relevant
+// instruction. Memory is tracked at region granularity: a relevant
+// load makes all reaching stores to its region relevant, and through
+// shadow.mem.in/out and shadow.mem.arg.* the regions of callers and
+// callees.
+//
+// The shape of the CFG and the interface of every function (arguments
+// and shadow.mem.in/out markers) are left unchanged. Irrelevant branch
+// conditions and return values are replaced by non-deterministic
+// values. Exits of loops are always kept so that non-terminating loops
+// stay non-terminating.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "seahorn/Transforms/Instrumentation/ShadowMemDsa.hh"
+#include "seahorn/Transforms/Utils/Local.hh"
+
+#include "ufo/Stats.hh"
+#include "avy/AvyDebug.h"
+
+#include <set>
+
+using namespace llvm;
+
+namespace
+{
+  /// name of the shadow.mem function called by I, or empty
+  static StringRef shadowName (const Instruction &I)
+  {
+    if (const CallInst *ci = dyn_cast<CallInst> (&I))
+      if (const Function *fn = ci->getCalledFunction ())
+        if (fn->getName ().startswith ("shadow.mem")) return fn->getName ();
+    return StringRef ();
+  }
+
+  static unsigned shadowIdx (const Instruction &I)
+  {
+    // -- shadow.mem.{arg.ref,arg.mod,arg.new,in,out} (id, mem, idx, scalar)
+    return cast<ConstantInt> (cast<CallInst> (I).getArgOperand (2))->getZExtValue ();
+  }
+
+  /// true if I accesses memory with the help of a preceding shadow call
+  static bool isMemoryAccess (const Instruction &I)
+  {
+    if (isa<LoadInst> (I) || isa<StoreInst> (I) || isa<MemSetInst> (I))
+      return true;
+    if (const CallInst *ci = dyn_cast<CallInst> (&I))
+      if (const Function *fn = ci->getCalledFunction ())
+        return fn->getName ().equals ("calloc");
+    return false;
+  }
+
+  /// true if a call to fn is part of the property
+  static bool isVerifierFn (const Function &fn)
+  {
+    if (!fn.isDeclaration ()) return false;
+    StringRef name = fn.getName ();
+    if (name.startswith ("verifier.nondet")) return false;
+    return name.startswith ("verifier.") || name.startswith ("seahorn.");
+  }
+
+  class ConeOfInfluence : public ModulePass
+  {
+    /// relevant instructions and arguments
+    DenseSet<const Value*> m_live;
+    SmallVector<const Value*, 64> m_wl;
+
+    /// values of shadow memory regions
+    DenseSet<const Value*> m_mem;
+    /// shadow call -> memory access and back
+    DenseMap<const Instruction*, const Instruction*> m_pair;
+    /// shadow.mem.arg.* calls that precede a call site and back
+    DenseMap<const Instruction*, SmallVector<Instruction*, 4> > m_argShadows;
+    DenseMap<const Instruction*, Instruction*> m_argCall;
+    /// shadow.mem.arg.* calls of relevant call sites. They stay even
+    /// if the content of their region is not needed
+    DenseSet<const Instruction*> m_keep;
+    /// block -> terminators it is control dependent on
+    DenseMap<const BasicBlock*, SmallVector<const BasicBlock*, 4> > m_cdeps;
+    /// call sites of each function
+    DenseMap<const Function*, SmallVector<Instruction*, 8> > m_callers;
+    /// shadow.mem.in and shadow.mem.out markers of each function by index
+    DenseMap<const Function*, DenseMap<unsigned, Instruction*> > m_ins;
+    DenseMap<const Function*, DenseMap<unsigned, Instruction*> > m_outs;
+    /// functions that may block or fail
+    DenseSet<const Function*> m_blocking;
+
+    void markLive (const Value *v)
+    {
+      if (!isa<Instruction> (v) && !isa<Argument> (v)) return;
+      if (m_live.insert (v).second) m_wl.push_back (v);
+    }
+
+    void analyzeFunction (Function &F);
+    void computeBlocking (Module &M);
+    void seed (Function &F);
+    void propagate (const Value &v);
+    void demandArgument (const Argument &arg);
+    void demandMemory (const Instruction &I);
+    unsigned slice (Function &F, unsigned &regions);
+
+  public:
+    static char ID;
+    ConeOfInfluence () : ModulePass (ID) {}
+
+    virtual bool runOnModule (Module &M);
+    virtual void getAnalysisUsage (AnalysisUsage &AU) const;
+    virtual const char* getPassName () const {return "ConeOfInfluence";}
+  };
+
+  char ConeOfInfluence::ID = 0;
+
+  void ConeOfInfluence::analyzeFunction (Function &F)
+  {
+    // -- control dependence from post-dominators. Blocks the
+    // -- post-dominator tree does not know about (e.g., in loops that
+    // -- never exit) keep all their decisions
+    PostDominatorTree &PDT = getAnalysis<PostDominatorTree> (F);
+    for (BasicBlock &A : F)
+    {
+      TerminatorInst *term = A.getTerminator ();
+      if (term->getNumSuccessors () < 2) continue;
+
+      DomTreeNode *na = PDT.getNode (&A);
+      if (!na) { markLive (term); continue; }
+      DomTreeNode *ipdom = na->getIDom ();
+
+      for (unsigned i = 0, e = term->getNumSuccessors (); i < e; ++i)
+      {
+        DomTreeNode *n = PDT.getNode (term->getSuccessor (i));
+        if (!n) { markLive (term); break; }
+        for (; n && n != ipdom; n = n->getIDom ())
+          if (n->getBlock ()) m_cdeps [n->getBlock ()].push_back (&A);
+      }
+    }
+
+    // -- keep loop exits
+    LoopInfo &LI = getAnalysis<LoopInfoWrapperPass> (F).getLoopInfo ();
+    SmallVector<Loop*, 8> loops (LI.begin (), LI.end ());
+    while (!loops.empty ())
+    {
+      Loop *L = loops.pop_back_val ();
+      loops.append (L->begin (), L->end ());
+      SmallVector<BasicBlock*, 4> exiting;
+      L->getExitingBlocks (exiting);
+      for (BasicBlock *bb : exiting) markLive (bb->getTerminator ());
+    }
+
+    for (BasicBlock &bb : F)
+    {
+      Instruction *shadow = nullptr;
+      SmallVector<Instruction*, 4> args;
+      for (Instruction &I : bb)
+      {
+        StringRef name = shadowName (I);
+        if (name.equals ("shadow.mem.load") || name.equals ("shadow.mem.store"))
+          shadow = &I;
+        else if (name.startswith ("shadow.mem.arg.") && !name.equals ("shadow.mem.arg.init"))
+          args.push_back (&I);
+        else if (name.equals ("shadow.mem.in"))
+          m_ins [&F][shadowIdx (I)] = &I;
+        else if (name.equals ("shadow.mem.out"))
+          m_outs [&F][shadowIdx (I)] = &I;
+        else if (isMemoryAccess (I) && shadow)
+        {
+          m_pair [shadow] = &I;
+          m_pair [&I] = shadow;
+          shadow = nullptr;
+        }
+
+        if (name.equals ("shadow.mem.store") || name.equals ("shadow.mem.init") ||
+            name.equals ("shadow.mem.arg.init") || name.equals ("shadow.mem.arg.mod") ||
+            name.equals ("shadow.mem.arg.new"))
+          m_mem.insert (&I);
+
+        if (!name.empty () || isa<IntrinsicInst> (I)) continue;
+        if (CallInst *ci = dyn_cast<CallInst> (&I))
+        {
+          if (Function *fn = ci->getCalledFunction ())
+            m_callers [fn].push_back (ci);
+          for (Instruction *s : args) m_argCall [s] = ci;
+          if (!args.empty ()) m_argShadows [ci].swap (args);
+          args.clear ();
+        }
+      }
+    }
+
+    // -- phi-nodes of shadow memory
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      for (BasicBlock &bb : F)
+        for (Instruction &I : bb)
+        {
+          PHINode *phi = dyn_cast<PHINode> (&I);
+          if (!phi) break;
+          if (m_mem.count (phi) > 0) continue;
+          for (unsigned i = 0, e = phi->getNumIncomingValues (); i < e; ++i)
+            if (m_mem.count (phi->getIncomingValue (i)) > 0)
+            {
+              m_mem.insert (phi);
+              changed = true;
+              break;
+            }
+        }
+    }
+  }
+
+  void ConeOfInfluence::computeBlocking (Module &M)
+  {
+    CallGraph &CG = getAnalysis<CallGraphWrapperPass> ().getCallGraph ();
+    // -- callees are visited before callers
+    for (auto it = scc_begin (&CG); !it.isAtEnd (); ++it)
+    {
+      bool blocking = it.hasLoop ();
+      for (CallGraphNode *cgn : *it)
+      {
+        Function *F = cgn->getFunction ();
+        if (!F || F->isDeclaration ()) continue;
+
+        // -- a cycle in the CFG might not terminate
+        for (auto bit = scc_begin (F); !bit.isAtEnd (); ++bit)
+          if (bit.hasLoop ()) blocking = true;
+
+        for (BasicBlock &bb : *F)
+          for (Instruction &I : bb)
+          {
+            CallSite CS (&I);
+            if (!CS || isa<IntrinsicInst> (I)) continue;
+            const Function *fn = CS.getCalledFunction ();
+            if (!fn) fn = dyn_cast<Function> (CS.getCalledValue ()->stripPointerCasts ());
+            if (!fn) blocking = true;
+            else if (isVerifierFn (*fn) || m_blocking.count (fn) > 0)
+              blocking = true;
+          }
+      }
+
+      if (blocking)
+        for (CallGraphNode *cgn : *it)
+          if (Function *F = cgn->getFunction ()) m_blocking.insert (F);
+    }
+  }
+
+  void ConeOfInfluence::seed (Function &F)
+  {
+    for (BasicBlock &bb : F)
+      for (Instruction &I : bb)
+      {
+        if (isa<TerminatorInst> (I) &&
+            !isa<BranchInst> (I) && !isa<SwitchInst> (I) && !isa<ReturnInst> (I))
+          markLive (&I);
+        // -- unconditional branches have nothing to slice
+        else if (BranchInst *br = dyn_cast<BranchInst> (&I))
+        { if (br->isUnconditional ()) markLive (br); }
+        else if (isa<ReturnInst> (I) && I.getNumOperands () == 0)
+          markLive (&I);
+
+        if (!shadowName (I).empty ()) continue;
+        CallSite CS (&I);
+        if (!CS || isa<IntrinsicInst> (I)) continue;
+
+        const Function *fn = CS.getCalledFunction ();
+        if (!fn || isVerifierFn (*fn) || m_blocking.count (fn) > 0)
+          markLive (&I);
+      }
+
+    // -- the interface of F stays
+    DenseMap<unsigned, Instruction*> &ins = m_ins [&F];
+    for (auto &kv : ins) markLive (kv.second);
+    DenseMap<unsigned, Instruction*> &outs = m_outs [&F];
+    for (auto &kv : outs) markLive (kv.second);
+  }
+
+  void ConeOfInfluence::demandArgument (const Argument &arg)
+  {
+    for (Instruction *cs : m_callers [arg.getParent ()])
+    {
+      markLive (cs);
+      markLive (CallSite (cs).getArgument (arg.getArgNo ()));
+    }
+  }
+
+  /// I is a shadow memory value whose content is needed
+  void ConeOfInfluence::demandMemory (const Instruction &I)
+  {
+    if (const PHINode *phi = dyn_cast<PHINode> (&I))
+    {
+      for (unsigned i = 0, e = phi->getNumIncomingValues (); i < e; ++i)
+      {
+        markLive (phi->getIncomingValue (i));
+        markLive (phi->getIncomingBlock (i)->getTerminator ());
+      }
+      return;
+    }
+
+    StringRef name = shadowName (I);
+    const CallInst &ci = cast<CallInst> (I);
+    if (name.equals ("shadow.mem.store"))
+    {
+      // -- the store changes part of the region
+      markLive (ci.getArgOperand (1));
+      auto it = m_pair.find (&I);
+      if (it != m_pair.end ()) markLive (it->second);
+    }
+    else if (name.equals ("shadow.mem.arg.mod") || name.equals ("shadow.mem.arg.new"))
+    {
+      markLive (ci.getArgOperand (1));
+      // -- the call that produces it and the final value in the callee
+      auto it = m_argCall.find (&I);
+      if (it == m_argCall.end ()) return;
+      markLive (it->second);
+      if (const Function *fn = cast<CallInst> (it->second)->getCalledFunction ())
+      {
+        DenseMap<unsigned, Instruction*> &outs = m_outs [fn];
+        auto out = outs.find (shadowIdx (I));
+        if (out != outs.end ())
+          markLive (cast<CallInst> (out->second)->getArgOperand (1));
+      }
+    }
+    else if (name.equals ("shadow.mem.arg.init"))
+    {
+      // -- the value of the region at every call site
+      const Function &F = *I.getParent ()->getParent ();
+      for (auto &kv : m_ins [&F])
+      {
+        if (cast<CallInst> (kv.second)->getArgOperand (1) != &I) continue;
+        for (Instruction *cs : m_callers [&F])
+          for (Instruction *s : m_argShadows [cs])
+            if (shadowIdx (*s) == kv.first)
+              markLive (cast<CallInst> (s)->getArgOperand (1));
+      }
+    }
+  }
+
+  void ConeOfInfluence::propagate (const Value &v)
+  {
+    if (const Argument *arg = dyn_cast<Argument> (&v))
+    {
+      demandArgument (*arg);
+      return;
+    }
+
+    const Instruction &I = cast<Instruction> (v);
+    for (const BasicBlock *bb : m_cdeps [I.getParent ()])
+      markLive (bb->getTerminator ());
+
+    if (m_mem.count (&I) > 0)
+    {
+      demandMemory (I);
+      return;
+    }
+
+    StringRef name = shadowName (I);
+    if (!name.empty ())
+    {
+      // -- interface markers do not need the content of the region
+      if (name.equals ("shadow.mem.load")) markLive (cast<CallInst> (I).getArgOperand (1));
+      return;
+    }
+
+    for (const Use &op : I.operands ()) markLive (op.get ());
+
+    if (const PHINode *phi = dyn_cast<PHINode> (&I))
+      for (unsigned i = 0, e = phi->getNumIncomingValues (); i < e; ++i)
+        markLive (phi->getIncomingBlock (i)->getTerminator ());
+
+    auto it = m_pair.find (&I);
+    if (it != m_pair.end ()) markLive (it->second);
+
+    if (const CallInst *ci = dyn_cast<CallInst> (&I))
+    {
+      for (Instruction *s : m_argShadows [ci]) m_keep.insert (s);
+      if (const Function *fn = ci->getCalledFunction ())
+        if (!fn->isDeclaration () && !fn->getReturnType ()->isVoidTy ())
+          for (const BasicBlock &bb : *fn)
+            if (isa<ReturnInst> (bb.getTerminator ())) markLive (bb.getTerminator ());
+    }
+  }
+
+  unsigned ConeOfInfluence::slice (Function &F, unsigned &regions)
+  {
+    Module &M = *F.getParent ();
+    std::set<int64_t> before, after;
+    SmallVector<Instruction*, 64> dead;
+    SmallVector<Instruction*, 16> deadMem;
+
+    for (BasicBlock &bb : F)
+      for (Instruction &I : bb)
+      {
+        StringRef name = shadowName (I);
+        if (name.equals ("shadow.mem.load") || name.equals ("shadow.mem.store"))
+          before.insert (seahorn::shadow_dsa::getShadowId (ImmutableCallSite (&I)));
+
+        if (m_live.count (&I) > 0 || m_keep.count (&I) > 0) continue;
+
+        if (TerminatorInst *term = dyn_cast<TerminatorInst> (&I))
+        {
+          // -- keep the control flow, forget the decision
+          Value *op = nullptr;
+          if (BranchInst *br = dyn_cast<BranchInst> (term)) op = br->getCondition ();
+          else if (SwitchInst *sw = dyn_cast<SwitchInst> (term)) op = sw->getCondition ();
+          else if (ReturnInst *ret = dyn_cast<ReturnInst> (term)) op = ret->getReturnValue ();
+          if (op && !isa<Constant> (op))
+          {
+            Function &nd = seahorn::createNewNondetFn (M, *op->getType (), 0,
+                                                       "verifier.nondet.coi.");
+            term->replaceUsesOfWith (op, CallInst::Create (&nd, "", term));
+          }
+          continue;
+        }
+
+        if (name.equals ("shadow.mem.init") || name.equals ("shadow.mem.arg.init") ||
+            (isa<PHINode> (I) && m_mem.count (&I) > 0))
+          continue;
+        if (m_mem.count (&I) > 0) deadMem.push_back (&I);
+        else dead.push_back (&I);
+      }
+
+    unsigned removed = dead.size () + deadMem.size ();
+
+    // -- memory flows through removed stores
+    for (Instruction *I : deadMem)
+    {
+      I->replaceAllUsesWith (cast<CallInst> (I)->getArgOperand (1));
+      I->eraseFromParent ();
+    }
+    for (Instruction *I : dead)
+    {
+      if (!I->use_empty ()) I->replaceAllUsesWith (UndefValue::get (I->getType ()));
+      I->dropAllReferences ();
+    }
+    for (Instruction *I : dead) I->eraseFromParent ();
+
+    // -- regions that are left without readers and writers
+    SmallVector<WeakVH, 16> unused;
+    for (BasicBlock &bb : F)
+      for (Instruction &I : bb)
+      {
+        StringRef name = shadowName (I);
+        if (name.equals ("shadow.mem.load") || name.equals ("shadow.mem.store"))
+          after.insert (seahorn::shadow_dsa::getShadowId (ImmutableCallSite (&I)));
+        if (PHINode *phi = dyn_cast<PHINode> (&I))
+          if (m_mem.count (phi) > 0) unused.push_back (phi);
+      }
+    for (WeakVH &vh : unused)
+      if (PHINode *phi = dyn_cast_or_null<PHINode> (vh))
+        if (RecursivelyDeleteDeadPHINode (phi)) ++removed;
+
+    for (BasicBlock &bb : F)
+      for (auto it = bb.begin (); it != bb.end (); )
+      {
+        Instruction &I = *it++;
+        if (shadowName (I).equals ("shadow.mem.init") && I.use_empty ())
+        {
+          I.eraseFromParent ();
+          ++removed;
+        }
+      }
+
+    for (int64_t id : before) if (after.count (id) <= 0) ++regions;
+    return removed;
+  }
+
+  bool ConeOfInfluence::runOnModule (Module &M)
+  {
+    ufo::ScopedStats _st_ ("ConeOfInfluence");
+
+    for (Function &F : M)
+      if (!F.isDeclaration ()) analyzeFunction (F);
+    computeBlocking (M);
+    for (Function &F : M)
+      if (!F.isDeclaration ()) seed (F);
+
+    while (!m_wl.empty ())
+    {
+      const Value *v = m_wl.pop_back_val ();
+      propagate (*v);
+    }
+
+    unsigned insts = 0;
+    unsigned regions = 0;
+    for (Function &F : M)
+    {
+      if (F.isDeclaration ()) continue;
+      unsigned r = 0;
+      unsigned n = slice (F, r);
+      LOG ("coi", errs () << "ConeOfInfluence: " << F.getName () << ": removed "
+           << n << " instructions and " << r << " regions\n";);
+      insts += n;
+      regions += r;
+    }
+
+    ufo::Stats::uset ("CoiRemovedInsts", insts);
+    ufo::Stats::uset ("CoiRemovedRegions", regions);
+    return insts > 0;
+  }
+
+  void ConeOfInfluence::getAnalysisUsage (AnalysisUsage &AU) const
+  {
+    AU.addRequired<CallGraphWrapperPass> ();
+    AU.addRequired<PostDominatorTree> ();
+    AU.addRequired<LoopInfoWrapperPass> ();
+  }
+}
+
+namespace seahorn
+{
+  Pass* createConeOfInfluencePass () {return new ConeOfInfluence ();}
+}
+
+static llvm::RegisterPass<ConeOfInfluence>
+X ("coi", "Slice the module to the cone of influence of verifier.error");
@@ -5,6 +5,11 @@
 // call. Instead, it simply selects those functions whose signatures
 // match.
 //
+// With --devirt-functions-with-dsa the targets are further restricted
+// to the functions that sea-dsa says the called pointer may point
+// to. Call sites without complete points-to information (e.g., the
+// pointer escapes to external code) fall back to signature match.
+//
 //===----------------------------------------------------------------------===//
 
 
@@ -27,9 +32,13 @@
 #include "llvm/ADT/Statistic.h"
 
 #include "seahorn/Transforms/Utils/Local.hh"
+#include "sea_dsa/DsaAnalysis.hh"
 
 #include "avy/AvyDebug.h"
 
+#include <map>
+#include <vector>
+
 using namespace llvm;
 
 static llvm::cl::opt<bool>
@@ -38,6 +47,18 @@ AllowIndirectCalls ("allow-indirect-calls",
                                     "during devirtualization "
                                     "(required for soundness)"),
                     llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+ResolveWithDsa ("devirt-functions-with-dsa",
+                llvm::cl::desc ("Resolve indirect calls using sea-dsa "
+                                "points-to sets (fall back to types)"),
+                llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+PrintFanOut ("devirt-functions-print-fanout",
+             llvm::cl::desc ("Print the number of targets of each "
+                             "devirtualized call site"),
+             llvm::cl::init (false));
 namespace
 {
 
@@ -64,9 +85,13 @@ namespace
 
     typedef const llvm::PointerType *AliasSetId;
     typedef SmallVector<const Function *, 8> AliasSet;
+    /// a bounce function is determined by its type and its targets
+    typedef std::pair<AliasSetId, std::vector<const Function*> > BounceId;
 
     // Call graph of the program
     CallGraph * CG;    
+    // Points-to information (only with --devirt-functions-with-dsa)
+    sea_dsa::DsaInfo *m_dsa;
 
     // Worklist of call sites to transform
     SmallVector<Instruction*, 32> m_worklist;
@@ -74,13 +99,16 @@ namespace
     /// map from alias-id to the corresponding alias set
     DenseMap<AliasSetId, AliasSet> m_aliasSets;
     
-    /// maps alias set id to an existing bounce function
-    DenseMap<AliasSetId, Function*> m_bounceMap;
+    /// maps a set of targets to an existing bounce function
+    std::map<BounceId, Function*> m_bounceMap;
     
     /// turn the indirect call-site into a direct one
     void mkDirectCall (CallSite CS);
     /// create a bounce function that calls functions directly
-    Function* mkBounceFn (CallSite &CS);
+    Function* mkBounceFn (CallSite &CS, const AliasSet &Targets);
+    /// possible targets of an indirect call site. Returns false if
+    /// there is nothing to resolve the call with
+    bool getTargets (CallSite &CS, AliasSet &Targets);
     
     
     /// returns an AliasId of the called value
@@ -101,7 +129,7 @@ namespace
     
    public:
     static char ID;
-    DevirtualizeFunctions() : ModulePass(ID), CG (nullptr) {}
+    DevirtualizeFunctions() : ModulePass(ID), CG (nullptr), m_dsa (nullptr) {}
     
     virtual bool runOnModule(Module & M);
     
@@ -110,6 +138,7 @@ namespace
       AU.setPreservesAll ();
       AU.addRequired<CallGraphWrapperPass> ();
       AU.addPreserved<CallGraphWrapperPass> ();
+      if (ResolveWithDsa) AU.addRequired<sea_dsa::DsaInfoPass> ();
     }
     
     // -- VISITOR IMPLEMENTATION --
@@ -137,6 +166,9 @@ namespace
   // Pass statistics
   STATISTIC(FuncAdded, "Number of bounce functions added");
   STATISTIC(CSConvert, "Number of call sites resolved");
+  STATISTIC(CSDsa, "Number of call sites resolved using points-to sets");
+  STATISTIC(NumTypeTargets, "Number of targets of resolved call sites by type");
+  STATISTIC(NumTargets, "Number of targets of resolved call sites");
 
   static inline PointerType * getVoidPtrType (LLVMContext & C)
   {
@@ -161,25 +193,71 @@ namespace
     return CastInst::CreateZExtOrBitCast (V, Ty, Name, InsertPt);
   }
 
+  bool DevirtualizeFunctions::getTargets (CallSite &CS, AliasSet &Targets)
+  {
+    AliasSetId id = typeAliasId (CS);
+    // -- no direct calls in this alias set, nothing to construct
+    if (m_aliasSets.count (id) <= 0) return false;
+    const AliasSet &TypeTargets = m_aliasSets [id];
+
+    Targets.clear ();
+    if (m_dsa)
+    {
+      const Function &F = *CS.getInstruction ()->getParent ()->getParent ();
+      const Value &ptr = *CS.getCalledValue ();
+      sea_dsa::Graph *g = m_dsa->getDsaGraph (F);
+      const sea_dsa::Node *n = g && g->hasCell (ptr) ? g->getCell (ptr).getNode () : nullptr;
+      // -- the allocation sites of a node that external code or casts
+      // -- from integers can reach are only a lower bound
+      if (n && !n->isExternal () && !n->isIncomplete () &&
+          !n->isIntToPtr () && !n->isCollapsed ())
+      {
+        SmallPtrSet<const Value*, 16> sites;
+        for (const Value *v : n->getAllocSites ())
+          sites.insert (v->stripPointerCasts ());
+
+        // -- keep the order of the type alias set so that bounce
+        // -- functions of equal target sets are shared
+        for (const Function *f : TypeTargets)
+          if (sites.count (f) > 0) Targets.push_back (f);
+      }
+    }
+
+    // -- no points-to information, fall back to type
+    if (Targets.empty ())
+      Targets.assign (TypeTargets.begin (), TypeTargets.end ());
+    else
+      ++CSDsa;
+
+    NumTypeTargets += TypeTargets.size ();
+    NumTargets += Targets.size ();
+
+    if (PrintFanOut)
+    {
+      const Function &F = *CS.getInstruction ()->getParent ()->getParent ();
+      errs () << "devirt: " << F.getName () << ": "
+              << *CS.getInstruction () << " : "
+              << TypeTargets.size () << " -> " << Targets.size ()
+              << " targets\n";
+    }
+    return true;
+  }
+
   /**
    * Creates a bounce function that calls functions in an alias set directly
    */
-  Function* DevirtualizeFunctions::mkBounceFn (CallSite &CS)
+  Function* DevirtualizeFunctions::mkBounceFn (CallSite &CS,
+                                               const AliasSet &Targets)
   {
-    ++FuncAdded;
-
-    AliasSetId id = typeAliasId (CS);
+    assert (isIndirectCall (CS) && "Not an indirect call");
+    BounceId id (typeAliasId (CS),
+                 std::vector<const Function*> (Targets.begin (), Targets.end ()));
     {
-      assert (isIndirectCall (CS) && "Not an indirect call");
       auto it = m_bounceMap.find (id);
       if (it != m_bounceMap.end ()) return it->second;
     }
-    
-    // -- no direct calls in this alias set, nothing to construct
-    if (m_aliasSets.count (id) <= 0) return nullptr;
-    
-    AliasSet &Targets = m_aliasSets [id];
-    
+
+    ++FuncAdded;
 
     LOG("devirt",
         errs () << "Building a bounce for call site:\n"
@@ -319,7 +397,9 @@ namespace
 
   void DevirtualizeFunctions::mkDirectCall (CallSite CS)
   {
-    const Function *bounceFn = mkBounceFn (CS);
+    AliasSet Targets;
+    const Function *bounceFn = getTargets (CS, Targets) ?
+      mkBounceFn (CS, Targets) : nullptr;
     // -- something failed
     LOG("devirt", if (!bounceFn)
                     errs () << "No bounce function for: "
@@ -410,6 +490,8 @@ namespace
   {
     // -- Get the call graph
     CG = &(getAnalysis<CallGraphWrapperPass> ().getCallGraph ());
+    if (ResolveWithDsa)
+      m_dsa = &getAnalysis<sea_dsa::DsaInfoPass> ().getDsaInfo ();
 
     // -- Create alias sets
     for (auto const &F: M)
@@ -448,6 +530,12 @@ namespace
       mkDirectCall (CS);
     }
 
+    if (PrintFanOut)
+      errs () << "devirt: " << CSConvert << " call sites ("
+              << CSDsa << " by points-to), "
+              << NumTypeTargets << " -> " << NumTargets << " targets, "
+              << m_bounceMap.size () << " bounce functions\n";
+
     // Conservatively assume that we've changed one or more call sites.
     return Changed;
   }
@@ -1,8 +1,22 @@
 #include "seahorn/Bmc.hh"
 #include "seahorn/UfoSymExec.hh"
+#include "seahorn/Support/ResourceGovernor.hh"
+
+#include "llvm/Support/CommandLine.h"
+#include "ufo/Stats.hh"
 
 #include "boost/container/flat_set.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+static llvm::cl::opt<unsigned>
+CoreTimeout ("horn-bmc-core-timeout",
+             llvm::cl::desc ("Time budget of unsat core minimization "
+                             "in seconds (0 = no budget)"),
+             llvm::cl::init (0));
+
 namespace seahorn
 {
   /// computes an implicant of f (interpreted as a conjunction) that
@@ -55,6 +69,7 @@ namespace seahorn
         m_states.push_back (m_states.back ());
         SymStore &s = m_states.back ();
         sexec.execCpEdg (s, *edg, m_side);
+        m_sideEnd.push_back (m_side.size ());
       }
       prev = cp;
     }
@@ -71,60 +86,233 @@ namespace seahorn
     m_smt_solver.reset ();
 
     m_side.clear ();
+    m_sideEnd.clear ();
     m_states.clear ();
     m_edges.clear ();
   }
   
   
+  namespace
+  {
+    /// Bounds the checks of a solver by a deadline while in scope.
+    /// Every check gets the time that is left. 0 means no bound
+    class ScopedDeadline
+    {
+      typedef std::chrono::steady_clock clock_type;
+
+      ufo::ZSolver<ufo::EZ3> &m_solver;
+      bool m_set;
+      clock_type::time_point m_deadline;
+
+      void set (unsigned ms)
+      {
+        ufo::ZParams<ufo::EZ3> params (m_solver.getContext ());
+        params.set (":timeout", ms);
+        m_solver.set (params);
+      }
+
+    public:
+      ScopedDeadline (ufo::ZSolver<ufo::EZ3> &solver, unsigned seconds) :
+        m_solver (solver), m_set (seconds > 0),
+        m_deadline (clock_type::now () + std::chrono::seconds (seconds)) {}
+      ~ScopedDeadline ()
+      { if (m_set) set (std::numeric_limits<unsigned>::max ()); }
+
+      bool expired () const
+      { return m_set && clock_type::now () >= m_deadline; }
+
+      /// Bounds the next check by the time that is left. False if
+      /// there is none
+      bool bound ()
+      {
+        if (!m_set) return true;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>
+          (m_deadline - clock_type::now ()).count ();
+        if (left <= 0) return false;
+        set ((unsigned) left);
+        return true;
+      }
+    };
+
+    /**
+     * Minimal unsat subsets of groups of assumption literals, by
+     * QuickXplain: a subset of k out of n groups takes O(k log(n/k))
+     * checks instead of n. All checks are assumptions on the same
+     * solver. Once the budget runs out no check is made, and every
+     * group that is left is kept, so the result is always unsat but
+     * may not be minimal.
+     */
+    class CoreMinimizer
+    {
+      ufo::ZSolver<ufo::EZ3> &m_solver;
+      const std::vector<ExprVector> &m_groups;
+      /// literals assumed in every check
+      ExprVector m_base;
+
+      ScopedDeadline &m_deadline;
+      unsigned m_checks;
+
+      bool expired () const
+      {
+        return m_deadline.expired () || ResourceGovernor::get ().exceeded ();
+      }
+
+      /// true if the base is unsat. Unknown counts as sat
+      bool unsat ()
+      {
+        if (expired () || !m_deadline.bound ()) return false;
+        ++m_checks;
+        boost::tribool res = m_solver.solveAssuming (m_base);
+        return !res ? true : false;
+      }
+
+      void assume (const std::vector<unsigned> &groups)
+      {
+        for (unsigned g : groups)
+          m_base.insert (m_base.end (), m_groups [g].begin (), m_groups [g].end ());
+      }
+
+      /// A minimal subset of cands that is unsat with the base, given
+      /// that the base with all of cands is unsat. delta is false if
+      /// the base is known to be sat
+      void qx (bool delta, const std::vector<unsigned> &cands,
+               std::vector<unsigned> &out)
+      {
+        if (delta && unsat ()) return;
+        if (cands.size () == 1 || expired ())
+        {
+          out.insert (out.end (), cands.begin (), cands.end ());
+          return;
+        }
+
+        auto mid = cands.begin () + cands.size () / 2;
+        std::vector<unsigned> c1 (cands.begin (), mid), c2 (mid, cands.end ());
+        size_t mark = m_base.size ();
+
+        std::vector<unsigned> d2;
+        assume (c1);
+        qx (true, c2, d2);
+        m_base.resize (mark);
+
+        std::vector<unsigned> d1;
+        assume (d2);
+        qx (!d2.empty (), c1, d1);
+        m_base.resize (mark);
+
+        out.insert (out.end (), d1.begin (), d1.end ());
+        out.insert (out.end (), d2.begin (), d2.end ());
+      }
+
+    public:
+      CoreMinimizer (ufo::ZSolver<ufo::EZ3> &solver,
+                     const std::vector<ExprVector> &groups,
+                     ScopedDeadline &deadline) :
+        m_solver (solver), m_groups (groups),
+        m_deadline (deadline), m_checks (0) {}
+
+      /// minimal subset of cands that is unsat. The union of cands must
+      /// be unsat
+      void run (const std::vector<unsigned> &cands, std::vector<unsigned> &out)
+      {
+        m_base.clear ();
+        if (!cands.empty ()) qx (false, cands, out);
+        std::sort (out.begin (), out.end ());
+      }
+
+      unsigned checks () const { return m_checks; }
+    };
+  }
+
   void BmcEngine::unsatCore (ExprVector &out)
   {
-    // -- re-assert the path-condition with assumptions
+    SmallVector<unsigned, 8> edges;
+    unsatCore (out, edges);
+  }
+
+  void BmcEngine::unsatCore (ExprVector &out, SmallVectorImpl<unsigned> &edges)
+  {
+    ufo::ScopedStats _st ("BmcEngine.unsatCore");
+
+    // -- re-assert the path-condition with assumptions, once for all
+    //    the checks below
     m_smt_solver.reset ();
+    ScopedDeadline deadline (m_smt_solver, CoreTimeout);
+
     ExprVector assumptions;
     assumptions.reserve (m_side.size ());
+    std::map<Expr, unsigned> index;
     for (Expr v : m_side)
     {
+      index.insert (std::make_pair (v, assumptions.size ()));
       Expr a = bind::boolConst (mk<ASM> (v));
       assumptions.push_back (a);
       m_smt_solver.assertExpr (mk<IMPL> (a, v));
     }
-    
+
     ExprVector core;
-    m_smt_solver.push ();
+    if (!deadline.bound ()) return;
     boost::tribool res = m_smt_solver.solveAssuming (assumptions);
-    if (!res) m_smt_solver.unsatCore (std::back_inserter (core));
-    m_smt_solver.pop ();
-    if (res) return;
+    if (res || boost::indeterminate (res)) return;
+    m_smt_solver.unsatCore (std::back_inserter (core));
 
-    
-    // simplify core
-    while (core.size () < assumptions.size ())
-    {
-      assumptions.assign (core.begin (), core.end ());
-      core.clear ();
-      m_smt_solver.push ();
-      res = m_smt_solver.solveAssuming (assumptions);
-      assert (!res ? 1 : 0);
-      m_smt_solver.unsatCore (std::back_inserter (core));
-      m_smt_solver.pop ();
-    }    
-    
-    // minimize simplified core
-    for (unsigned i = 0; i < core.size ();)
+    // -- the constraints of the first core, unwrapped from ASM
+    std::vector<bool> inCore (m_side.size (), false);
+    for (Expr c : core)
+      inCore [index [bind::fname (bind::fname (c))->arg (0)]] = true;
+
+    // -- edge of a constraint
+    auto edgeOf = [this] (unsigned i)
+      {
+        return std::upper_bound (m_sideEnd.begin (), m_sideEnd.end (), i) -
+          m_sideEnd.begin ();
+      };
+
+    // -- coarse: one group per edge, with the constraints of the core
+    std::vector<ExprVector> edgeGroups (m_edges.size ());
+    std::vector<std::vector<unsigned> > edgeSide (m_edges.size ());
+    for (unsigned i = 0; i < m_side.size (); ++i)
+      if (inCore [i])
+      {
+        edgeGroups [edgeOf (i)].push_back (assumptions [i]);
+        edgeSide [edgeOf (i)].push_back (i);
+      }
+
+    std::vector<unsigned> cands, keep;
+    for (unsigned e = 0; e < edgeGroups.size (); ++e)
+      if (!edgeGroups [e].empty ()) cands.push_back (e);
+
+    CoreMinimizer edgeMin (m_smt_solver, edgeGroups, deadline);
+    edgeMin.run (cands, keep);
+    ufo::Stats::uset ("BmcCoreEdgeChecks", edgeMin.checks ());
+
+    // -- fine: one group per constraint of the kept edges
+    std::vector<ExprVector> litGroups;
+    std::vector<unsigned> litIdx;
+    for (unsigned e : keep)
+      for (unsigned i : edgeSide [e])
+      {
+        litGroups.push_back (ExprVector (1, assumptions [i]));
+        litIdx.push_back (i);
+      }
+
+    cands.clear ();
+    for (unsigned i = 0; i < litGroups.size (); ++i) cands.push_back (i);
+    std::vector<unsigned> lits;
+    CoreMinimizer litMin (m_smt_solver, litGroups, deadline);
+    litMin.run (cands, lits);
+    ufo::Stats::uset ("BmcCoreLitChecks", litMin.checks ());
+    ufo::Stats::uset ("BmcCoreSize", lits.size ());
+
+    // -- report in trace order
+    std::vector<unsigned> sideIdx;
+    for (unsigned l : lits) sideIdx.push_back (litIdx [l]);
+    std::sort (sideIdx.begin (), sideIdx.end ());
+    for (unsigned i : sideIdx)
     {
-      Expr saved = core [i];
-      core [i] = core.back ();
-      res = m_smt_solver.solveAssuming 
-        (boost::make_iterator_range (core.begin (), core.end () - 1));
-      if (res) core [i++] = saved;
-      else if (!res)
-        core.pop_back ();
-      else assert (0);
+      out.push_back (m_side [i]);
+      unsigned e = edgeOf (i);
+      if (edges.empty () || edges.back () != e) edges.push_back (e);
     }
-    
-    // unwrap the core from ASM to corresponding expressions
-    for (Expr c : core)
-      out.push_back (bind::fname (bind::fname (c))->arg (0));
   }
   
   BmcTrace BmcEngine::getTrace ()
@@ -218,10 +406,63 @@ namespace seahorn
                        const llvm::Value &val,
                        bool complete) 
   {
+    auto key = std::make_tuple (loc, &val, complete);
+    auto it = m_values.find (key);
+    if (it != m_values.end ()) return it->second;
+
     Expr v = symb (loc, val);
     if (v) v = m_model.eval (v, complete);
+    m_values [key] = v;
     return v;
   }
+
+  void BmcTrace::eval (const std::vector<Point> &pts, ExprVector &out,
+                       bool complete)
+  {
+    // -- symbolic values that are not memoized yet
+    ExprVector terms;
+    std::vector<unsigned> pending;
+    for (unsigned i = 0, sz = pts.size (); i < sz; ++i)
+    {
+      auto key = std::make_tuple (pts[i].first, pts[i].second, complete);
+      if (m_values.count (key) > 0) continue;
+
+      Expr v = symb (pts[i].first, *pts[i].second);
+      m_values [key] = Expr ();
+      if (!v) continue;
+      terms.push_back (v);
+      pending.push_back (i);
+    }
+
+    ExprVector vals;
+    m_model.eval (terms, vals, complete);
+    for (unsigned i = 0, sz = pending.size (); i < sz; ++i)
+    {
+      const Point &pt = pts [pending [i]];
+      m_values [std::make_tuple (pt.first, pt.second, complete)] = vals [i];
+    }
+
+    out.clear ();
+    for (const Point &pt : pts)
+      out.push_back (m_values [std::make_tuple (pt.first, pt.second, complete)]);
+  }
+
+  void BmcTrace::evalLoc (unsigned loc, bool complete)
+  {
+    std::vector<Point> pts;
+    for (const Instruction &I : *bb (loc)) pts.push_back (Point (loc, &I));
+    ExprVector vals;
+    eval (pts, vals, complete);
+  }
+
+  void BmcTrace::evalAll (bool complete)
+  {
+    std::vector<Point> pts;
+    for (unsigned loc = 0; loc < size (); ++loc)
+      for (const Instruction &I : *bb (loc)) pts.push_back (Point (loc, &I));
+    ExprVector vals;
+    eval (pts, vals, complete);
+  }
   
   Expr BmcTrace::eval (unsigned loc,
                        Expr u, 
@@ -50,6 +50,11 @@ namespace seahorn
     Harness->setDataLayout (dl);
     ValueMap<const Function*, ExprVector> FuncValueMap;
 
+    // Calls that need a harness, in the order of the trace. Their
+    // values are evaluated in one batch
+    std::vector<BmcTrace::Point> points;
+    std::vector<const Function*> callees;
+
     // Look for calls in the trace
     for (unsigned loc = 0; loc < trace.size(); loc++)
     {
@@ -96,15 +101,22 @@ namespace seahorn
           if (tli.getLibFunc (CF->getName(), libfn)) continue;
 
 
-          Expr V = trace.eval (loc, I, true);
-          if (!V) continue;
-          LOG("cex",
-	      errs () << "Producing harness for " << CF->getName () << "\n";);
-          FuncValueMap[CF].push_back(V);
+          points.push_back (BmcTrace::Point (loc, &I));
+          callees.push_back (CF);
         }
       }
     }
 
+    ExprVector values;
+    trace.eval (points, values, true);
+    for (unsigned i = 0, sz = values.size (); i < sz; ++i)
+    {
+      if (!values [i]) continue;
+      LOG("cex",
+          errs () << "Producing harness for " << callees [i]->getName () << "\n";);
+      FuncValueMap[callees [i]].push_back(values [i]);
+    }
+
     // Build harness functions
     for (auto CFV : FuncValueMap) {
 
@@ -0,0 +1,177 @@
+#include "seahorn/CexReplay.hh"
+#include "seahorn/CexHarness.hh"
+#include "seahorn/Passes.hh"
+
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include "avy/AvyDebug.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+  using namespace llvm;
+
+  /// exit codes of the replay process
+  enum
+  {
+    EXIT_REACHED = 42,
+    EXIT_NOT_REACHED = 43,
+    EXIT_ASSUME = 44,
+    EXIT_JIT = 45
+  };
+
+  /// -- run-time of the replayed program. See sea-rt/seahorn.cpp
+  void rtError () { _exit (EXIT_REACHED); }
+  // -- i1 arguments are only defined in the lowest bit
+  void rtAssume (int c) { if (!(c & 1)) _exit (EXIT_ASSUME); }
+  void rtAssumeNot (int c) { if (c & 1) _exit (EXIT_ASSUME); }
+  void rtNop () {}
+
+  template <typename T>
+  T rtGetValue (int ctr, T *arr, int sz)
+  {
+    // -- the program left the trace. Any value will do
+    return ctr < sz ? arr [ctr] : T ();
+  }
+  int8_t rtGetBool (int ctr, int8_t *arr, int sz)
+  { return rtGetValue (ctr, arr, sz) & 1; }
+  intptr_t rtGetPtr (int ctr, intptr_t *arr, int sz, int ebits)
+  { return rtGetValue (ctr, arr, sz); }
+
+  void addSymbols ()
+  {
+    sys::DynamicLibrary::LoadLibraryPermanently (nullptr);
+
+    sys::DynamicLibrary::AddSymbol ("verifier.error", (void*) &rtError);
+    sys::DynamicLibrary::AddSymbol ("seahorn.fail", (void*) &rtError);
+    sys::DynamicLibrary::AddSymbol ("__VERIFIER_error", (void*) &rtError);
+    sys::DynamicLibrary::AddSymbol ("verifier.assume", (void*) &rtAssume);
+    sys::DynamicLibrary::AddSymbol ("__VERIFIER_assume", (void*) &rtAssume);
+    sys::DynamicLibrary::AddSymbol ("verifier.assume.not", (void*) &rtAssumeNot);
+    sys::DynamicLibrary::AddSymbol ("seahorn.fn.enter", (void*) &rtNop);
+
+    sys::DynamicLibrary::AddSymbol ("__seahorn_get_value_i1", (void*) &rtGetBool);
+    sys::DynamicLibrary::AddSymbol ("__seahorn_get_value_i8",
+                                    (void*) &rtGetValue<int8_t>);
+    sys::DynamicLibrary::AddSymbol ("__seahorn_get_value_i16",
+                                    (void*) &rtGetValue<int16_t>);
+    sys::DynamicLibrary::AddSymbol ("__seahorn_get_value_i32",
+                                    (void*) &rtGetValue<int32_t>);
+    sys::DynamicLibrary::AddSymbol ("__seahorn_get_value_i64",
+                                    (void*) &rtGetValue<int64_t>);
+    sys::DynamicLibrary::AddSymbol ("__seahorn_get_value_ptr", (void*) &rtGetPtr);
+  }
+
+  /// Compiles and runs main. Never returns
+  void runChild (std::unique_ptr<Module> M, unsigned timeout)
+  {
+    // -- the default action of SIGALRM terminates the process
+    signal (SIGALRM, SIG_DFL);
+    if (timeout > 0) alarm (timeout);
+
+    InitializeNativeTarget ();
+    InitializeNativeTargetAsmPrinter ();
+    addSymbols ();
+
+    std::string err;
+    std::unique_ptr<ExecutionEngine> ee
+      (EngineBuilder (std::move (M))
+       .setErrorStr (&err)
+       .setEngineKind (EngineKind::JIT)
+       .setMCJITMemoryManager (make_unique<SectionMemoryManager> ())
+       .create ());
+    if (!ee)
+    {
+      errs () << "ERROR: cex replay: " << err << "\n";
+      _exit (EXIT_JIT);
+    }
+
+    Function *main = ee->FindFunctionNamed ("main");
+    if (!main) _exit (EXIT_JIT);
+    ee->finalizeObject ();
+    ee->runStaticConstructorsDestructors (false);
+
+    std::vector<std::string> argv = {"cex"};
+    ee->runFunctionAsMain (main, argv, nullptr);
+    _exit (EXIT_NOT_REACHED);
+  }
+}
+
+namespace seahorn
+{
+  ReplayResult replayCex (const Module &M, BmcTrace &trace,
+                          const DataLayout &dl, const TargetLibraryInfo &tli,
+                          unsigned timeout)
+  {
+    std::unique_ptr<Module> prog (CloneModule (&M));
+    {
+      legacy::PassManager pm;
+      pm.add (createStripShadowMemPass ());
+      pm.run (*prog);
+    }
+
+    // -- the harness defines the external functions that the trace
+    // -- calls. Their declarations in prog are resolved by linking
+    std::unique_ptr<Module> harness = createCexHarness (trace, dl, tli);
+    if (Linker::linkModules (*prog, std::move (harness)) ||
+        verifyModule (*prog, &errs ()))
+    {
+      errs () << "WARNING: cex replay: could not link the harness\n";
+      return REPLAY_ERROR;
+    }
+
+    // -- flush buffered output so that the child does not repeat it
+    outs ().flush ();
+    errs ().flush ();
+
+    pid_t pid = fork ();
+    if (pid < 0) return REPLAY_ERROR;
+    if (pid == 0) runChild (std::move (prog), timeout);
+
+    int status;
+    while (waitpid (pid, &status, 0) < 0)
+      if (errno != EINTR) return REPLAY_ERROR;
+
+    LOG ("cex",
+         errs () << "cex replay: process finished with status " << status << "\n";);
+
+    if (WIFSIGNALED (status))
+      return WTERMSIG (status) == SIGALRM ? REPLAY_TIMEOUT : REPLAY_CRASHED;
+    if (!WIFEXITED (status)) return REPLAY_ERROR;
+
+    switch (WEXITSTATUS (status))
+    {
+    case EXIT_REACHED: return REPLAY_REACHED;
+    case EXIT_ASSUME: return REPLAY_ASSUME_FAILED;
+    case EXIT_JIT: return REPLAY_ERROR;
+    default: return REPLAY_NOT_REACHED;
+    }
+  }
+
+  const char *replayResultStr (ReplayResult r)
+  {
+    switch (r)
+    {
+    case REPLAY_REACHED: return "REACHED";
+    case REPLAY_NOT_REACHED: return "NOT_REACHED";
+    case REPLAY_ASSUME_FAILED: return "ASSUME_FAILED";
+    case REPLAY_TIMEOUT: return "TIMEOUT";
+    case REPLAY_CRASHED: return "CRASHED";
+    case REPLAY_ERROR: return "ERROR";
+    }
+    return "ERROR";
+  }
+}
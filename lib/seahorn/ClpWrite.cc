@@ -8,6 +8,13 @@
 #include "avy/AvyDebug.h"
 #include <unordered_map>
 
+static llvm::cl::opt<bool>
+ShareClpSubterms ("horn-clp-share",
+                  llvm::cl::desc ("Define shared sub-formulas as auxiliary predicates "
+                                  "instead of printing them at every occurrence"),
+                  llvm::cl::init (true),
+                  llvm::cl::Hidden);
+
 static llvm::cl::opt<bool>
 PrintClpFapp ("horn-clp-fapp",
               llvm::cl::desc ("Print function applications in CLP format"), 
@@ -68,7 +75,7 @@ namespace seahorn
 
     bool empty () const { return m_s.empty (); }
 
-    void print (ostream& o) const { o << m_s ; }
+    void print (raw_ostream& o) const { o << m_s ; }
 
     string str () const { return m_s; }
 
@@ -359,7 +366,7 @@ namespace seahorn
   void ClpWrite::ClpRule::normalize () 
   { m_body = op::boolop::gather (op::boolop::nnf (m_body)); }
 
-  void ClpWrite::ClpRule::print (ostream &o) const 
+  void ClpWrite::ClpRule::print (raw_ostream &o) const 
   {        
 
     expr_str_map seen, cache;
@@ -399,31 +406,107 @@ namespace seahorn
 
 
   ClpWrite::ClpWrite (HornClauseDB &db, ExprFactory &efac): 
-    m_rels (db.getRelations ()), m_efac (efac)
-  {     
+    m_db (db), m_rels (db.getRelations ()), m_efac (efac), m_auxCount (0) {}
+
+  Expr ClpWrite::shareSubterms (Expr body, raw_ostream &o)
+  {
+    // -- count the parents of every node of the DAG and list the
+    // -- nodes in post-order so that kids are defined before parents
+    std::unordered_map<Expr, unsigned> refs;
+    ExprSet visited;
+    ExprVector post;
+    std::vector<std::pair<Expr, bool> > stack;
+    stack.push_back (std::make_pair (body, false));
+    while (!stack.empty ())
+    {
+      Expr e = stack.back ().first;
+      bool done = stack.back ().second;
+      stack.pop_back ();
+      if (done) { post.push_back (e); continue; }
+      if (!visited.insert (e).second) continue;
+
+      stack.push_back (std::make_pair (e, true));
+      // -- terms other than and/or are printed as they are
+      if (!isOpX<AND> (e) && !isOpX<OR> (e)) continue;
+      for (auto it = e->args_begin (), end = e->args_end (); it != end; ++it)
+      {
+        ++refs [Expr (*it)];
+        stack.push_back (std::make_pair (Expr (*it), false));
+      }
+    }
+
+    for (Expr e : post)
+    {
+      if (e == body || m_aux.count (e) > 0) continue;
+      if (!isOpX<AND> (e) && !isOpX<OR> (e)) continue;
+      if (refs [e] <= 1) continue;
+
+      ExprVector consts;
+      filter (e, bind::IsConst (), std::back_inserter (consts));
+      ExprVector vars, sorts;
+      ExprSet seen;
+      for (Expr c : consts)
+      {
+        if (m_rels.count (bind::fname (c)) > 0) continue;
+        if (!seen.insert (c).second) continue;
+        vars.push_back (c);
+        sorts.push_back (bind::typeOf (c));
+      }
+      // -- ground formulas are cheap to repeat
+      if (vars.empty ()) continue;
+      sorts.push_back (mk<BOOL_TY> (m_efac));
+
+      Expr name = mkTerm<std::string>
+        ("aux__" + boost::lexical_cast<std::string> (m_auxCount++), m_efac);
+      Expr app = bind::fapp (bind::fdecl (name, sorts), vars);
+
+      // -- kids of e that are shared were defined earlier
+      ClpRule def (app, replace (e, m_aux), m_efac, m_rels);
+      def.print (o);
+      m_aux [e] = app;
+    }
+
+    return m_aux.empty () ? body : replace (body, m_aux);
+  }
 
-    for (auto q:  db.getQueries ())
+  void ClpWrite::write (ClpRule &rule, raw_ostream &o)
+  {
+    rule.normalize ();
+    if (ShareClpSubterms && !rule.isFact ())
+    {
+      ClpRule shared (rule.head (), shareSubterms (rule.body (), o),
+                      m_efac, m_rels);
+      shared.print (o);
+    }
+    else
+      rule.print (o);
+  }
+
+  void ClpWrite::write (raw_ostream &o)
+  {
+    for (auto q:  m_db.getQueries ())
     {
       // Added false <- query as another rule
       ClpRule query (mk<FALSE> (m_efac) , mk<TRUE> (m_efac), m_efac, m_rels);
       query.addBody (q);
-      m_rules.push_back (query);
+      write (query, o);
     }
 
-    for (auto & rule : db.getRules ())
+    for (auto & rule : m_db.getRules ())
     {
       // TODO: add constraints
       Expr inv = mk<TRUE> (m_efac); // db.getConstraints (replace_args_with_vars (f->right ()));
       ClpRule r (rule.head (), rule.body (), inv, m_efac, m_rels);      
-      r.normalize ();
-      m_rules.push_back (r);
+      write (r, o);
     }
+    o.flush ();
   }
 
-  string ClpWrite::toString () const
+  string ClpWrite::toString ()
   {
-    std::ostringstream oss;
-    for (auto &rule : m_rules) { rule.print (oss); }
+    std::string res;
+    raw_string_ostream oss (res);
+    write (oss);
     return oss.str ();
   }
 }
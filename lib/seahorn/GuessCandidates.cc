@@ -2,10 +2,34 @@
 #include "ufo/Expr.hpp"
 #include "ufo/Smt/Z3n.hpp"
 #include "ufo/Smt/EZ3.hh"
+#include "ufo/Stats.hh"
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <thread>
 #include <boost/tokenizer.hpp>
 
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ThreadPool.h"
+
+static llvm::cl::opt<unsigned>
+CandMax ("horn-cand-max",
+         llvm::cl::desc ("Maximum number of template candidates of a relation"),
+         llvm::cl::init (100), llvm::cl::Hidden);
+
+static llvm::cl::opt<unsigned>
+CandConsts ("horn-cand-consts",
+            llvm::cl::desc ("Number of constants mined from the rules "
+                            "for template candidates"),
+            llvm::cl::init (16), llvm::cl::Hidden);
+
+static llvm::cl::opt<unsigned>
+CandJobs ("horn-cand-jobs",
+          llvm::cl::desc ("Threads that instantiate template candidates "
+                          "(0 means one per core)"),
+          llvm::cl::init (1), llvm::cl::Hidden);
+
 namespace seahorn
 {
   ExprVector applyTemplatesFromExperimentFile(Expr fdecl, const std::string &filepath)
@@ -193,4 +217,246 @@ namespace seahorn
     return bins;
   }
 
+  namespace
+  {
+    struct IsNum : public std::unary_function<Expr,bool>
+    {
+      bool operator() (Expr e) { return isOpX<MPZ> (e); }
+    };
+
+    /// si * x_i + sj * x_j <= k, or = k if eq. x_i and x_j are columns
+    /// of the samples. j < 0 if there is no x_j
+    struct LinCand
+    {
+      int i, j, si, sj;
+      bool eq;
+      long k;
+    };
+
+    /// -- larger values are not sampled, so sums cannot overflow
+    const long MAX_VAL = 1L << 40;
+
+    /// max of s * a over all samples
+    long maxOf (const std::vector<long> &a, int s)
+    {
+      long res = std::numeric_limits<long>::min ();
+      const long *pa = a.data ();
+      for (size_t n = 0, sz = a.size (); n < sz; ++n)
+        res = std::max (res, s * pa [n]);
+      return res;
+    }
+
+    /// max of si * a + sj * b over all samples
+    long maxOf (const std::vector<long> &a, int si,
+                const std::vector<long> &b, int sj)
+    {
+      long res = std::numeric_limits<long>::min ();
+      const long *pa = a.data (), *pb = b.data ();
+      for (size_t n = 0, sz = a.size (); n < sz; ++n)
+        res = std::max (res, si * pa [n] + sj * pb [n]);
+      return res;
+    }
+
+    /// Candidates over the columns of s, in the order intervals,
+    /// equalities, octagons. Returns the number of shapes that no
+    /// constant fits. Reads only its arguments, so it can run on any
+    /// thread
+    unsigned instantiate (const TemplateCands::Samples &s,
+                          const std::vector<long> &consts, unsigned max,
+                          std::vector<LinCand> &out)
+    {
+      bool sampled = s.size () > 0;
+      int n = s.args.size ();
+      unsigned pruned = 0;
+
+      auto bound = [&] (int i, int si, int j, int sj)
+      {
+        if (out.size () >= max) return;
+        if (!sampled)
+        {
+          for (long c : consts)
+          {
+            if (out.size () >= max) break;
+            out.push_back (LinCand {i, j, si, sj, false, c});
+          }
+          return;
+        }
+
+        long m = j < 0 ? maxOf (s.cols [i], si) : maxOf (s.cols [i], si, s.cols [j], sj);
+        // -- the tightest constant that holds in all states
+        auto it = std::lower_bound (consts.begin (), consts.end (), m);
+        if (it == consts.end ()) ++pruned;
+        else out.push_back (LinCand {i, j, si, sj, false, *it});
+      };
+
+      auto equal = [&] (int i, int j, long c)
+      {
+        if (out.size () >= max) return;
+        if (sampled)
+        {
+          bool holds = j < 0 ?
+            maxOf (s.cols [i], 1) == c && maxOf (s.cols [i], -1) == -c :
+            maxOf (s.cols [i], 1, s.cols [j], -1) == 0 &&
+            maxOf (s.cols [i], -1, s.cols [j], 1) == 0;
+          if (!holds) { ++pruned; return; }
+        }
+        out.push_back (LinCand {i, j, 1, j < 0 ? 0 : -1, true, c});
+      };
+
+      for (int i = 0; i < n; ++i)
+      {
+        bound (i, 1, -1, 0);
+        bound (i, -1, -1, 0);
+      }
+      for (int i = 0; i < n; ++i)
+        for (long c : consts) equal (i, -1, c);
+      for (int i = 0; i < n; ++i)
+        for (int j = i + 1; j < n; ++j) equal (i, j, 0);
+      for (int i = 0; i < n; ++i)
+        for (int j = i + 1; j < n; ++j)
+          for (int si = -1; si <= 1; si += 2)
+            for (int sj = -1; sj <= 1; sj += 2)
+              bound (i, si, j, sj);
+      return pruned;
+    }
+
+    Expr toExpr (const LinCand &c, const ExprVector &vars, ExprFactory &efac)
+    {
+      Expr k = mkTerm<mpz_class> (mpz_class (c.k), efac);
+      Expr negk = mkTerm<mpz_class> (mpz_class (-c.k), efac);
+      Expr x = vars [c.i];
+      if (c.j < 0)
+      {
+        if (c.eq) return mk<EQ> (x, k);
+        return c.si > 0 ? mk<LEQ> (x, k) : mk<GEQ> (x, negk);
+      }
+
+      Expr y = vars [c.j];
+      if (c.eq) return mk<EQ> (x, y);
+      if (c.si > 0 && c.sj > 0) return mk<LEQ> (mk<PLUS> (x, y), k);
+      if (c.si > 0) return mk<LEQ> (mk<MINUS> (x, y), k);
+      if (c.sj > 0) return mk<LEQ> (mk<MINUS> (y, x), k);
+      return mk<GEQ> (mk<PLUS> (x, y), negk);
+    }
+  }
+
+  TemplateCands::TemplateCands (HornClauseDB &db) : m_db (db)
+  {
+    std::set<mpz_class> consts;
+    consts.insert (0);
+    consts.insert (1);
+    consts.insert (-1);
+    for (const HornRule &r : db.getRules ())
+    {
+      ExprVector nums;
+      filter (r.body (), IsNum (), std::back_inserter (nums));
+      for (Expr n : nums)
+      {
+        mpz_class v = getTerm<mpz_class> (n);
+        consts.insert (v);
+        consts.insert (-v);
+      }
+    }
+
+    // -- keep the ones closest to zero
+    m_consts.assign (consts.begin (), consts.end ());
+    std::stable_sort (m_consts.begin (), m_consts.end (),
+                      [] (const mpz_class &a, const mpz_class &b)
+                      { return abs (a) < abs (b); });
+    if (m_consts.size () > std::max (3U, (unsigned) CandConsts))
+      m_consts.resize (std::max (3U, (unsigned) CandConsts));
+    std::sort (m_consts.begin (), m_consts.end ());
+  }
+
+  TemplateCands::Samples &TemplateCands::samples (Expr fdecl)
+  {
+    auto it = m_samples.find (fdecl);
+    if (it != m_samples.end ()) return it->second;
+
+    Samples &s = m_samples [fdecl];
+    for (unsigned i = 0, sz = bind::domainSz (fdecl); i < sz; ++i)
+      if (isOpX<INT_TY> (bind::domainTy (fdecl, i))) s.args.push_back (i);
+    s.cols.resize (s.args.size ());
+    return s;
+  }
+
+  void TemplateCands::addState (Expr state)
+  {
+    Samples &s = samples (bind::fname (state));
+    std::vector<long> vals;
+    for (unsigned a : s.args)
+    {
+      Expr v = state->arg (a + 1);
+      if (!isOpX<MPZ> (v)) return;
+      const mpz_class &z = getTerm<mpz_class> (v);
+      if (!z.fits_slong_p () || abs (z) > MAX_VAL) return;
+      vals.push_back (z.get_si ());
+    }
+    for (unsigned i = 0, sz = vals.size (); i < sz; ++i)
+      s.cols [i].push_back (vals [i]);
+  }
+
+  void TemplateCands::addSamples (Expr fdecl, const StateSamples &in)
+  {
+    Samples &s = samples (fdecl);
+    assert (in.args == s.args);
+    for (size_t n = 0, sz = in.size (); n < sz; ++n)
+    {
+      bool fits = true;
+      for (const std::vector<long> &c : in.cols)
+        fits = fits && std::labs (c [n]) <= MAX_VAL;
+      if (!fits) continue;
+      for (unsigned i = 0, k = in.cols.size (); i < k; ++i)
+        s.cols [i].push_back (in.cols [i][n]);
+    }
+  }
+
+  void TemplateCands::candidates (std::map<Expr, ExprVector> &out)
+  {
+    std::vector<long> consts;
+    for (const mpz_class &c : m_consts)
+      if (c.fits_slong_p ()) consts.push_back (c.get_si ());
+
+    ExprVector rels;
+    std::vector<const Samples*> smp;
+    for (Expr rel : m_db.getRelations ())
+    {
+      if (!bind::isFdecl (rel)) continue;
+      rels.push_back (rel);
+      smp.push_back (&samples (rel));
+    }
+
+    std::vector<std::vector<LinCand> > cands (rels.size ());
+    std::vector<unsigned> pruned (rels.size (), 0);
+    {
+      unsigned threads = CandJobs > 0 ?
+        (unsigned) CandJobs : std::thread::hardware_concurrency ();
+      llvm::ThreadPool pool (std::max (threads, 1U));
+      for (unsigned r = 0, sz = rels.size (); r < sz; ++r)
+        pool.async ([&, r] {
+            pruned [r] = instantiate (*smp [r], consts, CandMax, cands [r]);
+          });
+      pool.wait ();
+    }
+
+    // -- Exprs are built on this thread only
+    for (unsigned r = 0, sz = rels.size (); r < sz; ++r)
+    {
+      Expr rel = rels [r];
+      ExprVector vars;
+      for (unsigned a : smp [r]->args)
+        vars.push_back (bind::bvar (a, bind::domainTy (rel, a)));
+
+      ExprVector &res = out [rel];
+      for (const LinCand &c : cands [r])
+        res.push_back (toExpr (c, vars, rel->efac ()));
+      if (res.empty ()) res.push_back (mk<TRUE> (rel->efac ()));
+
+      for (unsigned i = 0, n = cands [r].size (); i < n; ++i)
+        Stats::count ("HornTemplateCands");
+      for (unsigned i = 0; i < pruned [r]; ++i)
+        Stats::count ("HornTemplateCandsPruned");
+    }
+  }
+
 }
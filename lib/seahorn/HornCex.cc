@@ -1,5 +1,6 @@
 #include "seahorn/HornCex.hh"
 #include "seahorn/CexHarness.hh"
+#include "seahorn/CexReplay.hh"
 
 #include "seahorn/MemSimulator.hh"
 
@@ -19,6 +20,7 @@
 #include "seahorn/Transforms/Utils/Local.hh"
 #include "seahorn/Bmc.hh"
 #include "seahorn/Support/CFG.hh"
+#include "seahorn/Support/ResourceGovernor.hh"
 
 #include "boost/range.hpp"
 #include "boost/range/adaptor/reversed.hpp"
@@ -74,6 +76,17 @@ SvCompCexFileArch("horn-svcomp-cex-arch",
                   llvm::cl::desc("Architecture key in SV-COMP XML format"),
                   llvm::cl::init("32bit"));
 
+static llvm::cl::opt<bool>
+CexReplay ("horn-cex-replay",
+           llvm::cl::desc ("Confirm counterexamples by running them natively. "
+                           "A confirmed cex skips bit-precise validation"),
+           llvm::cl::init (false));
+
+static llvm::cl::opt<unsigned>
+CexReplayTimeout ("horn-cex-replay-timeout",
+                  llvm::cl::desc ("Timeout of a cex replay in seconds (0 means none)"),
+                  llvm::cl::init (10));
+
 static llvm::cl::opt<std::string>
 HornCexSmtFilename("horn-cex-smt", llvm::cl::desc("Counterexample validate SMT problem"),
                llvm::cl::init(""), llvm::cl::value_desc("filename"), llvm::cl::Hidden);
@@ -93,6 +106,17 @@ namespace seahorn
 
   template <typename O> class SvCompCex;
   static void dumpSvCompCex (BmcTrace &trace, std::string CexFile);
+
+  /// Replays the trace natively and records the outcome. Returns
+  /// true if an error was reached
+  static bool replayTrace (const Module &M, BmcTrace &trace,
+                           const DataLayout &dl, const TargetLibraryInfo &tli)
+  {
+    ReplayResult r = replayCex (M, trace, dl, tli, CexReplayTimeout);
+    Stats::sset ("CexReplay", replayResultStr (r));
+    LOG ("cex", errs () << "cex replay: " << replayResultStr (r) << "\n";);
+    return r == REPLAY_REACHED;
+  }
   static void dumpLLVMCex (BmcTrace &trace, StringRef CexFile, const DataLayout &dl,
                            const TargetLibraryInfo &tli);
   static void dumpLLVMBitcode(const Module &M, StringRef BcFile);
@@ -119,9 +143,8 @@ namespace seahorn
     HornifyModule &hm = getAnalysis<HornifyModule> ();
     const CutPointGraph &cpg = getAnalysis<CutPointGraph> (F);
 
-    auto &fp = hs.getZFixedPoint ();
     ExprVector rules;
-    fp.getCexRules (rules);
+    hs.getCexRules (rules);
     boost::reverse (rules);
 
     // extract a trace of basic blocks corresponding to the counterexample
@@ -245,29 +268,70 @@ namespace seahorn
     UfoSmallSymExec semUfo (efac, *this, M.getDataLayout(), MEM);
     BvSmallSymExec semBv (efac, *this, M.getDataLayout(), MEM);
 
-    SmallStepSymExec *sem = UseBv ? static_cast<SmallStepSymExec*>(&semBv) :
-      static_cast<SmallStepSymExec*>(&semUfo);
-    BmcEngine bmc (*sem, hm.getZContext ());
+    // -- loads the trace into an engine and solves it
+    auto solveBmc = [&] (BmcEngine &bmc) -> boost::tribool
+    {
+      for (const CutPoint *cp : cpTrace)
+        bmc.addCutPoint (*cp);
 
-    // -- load the trace into the engine
-    for (const CutPoint *cp : cpTrace)
-      bmc.addCutPoint (*cp);
+      // -- construct BMC instance
+      bmc.encode ();
 
-    // -- construct BMC instance
-    bmc.encode ();
+      if (!HornCexSmtFilename.empty ())
+      {
+        std::error_code EC;
+        raw_fd_ostream file (HornCexSmtFilename, EC, sys::fs::F_Text);
+        if (!EC) bmc.toSmtLib (file);
+        else errs () << "Could not open: " << HornCexSmtFilename << "\n";
+      }
 
-    if (!HornCexSmtFilename.empty ())
+      boost::tribool res;
+      {
+        ScopedPhase _phase ("cex");
+        EZ3 &zctx = hm.getZContext ();
+        ResourceGovernor::get ().onInterrupt ([&zctx] { zctx.interrupt (); });
+        res = bmc.solve ();
+      }
+      LOG ("cex",
+           errs () << "BMC: "
+           << (res ? "sat" : (!res ? "unsat" : "unknown")) << "\n";);
+      return res;
+    };
+
+    const TargetLibraryInfo &tli =
+      getAnalysis<TargetLibraryInfoWrapperPass> ().getTLI();
+
+    // -- with replay, try the integer semantics first. A trace that
+    // -- is confirmed by running it needs no bit-precise validation
+    std::unique_ptr<BmcEngine> bmcPtr;
+    boost::tribool res;
+    bool confirmed = false;
+    if (CexReplay && UseBv)
     {
-      std::error_code EC;
-      raw_fd_ostream file (HornCexSmtFilename, EC, sys::fs::F_Text);
-      if (!EC) bmc.toSmtLib (file);
-      else errs () << "Could not open: " << HornCexSmtFilename << "\n";
+      bmcPtr.reset (new BmcEngine (semUfo, hm.getZContext ()));
+      res = solveBmc (*bmcPtr);
+      if (res)
+      {
+        BmcTrace itrace (bmcPtr->getTrace ());
+        confirmed = replayTrace (M, itrace, M.getDataLayout (), tli);
+      }
+      if (!confirmed) bmcPtr.reset ();
     }
 
-    auto res = bmc.solve ();
-    LOG ("cex",
-         errs () << "BMC: "
-         << (res ? "sat" : (!res ? "unsat" : "unknown")) << "\n";);
+    if (!bmcPtr)
+    {
+      SmallStepSymExec *sem = UseBv ? static_cast<SmallStepSymExec*>(&semBv) :
+        static_cast<SmallStepSymExec*>(&semUfo);
+      bmcPtr.reset (new BmcEngine (*sem, hm.getZContext ()));
+      res = solveBmc (*bmcPtr);
+    }
+    BmcEngine &bmc = *bmcPtr;
+
+    if (boost::indeterminate (res) && ResourceGovernor::get ().exceeded ())
+    {
+      errs () << "Warning: cex validation stopped. Budget exceeded\n";
+      return false;
+    }
 
     // -- DUMP unsat core if validation failed
     if (res) ;
@@ -276,25 +340,42 @@ namespace seahorn
       errs () << "Warning: failed to validate cex\n";
       errs () << "Computing unsat core\n";
       ExprVector core;
-      bmc.unsatCore (core);
+      SmallVector<unsigned, 8> coreEdges;
+      bmc.unsatCore (core, coreEdges);
       errs () << "Final core: " << core.size () << "\n";
       errs () << "Failed to validate CEX. Core is: \n";
       for (Expr c : core) errs () << *c << "\n";
 
       Stats::sset("Result", "FAILED");
-      return false;
+
+      // -- the prefix of the trace up to the last edge of the core is
+      //    already infeasible. Slice the function to it
+      std::string sliceFile = BmcSliceOutputFile.empty () ?
+        CpSliceOutputFile : BmcSliceOutputFile;
+      if (sliceFile.empty () || coreEdges.empty ()) return false;
+
+      DenseSet<const BasicBlock *> region;
+      for (unsigned i = 0; i <= coreEdges.back (); ++i) {
+        const CpEdge *edge = cpg.getEdge (*cpTrace [i], *cpTrace [i + 1]);
+        region.insert (&cpTrace [i]->bb ());
+        for (const BasicBlock &bb : *edge) region.insert (&bb);
+        region.insert (&cpTrace [i + 1]->bb ());
+      }
+      reduceToRegion (F, region);
+      dumpLLVMBitcode (M, sliceFile.c_str ());
+      return true;
     }
 
     // get bmc trace
     BmcTrace trace (bmc.getTrace ());
     LOG ("cex", trace.print (errs ()););
 
+    if (CexReplay && !confirmed)
+      replayTrace (M, trace, M.getDataLayout (), tli);
 
-    if (UseBv)
+    if (UseBv && !confirmed)
     {
       const DataLayout &dl = M.getDataLayout();
-      const TargetLibraryInfo &tli =
-	getAnalysis<TargetLibraryInfoWrapperPass> ().getTLI();
       if (MemSim)
       {
         MemSimulator memSim (trace, dl, tli);
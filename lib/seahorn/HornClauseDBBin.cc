@@ -0,0 +1,735 @@
+#include "seahorn/HornClauseDBBin.hh"
+
+#include "ufo/Expr.hpp"
+#include "ufo/ExprLlvm.hpp"
+#include "ufo/Stats.hh"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "avy/AvyDebug.h"
+
+#include <cstring>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+
+namespace seahorn
+{
+  using namespace llvm;
+  using namespace expr;
+
+  namespace
+  {
+    const char MAGIC [8] = {'S', 'E', 'A', 'H', 'D', 'B', '\0', '\0'};
+    /// -- bump on any change of the layout or of the tags below
+    const uint32_t VERSION = 1;
+    const uint32_t NONE = ~0U;
+
+    /// Words of the header. The fingerprint is the 32 hex digits of
+    /// moduleFingerprint, the counts give the sizes of the sections
+    enum HeaderWord
+      {
+        H_MAGIC = 0, H_VERSION = 2, H_FINGERPRINT = 3,
+        H_STRINGS = 11, H_STRING_BYTES, H_NODES, H_ARGS, H_REFS,
+        H_RELS, H_RULES, H_QUERIES, H_CONSTRAINTS, H_BB_PREDS,
+        H_SIZE
+      };
+    const size_t FINGERPRINT_BYTES = 4 * (H_STRINGS - H_FINGERPRINT);
+
+    /// Sections follow the header in this order. Records are:
+    ///   strings     offsets (count + 1), then the bytes padded to 4
+    ///   nodes       tag, a, b
+    ///   args        node
+    ///   refs        kind, function (or NONE), position (or name string)
+    ///   rels        node
+    ///   rules       first var in args, number of vars, head, body
+    ///   queries     node
+    ///   constraints relation, lemma over its bound variables
+    ///   bb preds    ref of the block, relation
+    enum Record
+      {
+        NODE_WORDS = 3, REF_WORDS = 3, RULE_WORDS = 4,
+        CONSTRAINT_WORDS = 2, BB_PRED_WORDS = 2
+      };
+
+    /// Node tags of terminals. For an operator, a is its first child
+    /// in args and b its arity
+    enum NodeTag
+      {
+        T_STRING, T_INT, T_UINT, T_ULONG, T_MPZ, T_MPQ,
+        T_BVSORT, T_BVAR, T_VALUE, T_BB, T_FUNCTION,
+        T_OP = 32
+      };
+
+    /// Operators have tag T_OP + position in this list.
+    /// -- append only, a change of order needs a new VERSION
+    /// -- FTABLE and FENTRY are models, not terms, and are not written
+#define SEA_HDB_OPS(X)                                                  \
+    X(TRUE) X(FALSE) X(AND) X(OR) X(XOR) X(NEG) X(IMPL) X(ITE) X(IFF)   \
+    X(OUT_G) X(AND_G) X(OR_G) X(NEG_G)                                  \
+    X(PLUS) X(MINUS) X(MULT) X(DIV) X(IDIV) X(MOD) X(REM) X(UN_MINUS)   \
+    X(ABS) X(PINFTY) X(NINFTY) X(ITV)                                   \
+    X(EQ) X(NEQ) X(LEQ) X(GEQ) X(LT) X(GT)                              \
+    X(NONDET) X(ASM) X(TUPLE) X(VARIANT) X(TAG)                         \
+    X(INT_TY) X(CHAR_TY) X(REAL_TY) X(VOID_TY) X(BOOL_TY) X(UNINT_TY)   \
+    X(ARRAY_TY)                                                         \
+    X(SELECT) X(STORE) X(CONST_ARRAY) X(ARRAY_MAP) X(ARRAY_DEFAULT)     \
+    X(AS_ARRAY)                                                         \
+    X(BIND) X(FDECL) X(FAPP) X(FORALL) X(EXISTS) X(LAMBDA)              \
+    X(BNOT) X(BREDAND) X(BREDOR) X(BAND) X(BOR) X(BXOR) X(BNAND)        \
+    X(BNOR) X(BXNOR) X(BNEG) X(BADD) X(BSUB) X(BMUL) X(BUDIV) X(BSDIV)  \
+    X(BUREM) X(BSREM) X(BSMOD) X(BULT) X(BSLT) X(BULE) X(BSLE) X(BUGE)  \
+    X(BSGE) X(BUGT) X(BSGT) X(BCONCAT) X(BEXTRACT) X(BSEXT) X(BZEXT)    \
+    X(BREPEAT) X(BSHL) X(BLSHR) X(BASHR) X(BROTATE_LEFT)                \
+    X(BROTATE_RIGHT) X(BEXT_ROTATE_LEFT) X(BEXT_ROTATE_RIGHT)           \
+    X(INT2BV) X(BV2INT)
+
+    /// Kinds of references to LLVM values
+    enum RefKind {R_GLOBAL, R_ARG, R_INST, R_BLOCK};
+
+    /// Tags of all node types, and an instance of every operator to
+    /// rebuild nodes with
+    struct TagTable
+    {
+      std::unordered_map<std::type_index, uint32_t> tags;
+      std::vector<std::unique_ptr<Operator> > ops;
+
+      TagTable ()
+      {
+        tags [typeid (STRING)] = T_STRING;
+        tags [typeid (INT)] = T_INT;
+        tags [typeid (UINT)] = T_UINT;
+        tags [typeid (ULONG)] = T_ULONG;
+        tags [typeid (MPZ)] = T_MPZ;
+        tags [typeid (MPQ)] = T_MPQ;
+        tags [typeid (BVSORT)] = T_BVSORT;
+        tags [typeid (BVAR)] = T_BVAR;
+        tags [typeid (VALUE)] = T_VALUE;
+        tags [typeid (BB)] = T_BB;
+        tags [typeid (FUNCTION)] = T_FUNCTION;
+#define SEA_HDB_ADD_OP(NAME) addOp (new NAME ());
+        SEA_HDB_OPS (SEA_HDB_ADD_OP)
+#undef SEA_HDB_ADD_OP
+      }
+
+      void addOp (Operator *op)
+      {
+        tags [typeid (*op)] = T_OP + ops.size ();
+        ops.emplace_back (op);
+      }
+    };
+
+    const TagTable &tagTable ()
+    {
+      static TagTable table;
+      return table;
+    }
+
+    /// Positions of the blocks and the instructions of F
+    void numberValues (const Function &F,
+                       std::vector<const BasicBlock*> &blocks,
+                       std::vector<const Instruction*> &insts)
+    {
+      for (const BasicBlock &bb : F)
+      {
+        blocks.push_back (&bb);
+        for (const Instruction &inst : bb) insts.push_back (&inst);
+      }
+    }
+
+    void writeWords (raw_ostream &out, const std::vector<uint32_t> &words)
+    {
+      if (sys::IsLittleEndianHost)
+      {
+        out.write (reinterpret_cast<const char*> (words.data ()),
+                   words.size () * sizeof (uint32_t));
+        return;
+      }
+      for (uint32_t w : words)
+      {
+        char buf [4];
+        support::endian::write32le (buf, w);
+        out.write (buf, 4);
+      }
+    }
+
+    class Writer
+    {
+      std::string &m_err;
+
+      std::vector<uint32_t> m_strOffsets;
+      std::string m_strData;
+      std::map<std::string, uint32_t> m_strIds;
+
+      std::vector<uint32_t> m_nodes;
+      std::vector<uint32_t> m_args;
+      std::vector<uint32_t> m_refs;
+
+      std::unordered_map<const ENode*, uint32_t> m_nodeIds;
+      DenseMap<const Value*, uint32_t> m_refIds;
+
+      /// function index and position of blocks and instructions
+      DenseMap<const Function*, uint32_t> m_fnIds;
+      DenseMap<const Value*, std::pair<uint32_t, uint32_t> > m_positions;
+
+      uint32_t str (const std::string &s)
+      {
+        auto it = m_strIds.find (s);
+        if (it != m_strIds.end ()) return it->second;
+        uint32_t id = m_strOffsets.size () - 1;
+        m_strData += s;
+        m_strOffsets.push_back (m_strData.size ());
+        m_strIds [s] = id;
+        return id;
+      }
+
+      bool ref (const Value *v, uint32_t &out)
+      {
+        auto it = m_refIds.find (v);
+        if (it != m_refIds.end ()) { out = it->second; return true; }
+
+        uint32_t kind, fn, pos;
+        if (const GlobalValue *gv = dyn_cast<GlobalValue> (v))
+        {
+          if (!gv->hasName ())
+          { m_err = "unnamed global"; return false; }
+          kind = R_GLOBAL; fn = NONE; pos = str (gv->getName ().str ());
+        }
+        else if (const Argument *arg = dyn_cast<Argument> (v))
+        {
+          kind = R_ARG;
+          fn = m_fnIds.lookup (arg->getParent ());
+          pos = arg->getArgNo ();
+        }
+        else
+        {
+          auto p = m_positions.find (v);
+          if (p == m_positions.end ())
+          {
+            m_err = "value " + v->getName ().str () + " is not in the module";
+            return false;
+          }
+          kind = isa<BasicBlock> (v) ? R_BLOCK : R_INST;
+          fn = p->second.first;
+          pos = p->second.second;
+        }
+
+        out = m_refs.size () / REF_WORDS;
+        m_refs.push_back (kind);
+        m_refs.push_back (fn);
+        m_refs.push_back (pos);
+        m_refIds [v] = out;
+        return true;
+      }
+
+      /// writes n, whose children are written
+      bool writeNode (ENode *n)
+      {
+        const TagTable &table = tagTable ();
+        auto it = table.tags.find (typeid (n->op ()));
+        if (it == table.tags.end ())
+        {
+          m_err = std::string ("unsupported operator ") + typeid (n->op ()).name ();
+          return false;
+        }
+
+        Expr e (n);
+        uint32_t tag = it->second, a = 0, b = 0;
+        switch (tag)
+        {
+        case T_STRING: a = str (getTerm<std::string> (e)); break;
+        case T_INT: a = static_cast<uint32_t> (getTerm<int> (e)); break;
+        case T_UINT: a = getTerm<unsigned> (e); break;
+        case T_ULONG:
+          {
+            uint64_t v = getTerm<unsigned long> (e);
+            a = static_cast<uint32_t> (v);
+            b = static_cast<uint32_t> (v >> 32);
+            break;
+          }
+        case T_MPZ: a = str (getTerm<mpz_class> (e).get_str ()); break;
+        case T_MPQ: a = str (getTerm<mpq_class> (e).get_str ()); break;
+        case T_BVSORT: a = op::bv::width (e); break;
+        case T_BVAR: a = getTerm<bind::BoundVar> (e).var; break;
+        case T_VALUE:
+          if (!ref (getTerm<const Value*> (e), a)) return false;
+          break;
+        case T_BB:
+          if (!ref (getTerm<const BasicBlock*> (e), a)) return false;
+          break;
+        case T_FUNCTION:
+          if (!ref (getTerm<const Function*> (e), a)) return false;
+          break;
+        default:
+          a = m_args.size ();
+          b = n->arity ();
+          for (size_t i = 0; i < n->arity (); ++i)
+            m_args.push_back (m_nodeIds [n->arg (i)]);
+        }
+
+        m_nodeIds [n] = m_nodes.size () / NODE_WORDS;
+        m_nodes.push_back (tag);
+        m_nodes.push_back (a);
+        m_nodes.push_back (b);
+        return true;
+      }
+
+    public:
+      Writer (const Module &M, std::string &err) : m_err (err)
+      {
+        m_strOffsets.push_back (0);
+        uint32_t fn = 0;
+        for (const Function &F : M)
+        {
+          m_fnIds [&F] = fn;
+          std::vector<const BasicBlock*> blocks;
+          std::vector<const Instruction*> insts;
+          numberValues (F, blocks, insts);
+          for (uint32_t i = 0; i < blocks.size (); ++i)
+            m_positions [blocks [i]] = std::make_pair (fn, i);
+          for (uint32_t i = 0; i < insts.size (); ++i)
+            m_positions [insts [i]] = std::make_pair (fn, i);
+          ++fn;
+        }
+      }
+
+      /// writes the DAG of e, children first, without recursion
+      bool node (Expr e, uint32_t &out)
+      {
+        std::vector<std::pair<ENode*, size_t> > stack;
+        stack.push_back (std::make_pair (e.get (), 0));
+        while (!stack.empty ())
+        {
+          ENode *n = stack.back ().first;
+          if (m_nodeIds.count (n)) { stack.pop_back (); continue; }
+
+          size_t next = stack.back ().second;
+          if (next < n->arity ())
+          {
+            stack.back ().second = next + 1;
+            ENode *kid = n->arg (next);
+            if (!m_nodeIds.count (kid))
+              stack.push_back (std::make_pair (kid, 0));
+            continue;
+          }
+
+          if (!writeNode (n)) return false;
+          stack.pop_back ();
+        }
+        out = m_nodeIds [e.get ()];
+        return true;
+      }
+
+      bool blockRef (const BasicBlock *bb, uint32_t &out) { return ref (bb, out); }
+
+      size_t numNodes () const { return m_nodes.size () / NODE_WORDS; }
+
+      void emit (raw_ostream &out, std::vector<uint32_t> &header,
+                 const std::vector<uint32_t> &args,
+                 const std::vector<uint32_t> &rels,
+                 const std::vector<uint32_t> &rules,
+                 const std::vector<uint32_t> &queries,
+                 const std::vector<uint32_t> &constraints,
+                 const std::vector<uint32_t> &bbPreds)
+      {
+        // -- rule variables go after the arguments of the nodes
+        std::vector<uint32_t> allArgs (m_args);
+        allArgs.insert (allArgs.end (), args.begin (), args.end ());
+        std::vector<uint32_t> shifted (rules);
+        for (size_t i = 0; i < shifted.size (); i += RULE_WORDS)
+          shifted [i] += m_args.size ();
+
+        while (m_strData.size () % 4) m_strData.push_back ('\0');
+
+        header [H_STRINGS] = m_strOffsets.size () - 1;
+        header [H_STRING_BYTES] = m_strData.size ();
+        header [H_NODES] = numNodes ();
+        header [H_ARGS] = allArgs.size ();
+        header [H_REFS] = m_refs.size () / REF_WORDS;
+        header [H_RELS] = rels.size ();
+        header [H_RULES] = rules.size () / RULE_WORDS;
+        header [H_QUERIES] = queries.size ();
+        header [H_CONSTRAINTS] = constraints.size () / CONSTRAINT_WORDS;
+        header [H_BB_PREDS] = bbPreds.size () / BB_PRED_WORDS;
+
+        writeWords (out, header);
+        writeWords (out, m_strOffsets);
+        out.write (m_strData.data (), m_strData.size ());
+        writeWords (out, m_nodes);
+        writeWords (out, allArgs);
+        writeWords (out, m_refs);
+        writeWords (out, rels);
+        writeWords (out, shifted);
+        writeWords (out, queries);
+        writeWords (out, constraints);
+        writeWords (out, bbPreds);
+      }
+    };
+
+    /// Bounds-checked view of the words of a file
+    class Image
+    {
+      const char *m_data;
+      size_t m_size;
+
+    public:
+      Image (const MemoryBuffer &buf) :
+        m_data (buf.getBufferStart ()), m_size (buf.getBufferSize ()) {}
+
+      size_t size () const { return m_size; }
+      const char *bytes (size_t off) const { return m_data + off; }
+      uint32_t word (size_t off) const
+      { return support::endian::read32le (m_data + off); }
+    };
+
+    bool checkHeader (const Image &img, const std::string &fingerprint)
+    {
+      if (img.size () < H_SIZE * 4) return false;
+      if (std::memcmp (img.bytes (0), MAGIC, sizeof (MAGIC)) != 0) return false;
+      if (img.word (4 * H_VERSION) != VERSION) return false;
+      return fingerprint.size () == FINGERPRINT_BYTES &&
+        std::memcmp (img.bytes (4 * H_FINGERPRINT), fingerprint.data (),
+                     FINGERPRINT_BYTES) == 0;
+    }
+  }
+
+  std::string moduleFingerprint (const Module &M)
+  {
+    std::string text;
+    raw_string_ostream os (text);
+    os << M.getDataLayoutStr () << "\n" << M.getTargetTriple () << "\n";
+    for (const GlobalVariable &gv : M.globals ()) os << gv << "\n";
+    for (const GlobalAlias &ga : M.aliases ()) os << ga << "\n";
+    for (const Function &F : M) os << F;
+    os.flush ();
+
+    MD5 md5;
+    md5.update (text);
+    MD5::MD5Result res;
+    md5.final (res);
+    SmallString<32> hex;
+    MD5::stringifyResult (res, hex);
+    return hex.str ().str ();
+  }
+
+  bool writeHornClauseDB (const HornClauseDB &db, const BbPredMap &bbPreds,
+                          const Module &M, const std::string &fingerprint,
+                          raw_ostream &out, std::string &err)
+  {
+    ufo::ScopedStats _st ("HornClauseDB.write");
+    if (fingerprint.size () != FINGERPRINT_BYTES)
+    { err = "bad fingerprint"; return false; }
+
+    Writer w (M, err);
+    std::vector<uint32_t> args, rels, rules, queries, constraints, preds;
+    uint32_t id;
+
+    for (Expr rel : db.getRelations ())
+    {
+      if (!w.node (rel, id)) return false;
+      rels.push_back (id);
+    }
+
+    for (const HornRule &r : db.getRules ())
+    {
+      rules.push_back (args.size ());
+      rules.push_back (r.vars ().size ());
+      for (Expr v : r.vars ())
+      {
+        if (!w.node (v, id)) return false;
+        args.push_back (id);
+      }
+      if (!w.node (r.head (), id)) return false;
+      rules.push_back (id);
+      if (!w.node (r.body (), id)) return false;
+      rules.push_back (id);
+    }
+
+    for (Expr q : db.getQueries ())
+    {
+      if (!w.node (q, id)) return false;
+      queries.push_back (id);
+    }
+
+    for (auto &kv : db.getConstraintMap ())
+      for (Expr lemma : kv.second)
+      {
+        if (!w.node (kv.first, id)) return false;
+        constraints.push_back (id);
+        if (!w.node (lemma, id)) return false;
+        constraints.push_back (id);
+      }
+
+    for (auto &kv : bbPreds)
+    {
+      if (!w.blockRef (kv.first, id)) return false;
+      preds.push_back (id);
+      if (!w.node (kv.second, id)) return false;
+      preds.push_back (id);
+    }
+
+    std::vector<uint32_t> header (H_SIZE, 0);
+    std::memcpy (&header [H_MAGIC], MAGIC, sizeof (MAGIC));
+    header [H_VERSION] = VERSION;
+    std::memcpy (&header [H_FINGERPRINT], fingerprint.data (), FINGERPRINT_BYTES);
+    // -- magic and fingerprint are bytes, not words
+    if (!sys::IsLittleEndianHost)
+      for (unsigned i = H_MAGIC; i < H_STRINGS; ++i)
+        if (i != H_VERSION)
+          header [i] = support::endian::read32le (&header [i]);
+
+    ufo::Stats::uset ("HornClauseDBNodes", w.numNodes ());
+    w.emit (out, header, args, rels, rules, queries, constraints, preds);
+    return true;
+  }
+
+  bool matchesHornClauseDB (const MemoryBuffer &buf, const std::string &fingerprint)
+  { return checkHeader (Image (buf), fingerprint); }
+
+  bool readHornClauseDB (const MemoryBuffer &buf, const Module &M,
+                         const std::string &fingerprint,
+                         HornClauseDB &db, BbPredMap &bbPreds, std::string &err)
+  {
+    ufo::ScopedStats _st ("HornClauseDB.read");
+    Image img (buf);
+    if (!checkHeader (img, fingerprint))
+    { err = "not a Horn clause DB of this program"; return false; }
+
+    auto hdr = [&] (unsigned w) { return uint64_t (img.word (4 * w)); };
+
+    // -- byte offsets of the sections
+    uint64_t strOffsets = 4 * H_SIZE;
+    uint64_t strData = strOffsets + 4 * (hdr (H_STRINGS) + 1);
+    uint64_t nodesOff = strData + hdr (H_STRING_BYTES);
+    uint64_t argsOff = nodesOff + 4 * NODE_WORDS * hdr (H_NODES);
+    uint64_t refsOff = argsOff + 4 * hdr (H_ARGS);
+    uint64_t relsOff = refsOff + 4 * REF_WORDS * hdr (H_REFS);
+    uint64_t rulesOff = relsOff + 4 * hdr (H_RELS);
+    uint64_t queriesOff = rulesOff + 4 * RULE_WORDS * hdr (H_RULES);
+    uint64_t constraintsOff = queriesOff + 4 * hdr (H_QUERIES);
+    uint64_t predsOff = constraintsOff + 4 * CONSTRAINT_WORDS * hdr (H_CONSTRAINTS);
+    uint64_t end = predsOff + 4 * BB_PRED_WORDS * hdr (H_BB_PREDS);
+    if (hdr (H_STRING_BYTES) % 4 != 0 || end != img.size ())
+    { err = "truncated or corrupt file"; return false; }
+
+    // -- strings
+    std::vector<std::string> strs;
+    for (uint64_t i = 0; i < hdr (H_STRINGS); ++i)
+    {
+      uint32_t b = img.word (strOffsets + 4 * i);
+      uint32_t e = img.word (strOffsets + 4 * (i + 1));
+      if (b > e || e > hdr (H_STRING_BYTES))
+      { err = "corrupt string table"; return false; }
+      strs.push_back (std::string (img.bytes (strData + b), e - b));
+    }
+
+    // -- LLVM values
+    std::vector<const Function*> fns;
+    for (const Function &F : M) fns.push_back (&F);
+    std::map<uint32_t, std::pair<std::vector<const BasicBlock*>,
+                                 std::vector<const Instruction*> > > positions;
+
+    std::vector<const Value*> refs;
+    for (uint64_t i = 0; i < hdr (H_REFS); ++i)
+    {
+      uint64_t off = refsOff + 4 * REF_WORDS * i;
+      uint32_t kind = img.word (off);
+      uint32_t fn = img.word (off + 4);
+      uint32_t pos = img.word (off + 8);
+
+      const Value *v = nullptr;
+      if (kind == R_GLOBAL)
+      { if (pos < strs.size ()) v = M.getNamedValue (strs [pos]); }
+      else if (fn < fns.size ())
+      {
+        const Function &F = *fns [fn];
+        if (kind == R_ARG)
+        {
+          if (pos < F.arg_size ())
+          {
+            auto it = F.arg_begin ();
+            std::advance (it, pos);
+            v = &*it;
+          }
+        }
+        else
+        {
+          auto &p = positions [fn];
+          if (p.first.empty ()) numberValues (F, p.first, p.second);
+          if (kind == R_BLOCK && pos < p.first.size ())
+            v = p.first [pos];
+          else if (kind == R_INST && pos < p.second.size ())
+            v = p.second [pos];
+        }
+      }
+      if (!v) { err = "value not in the module"; return false; }
+      refs.push_back (v);
+    }
+
+    // -- the DAG
+    ExprFactory &efac = db.getExprFactory ();
+    const TagTable &table = tagTable ();
+    std::vector<Expr> nodes;
+    nodes.reserve (hdr (H_NODES));
+    ExprVector kids;
+    for (uint64_t i = 0; i < hdr (H_NODES); ++i)
+    {
+      uint64_t off = nodesOff + 4 * NODE_WORDS * i;
+      uint32_t tag = img.word (off);
+      uint32_t a = img.word (off + 4);
+      uint32_t b = img.word (off + 8);
+
+      Expr e;
+      switch (tag)
+      {
+      case T_STRING:
+        if (a < strs.size ()) e = mkTerm<std::string> (strs [a], efac);
+        break;
+      case T_INT: e = mkTerm<int> (static_cast<int> (a), efac); break;
+      case T_UINT: e = mkTerm<unsigned> (a, efac); break;
+      case T_ULONG:
+        e = mkTerm<unsigned long>
+          (static_cast<unsigned long> ((uint64_t (b) << 32) | a), efac);
+        break;
+      case T_MPZ:
+        {
+          mpz_class v;
+          if (a < strs.size () && v.set_str (strs [a], 10) == 0)
+            e = mkTerm<mpz_class> (v, efac);
+          break;
+        }
+      case T_MPQ:
+        {
+          mpq_class v;
+          if (a < strs.size () && v.set_str (strs [a], 10) == 0)
+            e = mkTerm<mpq_class> (v, efac);
+          break;
+        }
+      case T_BVSORT: e = op::bv::bvsort (a, efac); break;
+      case T_BVAR: e = mkTerm (bind::BoundVar (a), efac); break;
+      case T_VALUE:
+        if (a < refs.size ()) e = mkTerm<const Value*> (refs [a], efac);
+        break;
+      case T_BB:
+        if (a < refs.size () && isa<BasicBlock> (refs [a]))
+          e = mkTerm<const BasicBlock*> (cast<BasicBlock> (refs [a]), efac);
+        break;
+      case T_FUNCTION:
+        if (a < refs.size () && isa<Function> (refs [a]))
+          e = mkTerm<const Function*> (cast<Function> (refs [a]), efac);
+        break;
+      default:
+        {
+          if (tag < T_OP || tag - T_OP >= table.ops.size ()) break;
+          if (uint64_t (a) + b > hdr (H_ARGS)) break;
+          kids.clear ();
+          for (uint32_t k = 0; k < b; ++k)
+          {
+            // -- children come first
+            uint32_t kid = img.word (argsOff + 4 * (uint64_t (a) + k));
+            if (kid >= i) break;
+            kids.push_back (nodes [kid]);
+          }
+          if (kids.size () != b) break;
+          const Operator &op = *table.ops [tag - T_OP];
+          e = b == 0 ? efac.mkTerm (op) : efac.mkNary (op, kids.begin (), kids.end ());
+        }
+      }
+      if (!e) { err = "corrupt node"; return false; }
+      nodes.push_back (e);
+    }
+
+    auto nodeAt = [&] (uint64_t off, Expr &out)
+      {
+        uint32_t id = img.word (off);
+        if (id >= nodes.size ()) return false;
+        out = nodes [id];
+        return true;
+      };
+
+    // -- relations, rules, queries, constraints and block predicates
+    ExprVector rels;
+    for (uint64_t i = 0; i < hdr (H_RELS); ++i)
+    {
+      Expr rel;
+      if (!nodeAt (relsOff + 4 * i, rel) || !bind::isFdecl (rel))
+      { err = "corrupt relation"; return false; }
+      rels.push_back (rel);
+    }
+
+    std::vector<HornRule> rules;
+    for (uint64_t i = 0; i < hdr (H_RULES); ++i)
+    {
+      uint64_t off = rulesOff + 4 * RULE_WORDS * i;
+      uint64_t first = img.word (off), num = img.word (off + 4);
+      Expr head, body;
+      if (first + num > hdr (H_ARGS) ||
+          !nodeAt (off + 8, head) || !nodeAt (off + 12, body))
+      { err = "corrupt rule"; return false; }
+      ExprVector vars;
+      for (uint64_t k = 0; k < num; ++k)
+      {
+        Expr v;
+        if (!nodeAt (argsOff + 4 * (first + k), v))
+        { err = "corrupt rule"; return false; }
+        vars.push_back (v);
+      }
+      rules.push_back (HornRule (vars, head, body));
+    }
+
+    ExprVector queries;
+    for (uint64_t i = 0; i < hdr (H_QUERIES); ++i)
+    {
+      Expr q;
+      if (!nodeAt (queriesOff + 4 * i, q))
+      { err = "corrupt query"; return false; }
+      queries.push_back (q);
+    }
+
+    std::vector<std::pair<Expr, Expr> > constraints;
+    for (uint64_t i = 0; i < hdr (H_CONSTRAINTS); ++i)
+    {
+      uint64_t off = constraintsOff + 4 * CONSTRAINT_WORDS * i;
+      Expr rel, lemma;
+      if (!nodeAt (off, rel) || !nodeAt (off + 4, lemma) || !bind::isFdecl (rel))
+      { err = "corrupt constraint"; return false; }
+      constraints.push_back (std::make_pair (rel, lemma));
+    }
+
+    std::vector<std::pair<const BasicBlock*, Expr> > preds;
+    for (uint64_t i = 0; i < hdr (H_BB_PREDS); ++i)
+    {
+      uint64_t off = predsOff + 4 * BB_PRED_WORDS * i;
+      uint32_t r = img.word (off);
+      Expr rel;
+      if (r >= refs.size () || !isa<BasicBlock> (refs [r]) || !nodeAt (off + 4, rel))
+      { err = "corrupt block predicate"; return false; }
+      preds.push_back (std::make_pair (cast<BasicBlock> (refs [r]), rel));
+    }
+
+    // -- the file is valid, fill db
+    for (Expr rel : rels) db.registerRelation (rel);
+    for (const HornRule &r : rules) db.addRule (r);
+    for (Expr q : queries) db.addQuery (q);
+    for (auto &c : constraints)
+    {
+      Expr rel = c.first;
+      ExprVector args;
+      for (unsigned i = 0; i < bind::domainSz (rel); ++i)
+        args.push_back (bind::bvar (i, bind::domainTy (rel, i)));
+      db.addConstraint (bind::fapp (rel, args), c.second);
+    }
+    for (auto &p : preds) bbPreds [p.first] = p.second;
+
+    ufo::Stats::uset ("HornClauseDBNodes", nodes.size ());
+    LOG ("horn-db-bin",
+         errs () << "Loaded " << nodes.size () << " nodes, "
+         << rules.size () << " rules\n";);
+    return true;
+  }
+}
@@ -1,5 +1,14 @@
 #include "seahorn/HornClauseDBTransf.hh"
+#include "seahorn/HornModelConverter.hh"
 #include "ufo/Expr.hpp"
+#include "ufo/ExprAig.hpp"
+#include "ufo/Stats.hh"
+
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "avy/AvyDebug.h"
+
+#include <algorithm>
 
 namespace seahorn
 {
@@ -68,4 +77,649 @@ namespace seahorn
       db.addRule (new_rule);
     }
   }
+
+  void aigHornClauseDB (HornClauseDB &db, unsigned threads)
+  {
+    ufo::ScopedStats _st_ ("HornClauseDB::aig");
+    HornClauseDB::RuleVector &rules = db.getRules ();
+
+    // -- relation applications stay out of the graph so that the
+    // -- indexes of the database remain valid
+    std::vector<ExprVector> rels (rules.size ());
+    std::vector<ExprVector> constraints (rules.size ());
+    for (unsigned i = 0, sz = rules.size (); i < sz; ++i)
+    {
+      ExprVector conjs;
+      Expr body = rules [i].body ();
+      if (isOpX<AND> (body))
+        std::copy (body->args_begin (), body->args_end (),
+                   std::back_inserter (conjs));
+      else conjs.push_back (body);
+
+      for (Expr c : conjs)
+        if (bind::isFapp (c) && db.hasRelation (bind::fname (c)))
+          rels [i].push_back (c);
+        else
+          constraints [i].push_back (c);
+    }
+
+    // -- building a graph only reads the bodies, which are kept
+    // -- alive above. Nothing is created in the ExprFactory
+    std::vector<boolop::AigGraph> graphs (rules.size ());
+    std::vector<boolop::AigGraph::Lit> roots (rules.size (), 1);
+    {
+      llvm::ThreadPool pool (std::max (threads, 1U));
+      for (unsigned i = 0, sz = rules.size (); i < sz; ++i)
+      {
+        if (constraints [i].empty ()) continue;
+        pool.async ([&, i] {
+            for (const Expr &c : constraints [i])
+              roots [i] = graphs [i].mkAnd (roots [i], graphs [i].build (c.get ()));
+          });
+      }
+      pool.wait ();
+    }
+
+    for (unsigned i = 0, sz = rules.size (); i < sz; ++i)
+    {
+      if (constraints [i].empty ()) continue;
+
+      HornRule &r = rules [i];
+      Expr c = graphs [i].toExpr (roots [i], db.getExprFactory (), true);
+      ExprVector conjs (rels [i]);
+      if (conjs.empty () || !isOpX<TRUE> (c)) conjs.push_back (c);
+      Expr body = boolop::land (conjs);
+
+      unsigned before = boolop::circSize (r.body ());
+      unsigned after = boolop::circSize (body);
+      LOG ("aig", llvm::errs () << "AIG: rule " << i << " for "
+           << *bind::fname (bind::fname (r.head ())) << ": "
+           << before << " -> " << after << "\n";);
+      // -- structural hashing might unfold shared subterms
+      if (after > before) continue;
+
+      ufo::Stats::count ("HornAigRules");
+      ufo::Stats::uset ("HornAigSizeBefore",
+                        ufo::Stats::get ("HornAigSizeBefore") + before);
+      ufo::Stats::uset ("HornAigSizeAfter",
+                        ufo::Stats::get ("HornAigSizeAfter") + after);
+      r.setBody (body);
+    }
+  }
+
+  namespace
+  {
+    /// -- value of an argument position in constant propagation
+    struct ArgVal
+    {
+      enum Kind {UNDEF, CONST, VARYING} kind;
+      Expr val;
+
+      ArgVal () : kind (UNDEF) {}
+      ArgVal (Kind k, Expr v = Expr ()) : kind (k), val (v) {}
+
+      /// returns true if the value changed
+      bool join (const ArgVal &o)
+      {
+        if (o.kind == UNDEF || kind == VARYING) return false;
+        if (kind == UNDEF) { *this = o; return true; }
+        if (o.kind == CONST && o.val == val) return false;
+        kind = VARYING;
+        val.reset (0);
+        return true;
+      }
+    };
+
+    struct IsIn : public std::unary_function<Expr, bool>
+    {
+      const ExprSet &m_set;
+      IsIn (const ExprSet &s) : m_set (s) {}
+      bool operator() (Expr e) {return m_set.count (e) > 0;}
+    };
+
+    bool isValue (Expr e)
+    {return isOpX<MPZ> (e) || isOpX<TRUE> (e) || isOpX<FALSE> (e);}
+
+    /// A rule split into relation applications and constraints
+    struct RuleInfo
+    {
+      ExprVector vars;
+      ExprSet varSet;
+      Expr head;
+      ExprVector apps;
+      ExprVector constraints;
+
+      /// -- variables of the constraints
+      ExprSet constraintVars;
+      /// -- variables of every argument of the head
+      std::vector<ExprSet> headVars;
+      /// -- variables of every argument of every application
+      std::vector<std::vector<ExprSet> > appVars;
+      /// -- variables equal to a value in the constraints
+      ExprMap values;
+
+      RuleInfo (const HornRule &r, HornClauseDB &db) :
+        vars (r.vars ()), varSet (vars.begin (), vars.end ()), head (r.head ())
+      {
+        split (r.body (), db);
+        index ();
+      }
+
+      /// -- keeps the order of conjuncts. Cex extraction expects the
+      /// -- source relation first
+      void split (Expr c, HornClauseDB &db)
+      {
+        if (isOpX<AND> (c))
+          for (auto it = c->args_begin (), end = c->args_end (); it != end; ++it)
+            split (*it, db);
+        else if (bind::isFapp (c) && db.hasRelation (bind::fname (c)))
+          apps.push_back (c);
+        else if (!isOpX<TRUE> (c))
+          constraints.push_back (c);
+      }
+
+      void index ()
+      {
+        const ExprSet &vs = varSet;
+        constraintVars.clear ();
+        values.clear ();
+        for (Expr c : constraints)
+        {
+          filter (c, IsIn (vs), std::inserter (constraintVars, constraintVars.begin ()));
+          if (vs.count (c)) values [c] = mk<TRUE> (c->efac ());
+          else if (isOpX<NEG> (c) && vs.count (c->left ()))
+            values [c->left ()] = mk<FALSE> (c->efac ());
+          else if (isOpX<EQ> (c) && vs.count (c->left ()) && isValue (c->right ()))
+            values [c->left ()] = c->right ();
+          else if (isOpX<EQ> (c) && vs.count (c->right ()) && isValue (c->left ()))
+            values [c->right ()] = c->left ();
+        }
+
+        headVars.assign (head->arity () - 1, ExprSet ());
+        for (unsigned i = 1; i < head->arity (); ++i)
+          filter (head->arg (i), IsIn (vs),
+                  std::inserter (headVars [i - 1], headVars [i - 1].begin ()));
+
+        appVars.assign (apps.size (), std::vector<ExprSet> ());
+        for (unsigned k = 0; k < apps.size (); ++k)
+        {
+          appVars [k].assign (apps [k]->arity () - 1, ExprSet ());
+          for (unsigned j = 1; j < apps [k]->arity (); ++j)
+            filter (apps [k]->arg (j), IsIn (vs),
+                    std::inserter (appVars [k][j - 1], appVars [k][j - 1].begin ()));
+        }
+      }
+
+      HornRule rule (HornClauseDB &db) const
+      {
+        ExprVector conjs (apps);
+        conjs.insert (conjs.end (), constraints.begin (), constraints.end ());
+        Expr body = conjs.empty () ? mk<TRUE> (head->efac ()) : boolop::land (conjs);
+        return HornRule (vars, head, body);
+      }
+    };
+
+    typedef std::map<Expr, std::vector<ArgVal> > ValueMap;
+    typedef std::map<Expr, std::vector<bool> > LiveMap;
+
+    /// value of argument i of the head of r
+    ArgVal headValue (const RuleInfo &r, unsigned i, const ValueMap &vals)
+    {
+      Expr h = r.head->arg (i + 1);
+      if (isValue (h)) return ArgVal (ArgVal::CONST, h);
+      if (!r.varSet.count (h)) return ArgVal (ArgVal::VARYING);
+
+      auto it = r.values.find (h);
+      if (it != r.values.end ()) return ArgVal (ArgVal::CONST, it->second);
+
+      // -- if h is passed to a relation, it has the value of that
+      // -- argument. An undefined relation contributes nothing
+      ArgVal res (ArgVal::VARYING);
+      for (Expr app : r.apps)
+        for (unsigned j = 1; j < app->arity (); ++j)
+        {
+          if (app->arg (j) != h) continue;
+          const ArgVal &v = vals.at (bind::fname (app)) [j - 1];
+          if (v.kind == ArgVal::CONST) return v;
+          if (v.kind == ArgVal::UNDEF) res = v;
+        }
+      return res;
+    }
+
+    /// true if argument j of application k of r constrains anything
+    bool isLiveUse (const RuleInfo &r, unsigned k, unsigned j, const LiveMap &live)
+    {
+      Expr a = r.apps [k]->arg (j + 1);
+      if (!r.varSet.count (a) || r.constraintVars.count (a)) return true;
+
+      const std::vector<bool> &hl = live.at (bind::fname (r.head));
+      for (unsigned i = 0; i < r.headVars.size (); ++i)
+        if (hl [i] && r.headVars [i].count (a)) return true;
+
+      for (unsigned k1 = 0; k1 < r.appVars.size (); ++k1)
+        for (unsigned j1 = 0; j1 < r.appVars [k1].size (); ++j1)
+          if ((k1 != k || j1 != j) && r.appVars [k1][j1].count (a)) return true;
+      return false;
+    }
+
+    /// copies the constraints of the given relations of db into out
+    template <typename Range>
+    void copyConstraints (HornClauseDB &db, HornClauseDB &out, const Range &rels)
+    {
+      for (Expr rel : rels)
+      {
+        if (!db.hasConstraints (rel)) continue;
+        ExprVector args;
+        for (unsigned i = 0, sz = bind::domainSz (rel); i < sz; ++i)
+        {
+          Expr name = mkTerm<std::string> ("arg_" + boost::lexical_cast<std::string> (i),
+                                           db.getExprFactory ());
+          args.push_back (bind::mkConst (name, bind::domainTy (rel, i)));
+        }
+        Expr pred = bind::fapp (rel, args);
+        out.addConstraint (pred, db.getConstraints (pred));
+      }
+    }
+
+    Expr dropArgs (Expr app, Expr decl, const std::vector<bool> &removed)
+    {
+      ExprVector args;
+      for (unsigned i = 1; i < app->arity (); ++i)
+        if (!removed [i - 1]) args.push_back (app->arg (i));
+      return bind::fapp (decl, args);
+    }
+  }
+
+  bool eliminateArgs (HornClauseDB &db, HornClauseDB &out,
+                      ArgElimHornModelConverter &converter)
+  {
+    ufo::ScopedStats _st_ ("HornClauseDB::eliminateArgs");
+
+    std::vector<RuleInfo> rules;
+    for (const HornRule &r : db.getRules ()) rules.push_back (RuleInfo (r, db));
+
+    ExprSet fixed;
+    for (Expr q : db.getQueries ())
+      if (bind::isFapp (q)) fixed.insert (bind::fname (q));
+    for (Expr rel : db.getRelations ())
+      if (db.hasConstraints (rel)) fixed.insert (rel);
+
+    std::vector<Expr> rels (db.getRelations ().begin (), db.getRelations ().end ());
+    auto &argMaps = converter.getArgMaps ();
+    unsigned total = 0;
+
+    while (true)
+    {
+      // -- optimistic constant propagation over argument positions
+      ValueMap vals;
+      for (Expr rel : rels) vals [rel].assign (bind::domainSz (rel), ArgVal ());
+      for (bool changed = true; changed; )
+      {
+        changed = false;
+        for (const RuleInfo &r : rules)
+        {
+          std::vector<ArgVal> &hv = vals [bind::fname (r.head)];
+          for (unsigned i = 0; i < hv.size (); ++i)
+            changed |= hv [i].join (headValue (r, i, vals));
+        }
+      }
+
+      // -- an argument is live if it is used by a constraint, a live
+      // -- argument of the head, or another application
+      LiveMap live;
+      for (Expr rel : rels)
+        live [rel].assign (bind::domainSz (rel), fixed.count (rel) > 0);
+      for (bool changed = true; changed; )
+      {
+        changed = false;
+        for (const RuleInfo &r : rules)
+          for (unsigned k = 0; k < r.apps.size (); ++k)
+          {
+            std::vector<bool> &al = live [bind::fname (r.apps [k])];
+            for (unsigned j = 0; j < al.size (); ++j)
+              if (!al [j] && isLiveUse (r, k, j, live))
+                al [j] = changed = true;
+          }
+      }
+
+      // -- new relations
+      std::map<Expr, Expr> newRel;
+      std::map<Expr, std::vector<bool> > removed;
+      unsigned count = 0;
+      for (Expr &rel : rels)
+      {
+        if (fixed.count (rel)) continue;
+        std::vector<bool> rm (bind::domainSz (rel), false);
+        ExprVector sorts;
+        for (unsigned i = 0; i < rm.size (); ++i)
+        {
+          rm [i] = vals [rel][i].kind == ArgVal::CONST || !live [rel][i];
+          if (rm [i]) ++count;
+          else sorts.push_back (bind::domainTy (rel, i));
+        }
+        if (sorts.size () == rm.size ()) continue;
+        sorts.push_back (bind::rangeTy (rel));
+        Expr decl = bind::fdecl (bind::fname (rel), sorts);
+
+        // -- compose with the arguments removed so far
+        ArgElimHornModelConverter::ArgMap m;
+        auto it = argMaps.find (rel);
+        if (it != argMaps.end ()) m = it->second;
+        else
+        {
+          m.orig = rel;
+          for (unsigned i = 0; i < rm.size (); ++i) m.pos.push_back (i);
+          m.vals.resize (rm.size ());
+        }
+        std::vector<int> idx (rm.size (), -1);
+        for (unsigned i = 0, n = 0; i < rm.size (); ++i)
+          if (!rm [i]) idx [i] = n++;
+        for (unsigned i = 0; i < m.pos.size (); ++i)
+        {
+          if (m.pos [i] < 0) continue;
+          int p = m.pos [i];
+          m.pos [i] = idx [p];
+          if (idx [p] < 0 && vals [rel][p].kind == ArgVal::CONST)
+            m.vals [i] = vals [rel][p].val;
+        }
+        if (it != argMaps.end ()) argMaps.erase (it);
+        argMaps [decl] = m;
+
+        newRel [rel] = decl;
+        removed [rel] = rm;
+        rel = decl;
+      }
+      if (count == 0) break;
+      total += count;
+
+      // -- rewrite the rules. Variables passed as removed constants
+      // -- become the constants
+      for (RuleInfo &r : rules)
+      {
+        ExprMap sub;
+        ExprVector eqs;
+        for (Expr app : r.apps)
+        {
+          Expr rel = bind::fname (app);
+          if (!newRel.count (rel)) continue;
+          for (unsigned j = 1; j < app->arity (); ++j)
+          {
+            const ArgVal &v = vals [rel][j - 1];
+            if (!removed [rel][j - 1] || v.kind != ArgVal::CONST) continue;
+            Expr a = app->arg (j);
+            // -- a variable fixed to two constants keeps the second
+            // -- as an equality, which the substitution makes false
+            auto it = sub.find (a);
+            if (r.varSet.count (a) && (it == sub.end () || it->second == v.val))
+              sub [a] = v.val;
+            else
+              eqs.push_back (mk<EQ> (a, v.val));
+          }
+        }
+        if (!sub.empty ())
+          for (Expr &e : eqs) e = replace (e, sub);
+
+        for (Expr &app : r.apps)
+        {
+          Expr rel = bind::fname (app);
+          if (newRel.count (rel)) app = dropArgs (app, newRel [rel], removed [rel]);
+          if (!sub.empty ()) app = replace (app, sub);
+        }
+        if (!sub.empty ())
+          for (Expr &c : r.constraints) c = replace (c, sub);
+        r.constraints.insert (r.constraints.end (), eqs.begin (), eqs.end ());
+
+        Expr rel = bind::fname (r.head);
+        if (newRel.count (rel)) r.head = dropArgs (r.head, newRel [rel], removed [rel]);
+        if (!sub.empty ()) r.head = replace (r.head, sub);
+        r.index ();
+      }
+
+      LOG ("elim-args", llvm::errs () << "Removed " << count << " arguments\n";);
+    }
+
+    ufo::Stats::uset ("HornElimArgs", total);
+    if (total == 0) return false;
+
+    for (Expr rel : rels) out.registerRelation (rel);
+    for (const RuleInfo &r : rules) out.addRule (r.rule (out));
+    for (Expr q : db.getQueries ()) out.addQuery (q);
+    copyConstraints (db, out, rels);
+    converter.setNewDB (out);
+    return true;
+  }
+
+  bool sliceHornClauseDB (HornClauseDB &db, HornClauseDB &out,
+                          SliceHornModelConverter &converter)
+  {
+    ufo::ScopedStats _st_ ("HornClauseDB::slice");
+    if (!db.hasQuery ()) return false;
+
+    std::vector<RuleInfo> rules;
+    for (const HornRule &r : db.getRules ()) rules.push_back (RuleInfo (r, db));
+
+    // -- forward from the facts
+    ExprSet derivable;
+    for (bool changed = true; changed; )
+    {
+      changed = false;
+      for (const RuleInfo &r : rules)
+      {
+        Expr rel = bind::fname (r.head);
+        if (derivable.count (rel)) continue;
+        bool all = true;
+        for (Expr app : r.apps) all = all && derivable.count (bind::fname (app));
+        if (!all) continue;
+        derivable.insert (rel);
+        changed = true;
+      }
+    }
+
+    // -- backward from the queries, through rules that can fire
+    std::map<Expr, std::vector<unsigned> > defs;
+    std::vector<bool> fires (rules.size (), true);
+    for (unsigned i = 0; i < rules.size (); ++i)
+    {
+      for (Expr app : rules [i].apps)
+        if (!derivable.count (bind::fname (app))) fires [i] = false;
+      if (fires [i]) defs [bind::fname (rules [i].head)].push_back (i);
+    }
+
+    ExprSet queries, needed;
+    ExprVector todo;
+    for (Expr q : db.getQueries ())
+      if (bind::isFapp (q))
+      {
+        queries.insert (bind::fname (q));
+        todo.push_back (bind::fname (q));
+      }
+    while (!todo.empty ())
+    {
+      Expr rel = todo.back ();
+      todo.pop_back ();
+      if (!needed.insert (rel).second) continue;
+      for (unsigned i : defs [rel])
+        for (Expr app : rules [i].apps) todo.push_back (bind::fname (app));
+    }
+
+    ExprVector kept;
+    unsigned removedRels = 0, removedRules = 0;
+    for (Expr rel : db.getRelations ())
+    {
+      if (needed.count (rel) && (derivable.count (rel) || queries.count (rel)))
+        kept.push_back (rel);
+      else
+        ++removedRels;
+    }
+    for (unsigned i = 0; i < rules.size (); ++i)
+      if (!fires [i] || !needed.count (bind::fname (rules [i].head))) ++removedRules;
+
+    ufo::Stats::uset ("HornSliceRels", removedRels);
+    ufo::Stats::uset ("HornSliceRules", removedRules);
+    LOG ("slice", llvm::errs () << "Sliced " << removedRels << " relations and "
+         << removedRules << " rules\n";);
+    if (removedRels == 0 && removedRules == 0) return false;
+
+    for (Expr rel : db.getRelations ())
+    {
+      if (std::find (kept.begin (), kept.end (), rel) != kept.end ())
+        out.registerRelation (rel);
+      else
+        converter.addRemoved (rel, derivable.count (rel) ?
+                              mk<TRUE> (rel->efac ()) : mk<FALSE> (rel->efac ()));
+    }
+    const HornClauseDB::RuleVector &orig = db.getRules ();
+    for (unsigned i = 0; i < rules.size (); ++i)
+      if (fires [i] && needed.count (bind::fname (rules [i].head)))
+        out.addRule (orig [i]);
+    for (Expr q : db.getQueries ()) out.addQuery (q);
+    copyConstraints (db, out, kept);
+    converter.setNewDB (out);
+    return true;
+  }
+
+  bool inlineHornClauseDB (HornClauseDB &db, HornClauseDB &out,
+                           InlineHornModelConverter &converter)
+  {
+    ufo::ScopedStats _st_ ("HornClauseDB::inline");
+    typedef InlineHornModelConverter::Key Key;
+
+    std::vector<RuleInfo> rules;
+    for (const HornRule &r : db.getRules ()) rules.push_back (RuleInfo (r, db));
+    std::vector<bool> dead (rules.size (), false);
+    /// -- relations skipped by every rule
+    std::vector<ExprVector> paths (rules.size ());
+
+    ExprSet fixed;
+    for (Expr q : db.getQueries ())
+      if (bind::isFapp (q)) fixed.insert (bind::fname (q));
+    for (Expr rel : db.getRelations ())
+      if (db.hasConstraints (rel)) fixed.insert (rel);
+
+    auto key = [] (const RuleInfo &r)
+      {
+        Expr src = r.apps.empty () ? Expr () : bind::fname (bind::fname (r.apps [0]));
+        return Key (src, bind::fname (bind::fname (r.head)));
+      };
+
+    // -- rules defining and using every relation, and rules by key
+    std::map<Expr, std::vector<unsigned> > defs, uses;
+    std::map<Key, unsigned> keys;
+    ExprVector order;
+    for (unsigned i = 0; i < rules.size (); ++i)
+    {
+      Expr rel = bind::fname (rules [i].head);
+      if (defs [rel].empty ()) order.push_back (rel);
+      defs [rel].push_back (i);
+      for (Expr app : rules [i].apps) uses [bind::fname (app)].push_back (i);
+      ++keys [key (rules [i])];
+    }
+
+    ExprSet inlined;
+    unsigned fresh = 0;
+    for (bool changed = true; changed; )
+    {
+      changed = false;
+      for (Expr rel : order)
+      {
+        if (fixed.count (rel) || defs [rel].size () != 1 || uses [rel].size () != 1)
+          continue;
+        unsigned di = defs [rel][0], ui = uses [rel][0];
+        RuleInfo &d = rules [di];
+        RuleInfo &u = rules [ui];
+        // -- only the source of a rule is inlined. The rule defining
+        // -- rel does not use it, since rel has a single use
+        if (di == ui || bind::fname (u.apps [0]) != rel) continue;
+
+        // -- variables of d: head variables become the arguments of
+        // -- the use, the others are renamed apart
+        Expr use = u.apps [0];
+        ExprMap sub;
+        ExprVector eqs, vars;
+        bool ok = true;
+        for (unsigned i = 1; i < d.head->arity (); ++i)
+        {
+          Expr h = d.head->arg (i);
+          if (d.varSet.count (h) && !sub.count (h)) sub [h] = use->arg (i);
+        }
+        for (Expr v : d.vars)
+        {
+          if (sub.count (v)) continue;
+          if (!bind::isFapp (v) || v->arity () != 1) { ok = false; break; }
+          Expr name = variant::variant (fresh++, variant::tag (bind::fname (bind::fname (v)), "inl"));
+          Expr nv = bind::mkConst (name, bind::typeOf (v));
+          sub [v] = nv;
+          vars.push_back (nv);
+        }
+        if (!ok) continue;
+        for (unsigned i = 1; i < d.head->arity (); ++i)
+        {
+          Expr h = d.head->arg (i);
+          if (sub.count (h) && sub [h] == use->arg (i)) continue;
+          eqs.push_back (mk<EQ> (use->arg (i), replace (h, sub)));
+        }
+
+        ExprVector apps;
+        for (Expr a : d.apps) apps.push_back (replace (a, sub));
+        apps.insert (apps.end (), u.apps.begin () + 1, u.apps.end ());
+
+        Key oldD = key (d), oldU = key (u);
+        Key k (apps.empty () ? Expr () : bind::fname (bind::fname (apps [0])),
+               bind::fname (bind::fname (u.head)));
+        // -- the new rule must be the only one between its source and
+        // -- head. The two rules it replaces do not count
+        unsigned others = keys [k] - (k == oldD ? 1 : 0) - (k == oldU ? 1 : 0);
+        if (others > 0) continue;
+
+        converter.addInlined (rel, d.vars, d.head, d.apps, d.constraints);
+
+        ExprVector path (paths [di]);
+        path.push_back (rel);
+        path.insert (path.end (), paths [ui].begin (), paths [ui].end ());
+        paths [ui] = path;
+
+        --keys [oldD];
+        --keys [oldU];
+        ++keys [k];
+        for (Expr a : d.apps)
+          for (unsigned &j : uses [bind::fname (a)])
+            if (j == di) j = ui;
+        defs [rel].clear ();
+        uses [rel].clear ();
+
+        u.vars.insert (u.vars.end (), vars.begin (), vars.end ());
+        u.varSet.insert (vars.begin (), vars.end ());
+        u.apps = apps;
+        for (Expr c : d.constraints) u.constraints.push_back (replace (c, sub));
+        u.constraints.insert (u.constraints.end (), eqs.begin (), eqs.end ());
+        u.index ();
+        dead [di] = true;
+
+        inlined.insert (rel);
+        changed = true;
+      }
+    }
+
+    ufo::Stats::uset ("HornInlinedRels", inlined.size ());
+    LOG ("inline", llvm::errs () << "Inlined " << inlined.size () << " relations\n";);
+    if (inlined.empty ()) return false;
+
+    ExprVector kept;
+    for (Expr rel : db.getRelations ())
+    {
+      if (inlined.count (rel)) continue;
+      kept.push_back (rel);
+      out.registerRelation (rel);
+    }
+    for (unsigned i = 0; i < rules.size (); ++i)
+    {
+      if (dead [i]) continue;
+      out.addRule (rules [i].rule (out));
+      if (!paths [i].empty ()) converter.addPath (key (rules [i]), paths [i]);
+    }
+    for (Expr q : db.getQueries ()) out.addQuery (q);
+    copyConstraints (db, out, kept);
+    converter.setNewDB (out);
+    return true;
+  }
 }
@@ -10,5 +10,163 @@
 
 namespace seahorn
 {
+  namespace
+  {
+    /// application of rel to its canonical arguments
+    Expr relApp (Expr rel)
+    {
+      ExprVector args;
+      for (unsigned i = 0, sz = bind::domainSz (rel); i < sz; ++i)
+      {
+        Expr V = mkTerm<std::string> ("V", rel->efac ());
+        args.push_back (bind::mkConst (variant::variant (i, V),
+                                       bind::domainTy (rel, i)));
+      }
+      return bind::fapp (rel, args);
+    }
 
+    struct IsIn : public std::unary_function<Expr, bool>
+    {
+      const ExprSet &m_set;
+      IsIn (const ExprSet &s) : m_set (s) {}
+      bool operator() (Expr e) {return m_set.count (e) > 0;}
+    };
+  }
+
+  bool ArgElimHornModelConverter::convert (HornDbModel &in, HornDbModel &out)
+  {
+    if (!m_db) return false;
+
+    for (Expr rel : m_db->getRelations ())
+    {
+      auto it = m_args.find (rel);
+      Expr orig = it != m_args.end () ? it->second.orig : rel;
+
+      Expr origApp = relApp (orig);
+      if (it == m_args.end ())
+      {
+        out.addDef (origApp, in.getDef (origApp));
+        continue;
+      }
+      ExprVector args (++origApp->args_begin (), origApp->args_end ());
+
+      const ArgMap &m = it->second;
+      ExprVector newArgs (bind::domainSz (rel));
+      ExprVector conjs;
+      for (unsigned i = 0, sz = args.size (); i < sz; ++i)
+      {
+        if (m.pos [i] >= 0) newArgs [m.pos [i]] = args [i];
+        else if (m.vals [i]) conjs.push_back (mk<EQ> (args [i], m.vals [i]));
+      }
+
+      Expr def = in.getDef (bind::fapp (rel, newArgs));
+      if (!conjs.empty () && !isOpX<FALSE> (def))
+      {
+        if (!isOpX<TRUE> (def)) conjs.push_back (def);
+        def = boolop::land (conjs);
+      }
+      out.addDef (origApp, def);
+    }
+    return true;
+  }
+
+  bool SliceHornModelConverter::convert (HornDbModel &in, HornDbModel &out)
+  {
+    if (!m_db) return false;
+
+    for (Expr rel : m_db->getRelations ())
+    {
+      Expr app = relApp (rel);
+      out.addDef (app, in.getDef (app));
+    }
+    for (auto &kv : m_removed) out.addDef (relApp (kv.first), kv.second);
+    return true;
+  }
+
+  void InlineHornModelConverter::addInlined (Expr rel, const ExprVector &vars,
+                                             Expr head, const ExprVector &apps,
+                                             const ExprVector &constraints)
+  {
+    Inlined i;
+    i.rel = rel;
+    i.vars = vars;
+    i.head = head;
+    i.apps = apps;
+    i.constraints = constraints;
+    m_inlined.push_back (i);
+  }
+
+  bool InlineHornModelConverter::convert (HornDbModel &in, HornDbModel &out)
+  {
+    if (!m_db) return false;
+
+    for (Expr rel : m_db->getRelations ())
+    {
+      Expr app = relApp (rel);
+      out.addDef (app, in.getDef (app));
+    }
+
+    // -- a relation might use relations that were inlined after it
+    for (auto it = m_inlined.rbegin (), end = m_inlined.rend (); it != end; ++it)
+    {
+      // -- rel (V) := exists vars . body && V = head
+      Expr app = relApp (it->rel);
+      ExprVector conjs;
+      for (unsigned i = 1; i < app->arity (); ++i)
+        conjs.push_back (mk<EQ> (app->arg (i), it->head->arg (i)));
+      for (Expr a : it->apps) conjs.push_back (out.getDef (a));
+      conjs.insert (conjs.end (), it->constraints.begin (), it->constraints.end ());
+      Expr phi = boolop::land (conjs);
+
+      ExprSet vars (it->vars.begin (), it->vars.end ());
+      ExprSet bound;
+      filter (phi, IsIn (vars), std::inserter (bound, bound.begin ()));
+      Expr def = phi;
+      if (!bound.empty ())
+        def = boolop::lneg (z3_forall_elim (m_zctx, boolop::lneg (phi), bound));
+      out.addDef (app, z3_simplify (m_zctx, def));
+    }
+    return true;
+  }
+
+  void InlineHornModelConverter::convertCex (ExprVector &rules)
+  {
+    ExprVector res;
+    for (Expr r : rules)
+    {
+      Expr src;
+      Expr dst = isOpX<IMPL> (r) ? r->arg (1) : r;
+      if (isOpX<IMPL> (r))
+      {
+        Expr body = r->arg (0);
+        src = isOpX<AND> (body) ? body->arg (0) : body;
+        if (!bind::isFapp (src)) src.reset (0);
+      }
+      if (!bind::isFapp (dst))
+      {
+        res.push_back (r);
+        continue;
+      }
+
+      Key k (src ? bind::fname (bind::fname (src)) : Expr (),
+             bind::fname (bind::fname (dst)));
+      auto it = m_paths.find (k);
+      if (it == m_paths.end ())
+      {
+        res.push_back (r);
+        continue;
+      }
+
+      // -- rules are ordered from the query back to a fact
+      Expr next = dst;
+      for (auto p = it->second.rbegin (), end = it->second.rend (); p != end; ++p)
+      {
+        Expr app = relApp (*p);
+        res.push_back (mk<IMPL> (app, next));
+        next = app;
+      }
+      res.push_back (isOpX<IMPL> (r) ? mk<IMPL> (r->arg (0), next) : next);
+    }
+    rules.swap (res);
+  }
 }
@@ -0,0 +1,680 @@
+#include "seahorn/HornSampler.hh"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "ufo/Stats.hh"
+#include "avy/AvyDebug.h"
+
+#include <algorithm>
+
+static llvm::cl::opt<unsigned>
+SampleStates ("horn-sample-states",
+              llvm::cl::desc ("Maximum number of simulated states of a relation"),
+              llvm::cl::init (256), llvm::cl::Hidden);
+
+static llvm::cl::opt<unsigned>
+SampleRounds ("horn-sample-rounds",
+              llvm::cl::desc ("Maximum number of simulation rounds over all rules"),
+              llvm::cl::init (64), llvm::cl::Hidden);
+
+static llvm::cl::opt<unsigned>
+SampleTries ("horn-sample-tries",
+             llvm::cl::desc ("Times a rule is fired in a simulation round"),
+             llvm::cl::init (16), llvm::cl::Hidden);
+
+namespace seahorn
+{
+  namespace sampler
+  {
+    bool Val::operator< (const Val &o) const
+    {
+      if (kind != o.kind) return kind < o.kind;
+      if (width != o.width) return width < o.width;
+      if (kind != ARRAY) return num < o.num;
+      if (arr == o.arr) return false;
+      if (arr->def != o.arr->def) return arr->def < o.arr->def;
+      return arr->elems < o.arr->elems;
+    }
+
+    bool Val::operator== (const Val &o) const
+    {
+      if (kind != o.kind || width != o.width) return false;
+      if (kind != ARRAY) return num == o.num;
+      return arr == o.arr ||
+        (arr->def == o.arr->def && arr->elems == o.arr->elems);
+    }
+  }
+
+  using sampler::Val;
+  using sampler::ArrayVal;
+  using sampler::State;
+
+  namespace
+  {
+    Val mkBool (bool b)
+    {
+      Val v;
+      v.num = b ? 1 : 0;
+      return v;
+    }
+
+    Val mkInt (const mpz_class &n)
+    {
+      Val v;
+      v.kind = Val::INT;
+      v.num = n;
+      return v;
+    }
+
+    /// n modulo 2^width
+    Val mkBv (const mpz_class &n, unsigned width)
+    {
+      Val v;
+      v.kind = Val::BV;
+      v.width = width;
+      mpz_fdiv_r_2exp (v.num.get_mpz_t (), n.get_mpz_t (), width);
+      return v;
+    }
+
+    Val mkArray (const Val &def)
+    {
+      std::shared_ptr<ArrayVal> a (new ArrayVal ());
+      a->def = def;
+      Val v;
+      v.kind = Val::ARRAY;
+      v.arr = a;
+      return v;
+    }
+
+    /// two's complement value of a bit-vector
+    mpz_class toSigned (const Val &v)
+    {
+      if (v.width == 0 || mpz_tstbit (v.num.get_mpz_t (), v.width - 1) == 0)
+        return v.num;
+      mpz_class p;
+      mpz_ui_pow_ui (p.get_mpz_t (), 2, v.width);
+      return v.num - p;
+    }
+
+    /// Euclidean division and modulo, as in SMT-LIB. b is not 0
+    mpz_class emod (const mpz_class &a, const mpz_class &b)
+    {
+      mpz_class r;
+      mpz_fdiv_r (r.get_mpz_t (), a.get_mpz_t (), b.get_mpz_t ());
+      if (r < 0) r -= b;
+      return r;
+    }
+
+    mpz_class ediv (const mpz_class &a, const mpz_class &b)
+    {
+      mpz_class q = a - emod (a, b);
+      mpz_divexact (q.get_mpz_t (), q.get_mpz_t (), b.get_mpz_t ());
+      return q;
+    }
+
+    /**
+     * Evaluates terms over values of their constants (and bound
+     * variables). A term is known once all the constants it needs are
+     * bound. The evaluator is stuck on terms it does not support. A
+     * division by zero fails only the current sample.
+     */
+    class Evaluator
+    {
+      std::map<Expr, Val> m_vals;
+      bool m_stuck;
+      bool m_failed;
+
+      bool evalOp (Expr e, Val &out);
+      bool evalBv (Expr e, Val &out);
+      bool evalBvShift (Expr e, const Val &a, const Val &b, Val &out);
+      bool evalArgs (Expr e, std::vector<Val> &vals);
+      bool stuck () { m_stuck = true; return false; }
+      bool fail () { m_failed = true; return false; }
+
+    public:
+      Evaluator () : m_stuck (false), m_failed (false) {}
+
+      void bind (Expr v, const Val &val) { m_vals [v] = val; }
+      bool isBound (Expr v) const { return m_vals.count (v) > 0; }
+      bool isStuck () const { return m_stuck; }
+      bool isFailed () const { return m_failed; }
+
+      /// the value of e, if it is known
+      bool eval (Expr e, Val &out)
+      {
+        auto it = m_vals.find (e);
+        if (it != m_vals.end ())
+        {
+          out = it->second;
+          return true;
+        }
+        if (m_stuck || m_failed || !evalOp (e, out)) return false;
+        // -- only known values are cached. Others may become known
+        m_vals [e] = out;
+        return true;
+      }
+    };
+
+    bool Evaluator::evalArgs (Expr e, std::vector<Val> &vals)
+    {
+      vals.resize (e->arity ());
+      for (unsigned i = 0, sz = e->arity (); i < sz; ++i)
+        if (!eval (e->arg (i), vals [i])) return false;
+      return true;
+    }
+
+    bool Evaluator::evalOp (Expr e, Val &out)
+    {
+      if (isOpX<TRUE> (e)) { out = mkBool (true); return true; }
+      if (isOpX<FALSE> (e)) { out = mkBool (false); return true; }
+      if (isOpX<MPZ> (e)) { out = mkInt (getTerm<mpz_class> (e)); return true; }
+      if (bv::is_bvnum (e))
+      {
+        out = mkBv (bv::toMpz (e), bv::width (e->arg (1)));
+        return true;
+      }
+      // -- unbound constant or bound variable
+      if (bind::IsConst () (e) || isOpX<BIND> (e)) return false;
+
+      if (isOpX<AND> (e) || isOpX<OR> (e) || isOpX<IMPL> (e))
+      {
+        // -- known as soon as one argument decides it
+        bool isAnd = isOpX<AND> (e);
+        bool known = true;
+        for (unsigned i = 0, sz = e->arity (); i < sz; ++i)
+        {
+          Val v;
+          if (!eval (e->arg (i), v))
+          {
+            if (m_stuck || m_failed) return false;
+            known = false;
+            continue;
+          }
+          bool b = v.num != 0;
+          if (isOpX<IMPL> (e) && i == 0) b = !b;
+          if (b != isAnd) { out = mkBool (b); return true; }
+        }
+        if (!known) return false;
+        out = mkBool (isAnd);
+        return true;
+      }
+
+      if (isOpX<ITE> (e))
+      {
+        Val c;
+        if (!eval (e->arg (0), c)) return false;
+        return eval (e->arg (c.num != 0 ? 1 : 2), out);
+      }
+
+      if (isOpX<CONST_ARRAY> (e))
+      {
+        // -- the first argument is the index sort
+        Val def;
+        if (!eval (e->arg (1), def)) return false;
+        out = mkArray (def);
+        return true;
+      }
+
+      if (isOp<BvOp> (e)) return evalBv (e, out);
+
+      std::vector<Val> a;
+      if (!evalArgs (e, a)) return false;
+
+      if (isOpX<NEG> (e)) { out = mkBool (a [0].num == 0); return true; }
+      if (isOpX<IFF> (e)) { out = mkBool ((a [0].num != 0) == (a [1].num != 0)); return true; }
+      if (isOpX<XOR> (e)) { out = mkBool ((a [0].num != 0) != (a [1].num != 0)); return true; }
+      if (isOpX<EQ> (e)) { out = mkBool (a [0] == a [1]); return true; }
+      if (isOpX<NEQ> (e)) { out = mkBool (a [0] != a [1]); return true; }
+
+      if (isOpX<LT> (e)) { out = mkBool (a [0].num < a [1].num); return true; }
+      if (isOpX<LEQ> (e)) { out = mkBool (a [0].num <= a [1].num); return true; }
+      if (isOpX<GT> (e)) { out = mkBool (a [0].num > a [1].num); return true; }
+      if (isOpX<GEQ> (e)) { out = mkBool (a [0].num >= a [1].num); return true; }
+
+      if (isOpX<PLUS> (e) || isOpX<MULT> (e) || isOpX<MINUS> (e))
+      {
+        mpz_class r = a [0].num;
+        for (unsigned i = 1, sz = a.size (); i < sz; ++i)
+        {
+          if (isOpX<PLUS> (e)) r += a [i].num;
+          else if (isOpX<MULT> (e)) r *= a [i].num;
+          else r -= a [i].num;
+        }
+        out = mkInt (r);
+        return true;
+      }
+      if (isOpX<UN_MINUS> (e)) { out = mkInt (-a [0].num); return true; }
+      if (isOpX<ABS> (e)) { out = mkInt (abs (a [0].num)); return true; }
+      if (isOpX<DIV> (e) || isOpX<IDIV> (e) || isOpX<MOD> (e) || isOpX<REM> (e))
+      {
+        const mpz_class &b = a [1].num;
+        if (b == 0) return fail ();
+        if (isOpX<MOD> (e)) out = mkInt (emod (a [0].num, b));
+        else if (isOpX<REM> (e))
+          out = mkInt (b >= 0 ? emod (a [0].num, b) : mpz_class (-emod (a [0].num, b)));
+        else out = mkInt (ediv (a [0].num, b));
+        return true;
+      }
+
+      if (isOpX<SELECT> (e))
+      {
+        const ArrayVal &arr = *a [0].arr;
+        auto it = arr.elems.find (a [1].num);
+        out = it == arr.elems.end () ? arr.def : it->second;
+        return true;
+      }
+      if (isOpX<STORE> (e))
+      {
+        std::shared_ptr<ArrayVal> arr (new ArrayVal (*a [0].arr));
+        if (a [2] == arr->def) arr->elems.erase (a [1].num);
+        else arr->elems [a [1].num] = a [2];
+        out = a [0];
+        out.arr = arr;
+        return true;
+      }
+
+      LOG ("sampler", errs () << "Cannot evaluate: " << *e << "\n";);
+      return stuck ();
+    }
+
+    bool Evaluator::evalBv (Expr e, Val &out)
+    {
+      if (isOpX<BEXTRACT> (e))
+      {
+        Val v;
+        if (!eval (bv::earg (e), v)) return false;
+        mpz_class r;
+        mpz_fdiv_q_2exp (r.get_mpz_t (), v.num.get_mpz_t (), bv::low (e));
+        out = mkBv (r, bv::high (e) - bv::low (e) + 1);
+        return true;
+      }
+      if (isOpX<BSEXT> (e) || isOpX<BZEXT> (e))
+      {
+        // -- the second argument is the sort of the result
+        Val v;
+        if (!eval (e->arg (0), v)) return false;
+        out = mkBv (isOpX<BSEXT> (e) ? toSigned (v) : v.num, bv::width (e->arg (1)));
+        return true;
+      }
+
+      std::vector<Val> a;
+      if (!evalArgs (e, a)) return false;
+      if (isOpX<BV2INT> (e)) { out = mkInt (a [0].num); return true; }
+
+      unsigned w = a [0].width;
+      const mpz_class &x = a [0].num;
+      if (isOpX<BNOT> (e)) { out = mkBv (-x - 1, w); return true; }
+      if (isOpX<BNEG> (e)) { out = mkBv (-x, w); return true; }
+
+      if (isOpX<BADD> (e) || isOpX<BMUL> (e) ||
+          isOpX<BAND> (e) || isOpX<BOR> (e) || isOpX<BXOR> (e))
+      {
+        mpz_class r = x;
+        for (unsigned i = 1, sz = a.size (); i < sz; ++i)
+        {
+          if (isOpX<BADD> (e)) r += a [i].num;
+          else if (isOpX<BMUL> (e)) r *= a [i].num;
+          else if (isOpX<BAND> (e)) r &= a [i].num;
+          else if (isOpX<BOR> (e)) r |= a [i].num;
+          else r ^= a [i].num;
+        }
+        out = mkBv (r, w);
+        return true;
+      }
+
+      if (a.size () != 2) return stuck ();
+      const mpz_class &y = a [1].num;
+      if (isOpX<BCONCAT> (e))
+      {
+        mpz_class r;
+        mpz_mul_2exp (r.get_mpz_t (), x.get_mpz_t (), a [1].width);
+        out = mkBv (r + y, w + a [1].width);
+        return true;
+      }
+      if (isOpX<BSUB> (e)) { out = mkBv (x - y, w); return true; }
+      if (isOpX<BNAND> (e)) { out = mkBv (-(x & y) - 1, w); return true; }
+      if (isOpX<BNOR> (e)) { out = mkBv (-(x | y) - 1, w); return true; }
+      if (isOpX<BXNOR> (e)) { out = mkBv (-(x ^ y) - 1, w); return true; }
+
+      if (isOpX<BULT> (e)) { out = mkBool (x < y); return true; }
+      if (isOpX<BULE> (e)) { out = mkBool (x <= y); return true; }
+      if (isOpX<BUGT> (e)) { out = mkBool (x > y); return true; }
+      if (isOpX<BUGE> (e)) { out = mkBool (x >= y); return true; }
+      if (isOpX<BSLT> (e)) { out = mkBool (toSigned (a [0]) < toSigned (a [1])); return true; }
+      if (isOpX<BSLE> (e)) { out = mkBool (toSigned (a [0]) <= toSigned (a [1])); return true; }
+      if (isOpX<BSGT> (e)) { out = mkBool (toSigned (a [0]) > toSigned (a [1])); return true; }
+      if (isOpX<BSGE> (e)) { out = mkBool (toSigned (a [0]) >= toSigned (a [1])); return true; }
+
+      if (isOpX<BUDIV> (e) || isOpX<BUREM> (e) ||
+          isOpX<BSDIV> (e) || isOpX<BSREM> (e) || isOpX<BSMOD> (e))
+      {
+        if (y == 0) return fail ();
+        mpz_class sx = toSigned (a [0]), sy = toSigned (a [1]), r;
+        if (isOpX<BUDIV> (e)) r = x / y;
+        else if (isOpX<BUREM> (e)) r = x % y;
+        // -- truncating, the remainder has the sign of the dividend
+        else if (isOpX<BSDIV> (e)) r = sx / sy;
+        else if (isOpX<BSREM> (e)) r = sx % sy;
+        // -- the sign of the divisor
+        else mpz_fdiv_r (r.get_mpz_t (), sx.get_mpz_t (), sy.get_mpz_t ());
+        out = mkBv (r, w);
+        return true;
+      }
+
+      if (isOpX<BSHL> (e) || isOpX<BLSHR> (e) || isOpX<BASHR> (e))
+      {
+        unsigned long s = y < w ? y.get_ui () : w;
+        mpz_class r;
+        if (isOpX<BSHL> (e)) mpz_mul_2exp (r.get_mpz_t (), x.get_mpz_t (), s);
+        else
+        {
+          mpz_class v = isOpX<BASHR> (e) ? toSigned (a [0]) : x;
+          mpz_fdiv_q_2exp (r.get_mpz_t (), v.get_mpz_t (), s);
+        }
+        out = mkBv (r, w);
+        return true;
+      }
+
+      LOG ("sampler", errs () << "Cannot evaluate: " << *e << "\n";);
+      return stuck ();
+    }
+
+    struct IsNum : public std::unary_function<Expr,bool>
+    {
+      bool operator() (Expr e) { return isOpX<MPZ> (e); }
+    };
+
+    /// conjuncts of a rule body, split into applications of relations
+    /// and constraints
+    void splitBody (Expr e, HornClauseDB &db, ExprVector &apps, ExprVector &conds)
+    {
+      if (isOpX<AND> (e))
+      {
+        for (unsigned i = 0, sz = e->arity (); i < sz; ++i)
+          splitBody (e->arg (i), db, apps, conds);
+      }
+      else if (IsPredApp (db) (e)) apps.push_back (e);
+      else if (!isOpX<TRUE> (e)) conds.push_back (e);
+    }
+
+    /// x = e or e = x with x not yet known
+    bool isDefinition (Expr c, Evaluator &ev, Expr &x, Expr &def)
+    {
+      if (!isOpX<EQ> (c)) return false;
+      for (unsigned i = 0; i < 2; ++i)
+      {
+        if (bind::IsConst () (c->arg (i)) && !ev.isBound (c->arg (i)))
+        {
+          x = c->arg (i);
+          def = c->arg (1 - i);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /// A constant of c that is not known yet. For x = e, a constant of e
+    /// is preferred, so that x is then computed
+    Expr unboundConst (Expr c, Evaluator &ev)
+    {
+      Expr x, def;
+      if (isDefinition (c, ev, x, def))
+        if (Expr y = unboundConst (def, ev)) return y;
+
+      ExprVector consts;
+      filter (c, bind::IsConst (), std::back_inserter (consts));
+      for (Expr k : consts)
+        if (!ev.isBound (k)) return k;
+      return Expr ();
+    }
+  }
+
+  HornSampler::HornSampler (HornClauseDB &db, unsigned seed) :
+    m_db (db), m_rng (seed)
+  {
+    std::set<mpz_class> consts;
+    for (const HornRule &r : db.getRules ())
+    {
+      ExprVector nums;
+      filter (r.body (), IsNum (), std::back_inserter (nums));
+      for (Expr n : nums)
+      {
+        const mpz_class &v = getTerm<mpz_class> (n);
+        // -- loop bounds are often crossed by one
+        for (int d = -1; d <= 1; ++d) consts.insert (v + d);
+      }
+    }
+    m_consts.assign (consts.begin (), consts.end ());
+  }
+
+  Val HornSampler::random (Expr ty, bool &ok)
+  {
+    if (isOpX<BOOL_TY> (ty))
+      return mkBool (std::uniform_int_distribution<int> (0, 1) (m_rng) != 0);
+
+    // -- half of the values are constants of the rules, the others small
+    mpz_class n = std::uniform_int_distribution<int> (-8, 8) (m_rng);
+    if (!m_consts.empty () && std::uniform_int_distribution<int> (0, 1) (m_rng))
+      n = m_consts [std::uniform_int_distribution<size_t> (0, m_consts.size () - 1) (m_rng)];
+
+    if (isOpX<INT_TY> (ty)) return mkInt (n);
+    if (isOpX<BVSORT> (ty)) return mkBv (n, bv::width (ty));
+    if (isOpX<ARRAY_TY> (ty)) return mkArray (random (sort::arrayValTy (ty), ok));
+
+    ok = false;
+    return Val ();
+  }
+
+  StateSamples &HornSampler::columns (Expr fdecl)
+  {
+    auto it = m_samples.find (fdecl);
+    if (it != m_samples.end ()) return it->second;
+
+    StateSamples &s = m_samples [fdecl];
+    for (unsigned i = 0, sz = bind::domainSz (fdecl); i < sz; ++i)
+      if (isOpX<INT_TY> (bind::domainTy (fdecl, i))) s.args.push_back (i);
+    s.cols.resize (s.args.size ());
+    return s;
+  }
+
+  bool HornSampler::addState (Expr fdecl, const State &s)
+  {
+    if (!m_known [fdecl].insert (s).second) return false;
+    m_states [fdecl].push_back (s);
+    ufo::Stats::count ("HornSamplerStates");
+
+    StateSamples &c = columns (fdecl);
+    for (unsigned a : c.args)
+      if (!s [a].num.fits_slong_p ()) return true;
+    for (unsigned i = 0, sz = c.args.size (); i < sz; ++i)
+      c.cols [i].push_back (s [c.args [i]].num.get_si ());
+    return true;
+  }
+
+  /*
+   * Fires r once on random states of its body relations. Returns true
+   * if it reached a new state of its head. unsupported is set if r
+   * cannot be simulated at all.
+   */
+  bool HornSampler::fire (const HornRule &r, const ExprVector &apps,
+                          const ExprVector &conds, bool &unsupported)
+  {
+    Evaluator ev;
+    // -- arguments of the body applications that are not plain
+    // -- constants, with their values
+    std::vector<std::pair<Expr, Val> > args;
+    for (Expr app : apps)
+    {
+      // -- newer states are preferred, to get deeper ones
+      const std::vector<State> &states = m_states [bind::fname (app)];
+      size_t lo = std::uniform_int_distribution<int> (0, 1) (m_rng) ? states.size () / 2 : 0;
+      const State &s =
+        states [std::uniform_int_distribution<size_t> (lo, states.size () - 1) (m_rng)];
+      for (unsigned i = 0, sz = s.size (); i < sz; ++i)
+      {
+        Expr a = app->arg (i + 1);
+        if (bind::IsConst () (a) && !ev.isBound (a)) ev.bind (a, s [i]);
+        else args.push_back (std::make_pair (a, s [i]));
+      }
+    }
+
+    ExprVector pending (conds.begin (), conds.end ());
+    while (!pending.empty () || !args.empty ())
+    {
+      bool progress = false;
+      for (unsigned i = 0; i < args.size ();)
+      {
+        Val v;
+        if (ev.eval (args [i].first, v))
+        {
+          if (v != args [i].second) return false;
+          args.erase (args.begin () + i);
+          progress = true;
+        }
+        else ++i;
+      }
+
+      for (unsigned i = 0; i < pending.size ();)
+      {
+        Expr c = pending [i];
+        Val v, d;
+        Expr x, def;
+        if (ev.eval (c, v))
+        {
+          if (v.num == 0) return false;
+          pending.erase (pending.begin () + i);
+          progress = true;
+          continue;
+        }
+        if (ev.isStuck () || ev.isFailed ()) break;
+
+        if (isDefinition (c, ev, x, def) && ev.eval (def, d))
+        {
+          ev.bind (x, d);
+          progress = true;
+        }
+        else if (bind::isBoolConst (c))
+        {
+          ev.bind (c, mkBool (true));
+          progress = true;
+        }
+        else if (isOpX<NEG> (c) && bind::isBoolConst (c->left ()))
+        {
+          ev.bind (c->left (), mkBool (false));
+          progress = true;
+        }
+        ++i;
+      }
+
+      if (ev.isFailed ()) return false;
+      if (ev.isStuck ()) { unsupported = true; return false; }
+      if (progress) continue;
+
+      // -- nothing follows from what is known: a nondet value
+      Expr c = pending.empty () ? args [0].first : pending [0];
+      Expr x = unboundConst (c, ev);
+      bool ok = true;
+      Val v = x ? random (bind::typeOf (x), ok) : Val ();
+      if (!x || !ok) { unsupported = true; return false; }
+      ev.bind (x, v);
+    }
+
+    Expr head = r.head ();
+    Expr rel = bind::fname (head);
+    State s (bind::domainSz (rel));
+    for (unsigned i = 0, sz = s.size (); i < sz; ++i)
+    {
+      Expr a = head->arg (i + 1);
+      while (!ev.eval (a, s [i]))
+      {
+        if (ev.isFailed ()) return false;
+        Expr x = ev.isStuck () ? Expr () : unboundConst (a, ev);
+        bool ok = true;
+        Val v = x ? random (bind::typeOf (x), ok) : Val ();
+        if (!x || !ok) { unsupported = true; return false; }
+        ev.bind (x, v);
+      }
+    }
+    return addState (rel, s);
+  }
+
+  void HornSampler::run ()
+  {
+    ufo::ScopedStats _st_ ("HornSampler");
+
+    struct Step
+    {
+      const HornRule *rule;
+      ExprVector apps, conds;
+      bool disabled;
+    };
+    std::vector<Step> steps;
+    for (const HornRule &r : m_db.getRules ())
+    {
+      if (!bind::isFapp (r.head ())) continue;
+      Step st;
+      st.rule = &r;
+      st.disabled = false;
+      splitBody (r.body (), m_db, st.apps, st.conds);
+      steps.push_back (st);
+    }
+
+    for (unsigned round = 0; round < SampleRounds; ++round)
+    {
+      bool changed = false;
+      for (Step &st : steps)
+      {
+        if (st.disabled) continue;
+        Expr rel = bind::fname (st.rule->head ());
+        bool ready = true;
+        for (Expr app : st.apps)
+          ready = ready && numStates (bind::fname (app)) > 0;
+        if (!ready) continue;
+
+        for (unsigned t = 0; t < SampleTries && numStates (rel) < SampleStates; ++t)
+        {
+          bool unsupported = false;
+          if (fire (*st.rule, st.apps, st.conds, unsupported)) changed = true;
+          if (unsupported)
+          {
+            LOG ("sampler", errs () << "Cannot simulate rule of "
+                 << *bind::fname (rel) << "\n";);
+            ufo::Stats::count ("HornSamplerUnsupportedRules");
+            st.disabled = true;
+            break;
+          }
+        }
+      }
+      if (!changed) break;
+    }
+  }
+
+  size_t HornSampler::numStates (Expr fdecl) const
+  {
+    auto it = m_states.find (fdecl);
+    return it == m_states.end () ? 0 : it->second.size ();
+  }
+
+  const StateSamples &HornSampler::samples (Expr fdecl)
+  {return columns (fdecl);}
+
+  bool HornSampler::refutes (Expr fdecl, Expr cand)
+  {
+    auto it = m_states.find (fdecl);
+    if (it == m_states.end ()) return false;
+
+    ExprVector bvars;
+    for (unsigned i = 0, sz = bind::domainSz (fdecl); i < sz; ++i)
+      bvars.push_back (bind::bvar (i, bind::domainTy (fdecl, i)));
+
+    for (const State &s : it->second)
+    {
+      Evaluator ev;
+      for (unsigned i = 0, sz = s.size (); i < sz; ++i) ev.bind (bvars [i], s [i]);
+      Val v;
+      if (ev.eval (cand, v) && v.num == 0) return true;
+    }
+    return false;
+  }
+}
@@ -5,11 +5,13 @@
 
 #include "llvm/IR/Function.h"
 #include "llvm/Support/CommandLine.h"
+#include "seahorn/Support/ResourceGovernor.hh"
 #include "ufo/Stats.hh"
 
 #include "boost/range/algorithm/reverse.hpp"
 
 #include <climits>
+#include <thread>
 
 using namespace llvm;
 
@@ -33,6 +35,31 @@ SkipConstraints ("horn-skip-constraints",
                  cl::Hidden, cl::init(false),
                  cl::desc ("Enabled when number of predicates exceeds 200"));
 
+static llvm::cl::opt<bool>
+HornSlice ("horn-slice",
+           cl::desc ("Slice the database from its queries and facts"),
+           cl::init (false));
+
+static llvm::cl::opt<bool>
+HornInline ("horn-inline",
+            cl::desc ("Inline relations with a single rule and a single use"),
+            cl::init (false));
+
+static llvm::cl::opt<bool>
+HornElimArgs ("horn-elim-args",
+              cl::desc ("Remove constant and unused arguments of relations"),
+              cl::init (false));
+
+static llvm::cl::opt<bool>
+HornAig ("horn-aig",
+         cl::desc ("Simplify the Boolean structure of rule bodies with AIGs"),
+         cl::init (false));
+
+static llvm::cl::opt<unsigned>
+HornAigJobs ("horn-aig-jobs",
+             cl::desc ("Number of threads for --horn-aig (0 = one per core)"),
+             cl::init (0));
+
 static llvm::cl::opt<bool>
 Subsumption ("horn-subsumption", cl::Hidden, cl::init(true),
              cl::desc ("Setting to false helps with cex"));
@@ -88,11 +115,45 @@ namespace seahorn
     params.set (":pdr.max_level", HornMaxDepth);
     fp.set (params);
 
-    db.loadZFixedPoint (fp, SkipConstraints);
+    // -- the database that is solved. Models are mapped back to db
+    HornClauseDB *solved = &db;
+    if (HornSlice)
+    {
+      std::unique_ptr<HornClauseDB> out (new HornClauseDB (db.getExprFactory ()));
+      SliceHornModelConverter *conv = new SliceHornModelConverter ();
+      if (sliceHornClauseDB (*solved, *out, *conv)) solved = addStage (out, conv);
+      else delete conv;
+    }
+    if (HornElimArgs)
+    {
+      std::unique_ptr<HornClauseDB> out (new HornClauseDB (db.getExprFactory ()));
+      ArgElimHornModelConverter *conv = new ArgElimHornModelConverter ();
+      if (eliminateArgs (*solved, *out, *conv)) solved = addStage (out, conv);
+      else delete conv;
+    }
+    if (HornInline)
+    {
+      std::unique_ptr<HornClauseDB> out (new HornClauseDB (db.getExprFactory ()));
+      InlineHornModelConverter *conv = new InlineHornModelConverter (hm.getZContext ());
+      if (inlineHornClauseDB (*solved, *out, *conv)) solved = addStage (out, conv);
+      else delete conv;
+    }
+
+    if (HornAig)
+      aigHornClauseDB (*solved, HornAigJobs > 0 ?
+                       (unsigned) HornAigJobs : std::thread::hardware_concurrency ());
+
+    solved->loadZFixedPoint (fp, SkipConstraints);
 
     Stats::resume ("Horn");
-    m_result = fp.query ();
+    {
+      ScopedPhase _phase ("solve");
+      EZ3 &zctx = hm.getZContext ();
+      ResourceGovernor::get ().onInterrupt ([&zctx] { zctx.interrupt (); });
+      m_result = fp.query ();
+    }
     Stats::stop ("Horn");
+    bool interrupted = ResourceGovernor::get ().exceeded ();
 
     if (m_result) outs () << "sat";
     else if (!m_result) outs () << "unsat";
@@ -109,11 +170,21 @@ namespace seahorn
     if (PrintAnswer && !m_result)
     {
       HornDbModel dbModel;
-      initDBModelFromFP(dbModel, db, fp);
+      getModel (db, dbModel);
       printInvars(M, dbModel);
     }
     else if (PrintAnswer && m_result)
       printCex ();
+    else if (PrintAnswer && interrupted)
+    {
+      // -- lemmas learned before the solver was interrupted. They
+      // -- over-approximate the reachable states of each predicate
+      // -- but are not necessarily inductive
+      outs () << "Partial invariants (solve budget exceeded):\n";
+      HornDbModel dbModel;
+      getModel (db, dbModel);
+      printInvars(M, dbModel);
+    }
 
     if (EstimateSizeInvars)
       estimateSizeInvars(M);
@@ -129,11 +200,10 @@ namespace seahorn
 
   void HornSolver::printCex ()
   {
-    ZFixedPoint<EZ3> fp = *m_fp;
-    //outs () << *fp.getCex () << "\n";
+    //outs () << *m_fp->getCex () << "\n";
 
     ExprVector rules;
-    fp.getCexRules (rules);
+    getCexRules (rules);
     boost::reverse (rules);
     for (Expr r : rules)
     {
@@ -164,10 +234,47 @@ namespace seahorn
 
   }
 
+  HornClauseDB *HornSolver::addStage (std::unique_ptr<HornClauseDB> &db,
+                                      HornModelConverter *converter)
+  {
+    m_dbs.push_back (std::move (db));
+    m_converters.push_back (std::unique_ptr<HornModelConverter> (converter));
+    return m_dbs.back ().get ();
+  }
+
+  void HornSolver::getModel (HornClauseDB &db, HornDbModel &model)
+  {
+    if (m_dbs.empty ())
+    {
+      initDBModelFromFP (model, db, *m_fp);
+      return;
+    }
+
+    HornDbModel cur;
+    initDBModelFromFP (cur, *m_dbs.back (), *m_fp);
+    for (unsigned i = m_converters.size (); i > 1; --i)
+    {
+      HornDbModel prev;
+      m_converters [i - 1]->convert (cur, prev);
+      cur = prev;
+    }
+    m_converters [0]->convert (cur, model);
+  }
+
+  void HornSolver::getCexRules (ExprVector &rules)
+  {
+    m_fp->getCexRules (rules);
+    for (unsigned i = m_converters.size (); i > 0; --i)
+      m_converters [i - 1]->convertCex (rules);
+  }
+
   void HornSolver::estimateSizeInvars (Module &M)
   {
     HornifyModule &hm = getAnalysis<HornifyModule> ();
-    ZFixedPoint<EZ3> fp = *m_fp;
+    // -- relations of the solved database might differ from the
+    // -- predicates of hm
+    HornDbModel model;
+    getModel (hm.getHornClauseDB (), model);
 
     Expr allInvars;
     bool first = true;
@@ -180,7 +287,7 @@ namespace seahorn
         if (!hm.hasBbPredicate (BB)) continue;
         Expr bbPred = hm.bbPredicate (BB);
         const ExprVector &live = hm.live (BB);
-        Expr invars = fp.getCoverDelta (bind::fapp (bbPred, live));
+        Expr invars = model.getDef (bind::fapp (bbPred, live));
         numBlocks++;
         if (first) {
           allInvars = invars;
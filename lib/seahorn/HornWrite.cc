@@ -56,7 +56,7 @@ namespace seahorn
     {
       normalizeHornClauseHeads (db);
       ClpWrite writer (db, efac);
-      m_out << writer.toString ();
+      writer.write (m_out);
     }
     else if (HornClauseFormat == MCMT)
     {
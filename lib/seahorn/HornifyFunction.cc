@@ -166,33 +166,40 @@ namespace seahorn
 
     for (auto &BB : F)
     {
-      // create predicate for the basic block
-      Expr decl = m_parent.bbPredicate (BB);
-      // register with fixedpoint
-      m_db.registerRelation (decl);
-      
       // -- attempt to extract FunctionInfo record from the current basic block
       // -- only succeeds if the current basic block is the last one
       // -- also constructs summary predicates
       if (m_interproc) extractFunctionInfo (BB);
+
+      // -- no predicate for a block that cannot reach the exit
+      if (m_parent.isDeadBb (BB)) continue;
+      // create predicate for the basic block
+      Expr decl = m_parent.bbPredicate (BB);
+      // register with fixedpoint
+      m_db.registerRelation (decl);
     }
 
     BasicBlock &entry = F.getEntryBlock ();
     ExprSet allVars;
     ExprVector args;
     SymStore s(m_efac);
-    for (const Expr& v : ls.live (&F.getEntryBlock ())) allVars.insert (s.read (v));
-    Expr rule = s.eval (bind::fapp (m_parent.bbPredicate (entry), ls.live (&entry)));
-    rule = boolop::limp (boolop::lneg (s.read (m_sem.errorFlag (entry))), rule);
-    m_db.addRule (allVars, rule);
-    allVars.clear ();
+    if (!m_parent.isDeadBb (entry))
+    {
+      for (const Expr& v : ls.live (&F.getEntryBlock ())) allVars.insert (s.read (v));
+      Expr rule = s.eval (bind::fapp (m_parent.bbPredicate (entry), ls.live (&entry)));
+      rule = boolop::limp (boolop::lneg (s.read (m_sem.errorFlag (entry))), rule);
+      m_db.addRule (allVars, rule);
+      allVars.clear ();
+    }
       
     ExprVector side;
     for (auto &BB : F)
     {
       const BasicBlock *bb = &BB;
+      if (m_parent.isDeadBb (BB)) continue;
       for (const BasicBlock *dst : succs (*bb))
       {
+        if (m_parent.isDeadBb (*dst)) continue;
         allVars.clear ();
         s.reset ();
         side.clear ();
@@ -235,7 +242,7 @@ namespace seahorn
 
     for (auto &BB : F)
     {
-      if (&BB == exit) continue;
+      if (&BB == exit || m_parent.isDeadBb (BB)) continue;
       
       // XXX Can optimize. Only need the rules for BBs that trip the
       // error flag (directly or indirectly)
@@ -313,6 +320,7 @@ namespace seahorn
 
     for (const CutPoint &cp : cpg)
     {
+      if (m_parent.isDeadBb (cp.bb ())) continue;
       Expr decl = m_parent.bbPredicate (cp.bb ());
       m_db.registerRelation (decl);
       if (m_interproc) extractFunctionInfo (cp.bb ());
@@ -326,9 +334,12 @@ namespace seahorn
     for (const Expr& v : ls.live (&entry)) args.push_back (s.read (v));
     allVars.insert (args.begin (), args.end ());
     
-    Expr rule = bind::fapp (m_parent.bbPredicate (entry), args);
-    rule = boolop::limp (boolop::lneg (s.read (m_sem.errorFlag (entry))), rule);
-    m_db.addRule (allVars, rule);
+    if (!m_parent.isDeadBb (entry))
+    {
+      Expr rule = bind::fapp (m_parent.bbPredicate (entry), args);
+      rule = boolop::limp (boolop::lneg (s.read (m_sem.errorFlag (entry))), rule);
+      m_db.addRule (allVars, rule);
+    }
     allVars.clear ();
     ZSolver<EZ3> smt (m_zctx);
     
@@ -343,7 +354,8 @@ namespace seahorn
     
 
     DenseSet<const BasicBlock*> reached;
-    reached.insert (&cpg.begin ()->bb ());
+    if (!m_parent.isDeadBb (cpg.begin ()->bb ()))
+      reached.insert (&cpg.begin ()->bb ());
     
     unsigned rule_cnt = 0;
     for (const CutPoint &cp : cpg)
@@ -353,6 +365,7 @@ namespace seahorn
         for (const CpEdge *edge : boost::make_iterator_range (cp.succ_begin (),
                                                               cp.succ_end ()))
         {
+          if (m_parent.isDeadBb (edge->target ().bb ())) continue;
           allVars.clear ();
           args.clear ();
           s.reset ();
@@ -451,7 +464,7 @@ namespace seahorn
 
     for (const CutPoint &cp : cpg)
     {
-      if (&cp.bb () == exit) continue;
+      if (&cp.bb () == exit || m_parent.isDeadBb (cp.bb ())) continue;
       
       // XXX Can optimize. Only need the rules for BBs that trip the
       // error flag (directly or indirectly)
@@ -13,6 +13,8 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/ADT/SCCIterator.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "seahorn/Support/BoostLlvmGraphTraits.hh"
 
 #include "boost/range.hpp"
@@ -26,6 +28,7 @@
 #include "seahorn/LiveSymbols.hh"
 
 #include "seahorn/Analysis/CutPointGraph.hh"
+#include "seahorn/Support/ResourceGovernor.hh"
 #include "seahorn/Analysis/CanFail.hh"
 #include "ufo/Smt/EZ3.hh"
 #include "ufo/Stats.hh"
@@ -33,6 +36,8 @@
 #include "seahorn/HornifyFunction.hh"
 #include "seahorn/FlatHornifyFunction.hh"
 #include "seahorn/IncHornifyFunction.hh"
+#include "seahorn/HornClauseDBBin.hh"
+#include "seahorn/IntervalPrune.hh"
 
 using namespace llvm;
 using namespace seahorn;
@@ -80,6 +85,23 @@ NoVerification("horn-no-verif",
           llvm::cl::desc ("Generate only SMT2 encoding (i.e. even if there are no assertions)"),
           cl::init (false));
 
+static llvm::cl::opt<std::string>
+DumpDb("horn-dump-db",
+       llvm::cl::desc ("Write the Horn clauses in binary form to this file"),
+       cl::init (""), cl::value_desc ("filename"));
+
+static llvm::cl::opt<std::string>
+ResumeDb("horn-resume-db",
+         llvm::cl::desc ("Load the Horn clauses written by --horn-dump-db "
+                         "for the same program instead of hornifying it"),
+         cl::init (""), cl::value_desc ("filename"));
+
+static llvm::cl::opt<bool>
+IntervalPruneOpt("horn-interval-prune",
+                 llvm::cl::desc ("Drop the predicates of blocks that an interval "
+                                 "analysis finds dead and add its invariants"),
+                 cl::init (false));
+
 static llvm::cl::list<std::string>
 AbstractFunctions("horn-abstract",
 		  llvm::cl::desc("Abstract all calls to these functions"),
@@ -126,9 +148,15 @@ namespace seahorn
   bool HornifyModule::runOnModule (Module &M)
   {
     ScopedStats _st ("HornifyModule");
+    ScopedPhase _phase ("hornify");
 
     bool Changed = false;
     m_td = &M.getDataLayout();
+
+    // -- before the cut-point graph changes the CFG
+    std::string fingerprint;
+    if (!DumpDb.empty () || !ResumeDb.empty ())
+      fingerprint = moduleFingerprint (M);
     m_canFail = getAnalysisIfAvailable<CanFail> ();
 
     typename UfoSmallSymExec::FunctionPtrSet abs_fns;
@@ -211,6 +239,8 @@ namespace seahorn
 	}
     }
     
+    if (!ResumeDb.empty () && resumeDb (M, fingerprint)) return Changed;
+
     // create FunctionInfo for verifier.error() function
     if (Function* errorFn = M.getFunction ("verifier.error"))
     {
@@ -288,6 +318,19 @@ namespace seahorn
       m_db.addQuery (mk<TRUE> (m_efac));
     }
 
+    if (!DumpDb.empty () && IntervalPruneOpt)
+      errs () << "WARNING: --horn-dump-db is ignored with --horn-interval-prune\n";
+    else if (!DumpDb.empty ())
+    {
+      std::error_code ec;
+      raw_fd_ostream out (DumpDb, ec, sys::fs::F_None);
+      std::string err;
+      if (ec)
+        errs () << "WARNING: cannot write " << DumpDb << ": " << ec.message () << "\n";
+      else if (!writeHornClauseDB (m_db, m_bbPreds, M, fingerprint, out, err))
+        errs () << "WARNING: cannot write " << DumpDb << ": " << err << "\n";
+    }
+
     /**
        TODO:
          - name basic blocks so that there are no name clashes between functions (DONE)
@@ -339,6 +382,66 @@ namespace seahorn
     return Changed;
   }
 
+  bool HornifyModule::resumeDb (Module &M, const std::string &fingerprint)
+  {
+    // -- the function infos of summaries are not in the file. Without
+    // -- any function other than main there are no summaries
+    if (InterProc)
+      for (auto &F : M)
+      {
+        if (F.isDeclaration () || F.empty () || F.getName ().equals ("main"))
+          continue;
+        errs () << "WARNING: --horn-resume-db is ignored with --horn-inter-proc "
+                << "and function " << F.getName () << "\n";
+        return false;
+      }
+
+    // -- the dead blocks are not in the file
+    if (IntervalPruneOpt)
+    {
+      errs () << "WARNING: --horn-resume-db is ignored with --horn-interval-prune\n";
+      return false;
+    }
+
+    auto buf = MemoryBuffer::getFile (ResumeDb);
+    if (!buf)
+    {
+      errs () << "WARNING: cannot read " << ResumeDb << ": "
+              << buf.getError ().message () << "\n";
+      return false;
+    }
+    if (!matchesHornClauseDB (**buf, fingerprint))
+    {
+      errs () << "WARNING: " << ResumeDb << " was written for another program\n";
+      return false;
+    }
+
+    // -- what hornification computes besides the clauses
+    if (Function* errorFn = M.getFunction ("verifier.error"))
+    {
+      FunctionInfo &fi = m_sem->getFunctionInfo (*errorFn);
+      ExprVector sorts (4, sort::boolTy (m_efac));
+      fi.sumPred = bind::fdecl (mkTerm<const Function*> (errorFn, m_efac), sorts);
+    }
+    for (auto &F : M)
+    {
+      if (F.isDeclaration () || F.empty ()) continue;
+      getAnalysis<CutPointGraph> (F);
+      auto r = m_ls.insert (std::make_pair (&F, LiveSymbols (F, m_efac, *m_sem)));
+      r.first->second.run ();
+    }
+
+    std::string err;
+    if (!readHornClauseDB (**buf, M, fingerprint, m_db, m_bbPreds, err))
+    {
+      errs () << "WARNING: cannot load " << ResumeDb << ": " << err << "\n";
+      m_ls.clear ();
+      return false;
+    }
+    LOG("horn-step", errs () << "HornifyModule: resumed from " << ResumeDb << "\n");
+    return true;
+  }
+
   bool HornifyModule::runOnFunction (Function &F)
   {
     // -- skip functions without a body
@@ -356,7 +459,7 @@ namespace seahorn
     // (and unifying return nodes) before computing liveness so that
     // we make sure the CFG does not change between LiveSymbols and
     // hornify function.
-    /*CutPointGraph &cpg =*/ getAnalysis<CutPointGraph> (F);
+    CutPointGraph &cpg = getAnalysis<CutPointGraph> (F);
 
     boost::scoped_ptr<HornifyFunction> hf (new SmallHornifyFunction
                                            (*this, InterProc));
@@ -377,9 +480,55 @@ namespace seahorn
     /// -- run LiveSymbols
     r.first->second.run ();
 
+    // -- the analysis trusts branch conditions and assumptions, which
+    // -- the encoding ignores once the error flag is set
+    boost::scoped_ptr<IntervalPrune> ip;
+    if (IntervalPruneOpt &&
+        (Step == hm_detail::SMALL_STEP || Step == hm_detail::LARGE_STEP) &&
+        isOpX<FALSE> (m_sem->errorFlag (F.getEntryBlock ())))
+    {
+      Stats::resume ("IntervalPrune");
+      ip.reset (new IntervalPrune (F, cpg, *m_sem));
+      if (ip->run ())
+      {
+        for (auto &bb : F)
+          if (ip->isDead (bb)) m_dead.insert (&bb);
+      }
+      else ip.reset ();
+      Stats::stop ("IntervalPrune");
+    }
+
     /// -- hornify function
     hf->runOnFunction (F);
 
+    if (ip)
+    {
+      unsigned relations = 0;
+      unsigned constraints = 0;
+      for (auto &bb : F)
+      {
+        if (isDeadBb (bb))
+        {
+          if (Step == hm_detail::SMALL_STEP || cpg.isCutPoint (bb)) ++relations;
+          continue;
+        }
+        if (!hasBbPredicate (bb)) continue;
+
+        Expr inv = ip->invariant (bb, live (bb), m_efac);
+        if (isOpX<TRUE> (inv)) continue;
+        m_db.addConstraint (bind::fapp (bbPredicate (bb), live (bb)), inv);
+        ++constraints;
+      }
+
+      LOG ("interval-prune", errs () << "interval-prune: " << F.getName ()
+           << ": removed " << relations << " relations, added "
+           << constraints << " constraints\n";);
+      Stats::uset ("IntervalPruneRelations",
+                   Stats::get ("IntervalPruneRelations") + relations);
+      Stats::uset ("IntervalPruneConstraints",
+                   Stats::get ("IntervalPruneConstraints") + constraints);
+    }
+
     return false;
   }
 
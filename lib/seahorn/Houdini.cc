@@ -3,6 +3,7 @@
 #include "seahorn/HornClauseDBTransf.hh"
 #include "seahorn/HornClauseDB.hh"
 #include "seahorn/GuessCandidates.hh"
+#include "seahorn/HornSampler.hh"
 
 #include "llvm/IR/Function.h"
 #include "llvm/Support/CommandLine.h"
@@ -14,11 +15,30 @@
 #include <boost/logic/tribool.hpp>
 #include "seahorn/HornClauseDBWto.hh"
 #include <algorithm>
+#include <memory>
 
 #include "ufo/Stats.hh"
 
 using namespace llvm;
 
+static llvm::cl::opt<bool>
+HoudiniTemplates ("horn-houdini-templates",
+                  llvm::cl::desc ("Guess Houdini candidates from interval, "
+                                  "equality and octagon templates"),
+                  llvm::cl::init (false));
+
+static llvm::cl::opt<unsigned>
+HoudiniSamples ("horn-houdini-samples",
+                llvm::cl::desc ("Maximum number of reachable states of a relation "
+                                "used to filter template candidates"),
+                llvm::cl::init (16), llvm::cl::Hidden);
+
+static llvm::cl::opt<bool>
+HoudiniSimulate ("horn-houdini-simulate",
+                 llvm::cl::desc ("Sample reachable states by concrete simulation "
+                                 "instead of SMT queries"),
+                 llvm::cl::init (true), llvm::cl::Hidden);
+
 namespace seahorn
 {
   #define SAT_OR_INDETERMIN true
@@ -97,6 +117,20 @@ namespace seahorn
 
   void Houdini::guessCandidates(HornClauseDB &db)
   {
+	  std::map<Expr, ExprVector> templateCands;
+	  std::unique_ptr<HornSampler> sampler;
+	  if (HoudiniTemplates)
+	  {
+		  TemplateCands tc(db);
+		  sampleStates(tc);
+		  tc.candidates(templateCands);
+	  }
+	  else if (HoudiniSimulate)
+	  {
+		  sampler.reset(new HornSampler(db));
+		  sampler->run();
+	  }
+
 	  for(Expr rel : db.getRelations())
 	  {
 		  ExprMap bvarToArgMap;
@@ -111,7 +145,19 @@ namespace seahorn
 		  }
 		  Expr fapp = bind::fapp(rel, arg_list);
 
-		  ExprVector lemmas = relToCand(rel);
+		  ExprVector lemmas = HoudiniTemplates ? templateCands[rel] : relToCand(rel);
+		  if (sampler)
+		  {
+			  // -- a lemma that a reachable state violates is dropped
+			  // -- by Houdini anyway
+			  size_t sz = lemmas.size();
+			  lemmas.erase(std::remove_if(lemmas.begin(), lemmas.end(),
+			                              [&](Expr l) {return sampler->refutes(rel, l);}),
+			               lemmas.end());
+			  for (size_t i = lemmas.size(); i < sz; ++i)
+				  Stats::count("HoudiniCandsRefuted");
+			  if (lemmas.empty()) lemmas.push_back(mk<TRUE>(rel->efac()));
+		  }
 		  Expr cand;
 		  if(lemmas.size() == 1)
 		  {
@@ -534,9 +580,53 @@ namespace seahorn
   	  }
   }
 
+  namespace
+  {
+    /// records a new state. Returns false if it is known or there are
+    /// enough states of its relation
+    bool addPositiveState(std::map<Expr, ExprVector> &relationToPositiveStateMap, Expr state)
+    {
+      ExprVector &states = relationToPositiveStateMap[bind::fname(state)];
+      if (states.size() >= HoudiniSamples) return false;
+      if (std::find(states.begin(), states.end(), state) != states.end()) return false;
+      states.push_back(state);
+      Stats::count("HoudiniPositiveStates");
+      return true;
+    }
+  }
+
+  /*
+   * Reachable states for template candidates: from concrete
+   * simulation, or from SMT queries with --horn-houdini-simulate=false
+   */
+  void Houdini::sampleStates(TemplateCands &tc)
+  {
+	  auto &db = m_hm.getHornClauseDB();
+	  if (HoudiniSimulate)
+	  {
+		  HornSampler sampler(db);
+		  sampler.run();
+		  for (Expr rel : db.getRelations())
+			  if (bind::isFdecl(rel)) tc.addSamples(rel, sampler.samples(rel));
+		  return;
+	  }
+
+	  std::map<Expr, ExprVector> states;
+	  generatePositiveWitness(states);
+	  for (auto &kv : states)
+		  for (Expr s : kv.second) tc.addState(s);
+  }
+
+  /*
+   * Reachable states of the relations, breadth first from the facts,
+   * at most HoudiniSamples per relation. Only rules with at most one
+   * relation in the body are followed.
+   */
   void Houdini::generatePositiveWitness(std::map<Expr, ExprVector> &relationToPositiveStateMap)
   {
 	  auto &db = m_hm.getHornClauseDB();
+	  ZSolver<EZ3> solver(m_hm.getZContext());
+	  std::list<Expr> frontier;
 	  for(HornClauseDB::RuleVector::iterator it = db.getRules().begin(); it != db.getRules().end(); ++it)
 	  {
 		  HornRule r = *it;
@@ -544,9 +634,19 @@ namespace seahorn
 		  get_all_pred_apps(r.body(), db, std::back_inserter(body_pred_list));
 		  if(body_pred_list.size() == 0) // this rule doesn't have predicates in its body.
 		  {
-			  getRuleHeadState(relationToPositiveStateMap, r, mk<TRUE>(r.head()->efac()));
+			  Expr state = getRuleHeadState(r, mk<TRUE>(r.head()->efac()), solver);
+			  if (state && addPositiveState(relationToPositiveStateMap, state))
+				  frontier.push_back(state);
 		  }
 	  }
+
+	  while (!frontier.empty())
+	  {
+		  Expr state = frontier.front();
+		  frontier.pop_front();
+		  getReachableStates(relationToPositiveStateMap, state, frontier, solver);
+	  }
+
 	  LOG("houdini", errs() << "THE WHOLE STATE MAP:\n";);
 	  for(std::map<Expr, ExprVector>::iterator itr = relationToPositiveStateMap.begin(); itr != relationToPositiveStateMap.end(); ++itr)
 	  {
@@ -560,96 +660,66 @@ namespace seahorn
 	  }
   }
 
-  void Houdini::getReachableStates(std::map<Expr, ExprVector> &relationToPositiveStateMap, Expr from_pred, Expr from_pred_state)
+  void Houdini::getReachableStates(std::map<Expr, ExprVector> &relationToPositiveStateMap, Expr from_state, std::list<Expr> &frontier, ZSolver<EZ3> &solver)
   {
 	  auto &db = m_hm.getHornClauseDB();
-	  LOG("houdini", errs() << "COME IN\n";);
+	  Expr from_pred = bind::fname(from_state);
 	  for(HornClauseDB::RuleVector::iterator itr = db.getRules().begin(); itr != db.getRules().end(); ++itr)
 	  {
 		  HornRule r = *itr;
 		  ExprVector body_preds;
 		  get_all_pred_apps(r.body(), db, std::back_inserter(body_preds));
-		  LOG("houdini", errs() << "BODY PRED SIZE: " << body_preds.size() << "\n";);
-		  if(body_preds.size() > 0)
-		  {
-			  LOG("houdini", errs() << "BODY PRED 0: " << *(body_preds[0]) << "\n";);
-			  LOG("houdini", errs() << "FROM PRED: " << *from_pred << "\n";);
-		  }
-		  if(body_preds.size() == 1 && bind::fname(body_preds[0]) == bind::fname(from_pred))
+		  if(body_preds.size() != 1 || bind::fname(body_preds[0]) != from_pred) continue;
+
+		  // -- arguments without a value (e.g., arrays) are left free, so
+		  // -- a state might not be reachable. It only costs candidates
+		  ExprVector equations;
+		  for(unsigned i = 0, sz = bind::domainSz(from_pred); i < sz; i++)
 		  {
-			  getRuleHeadState(relationToPositiveStateMap, r, from_pred_state);
+			  Expr value = from_state->arg(i + 1);
+			  if (isOpX<MPZ>(value) || isOpX<TRUE>(value) || isOpX<FALSE>(value))
+				  equations.push_back(mk<EQ>(body_preds[0]->arg(i + 1), value));
 		  }
+		  Expr pre = equations.empty() ? mk<TRUE>(from_state->efac()) :
+			  equations.size() == 1 ? equations[0] :
+			  mknary<AND>(equations.begin(), equations.end());
+
+		  Expr state = getRuleHeadState(r, pre, solver);
+		  if (state && addPositiveState(relationToPositiveStateMap, state))
+			  frontier.push_back(state);
 	  }
   }
 
-  void Houdini::getRuleHeadState(std::map<Expr, ExprVector> &relationToPositiveStateMap, HornRule r, Expr from_pred_state)
+  /*
+   * A state of the head of r reachable from a state of its body, or
+   * null if there is none
+   */
+  Expr Houdini::getRuleHeadState(HornRule r, Expr from_pred_state, ZSolver<EZ3> &solver)
   {
 		LOG("houdini", errs() << "RULE HEAD: " << *(r.head()) << "\n";);
 		LOG("houdini", errs() << "RULE BODY: " << *(r.body()) << "\n";);
 		auto &db = m_hm.getHornClauseDB();
-		ZSolver<EZ3> solver(m_hm.getZContext());
+		Expr head = r.head();
+		//reach a predicate with empty signature. Error state.
+		if(bind::domainSz(bind::fname(head)) == 0) return Expr();
+
+		solver.reset();
 		solver.assertExpr(from_pred_state);
 		solver.assertExpr(extractTransitionRelation(r, db));
-		solver.toSmtLib(outs());
 		boost::tribool isSat = solver.solve();
-		if(isSat)
-		{
-		  LOG("houdini", errs() << "SAT\n";);
-		  if(bind::domainSz(bind::fname(r.head())) == 0) //reach a predicate with empty signature. Error state.
-		  {
-			  LOG("houdini", errs() << "BAD STATE REACHED!\n";);
-			  return;
-		  }
-		  ZModel<EZ3> model = solver.getModel();
-		  ExprVector equations;
-		  for(int i=0; i<=bind::domainSz(r.head()); i++)
-		  {
-			  Expr var = bind::domainTy(r.head(), i);
-			  Expr value = model.eval(var);
-			  LOG("houdini", errs() << "VAR: " << *var << "\n";);
-			  LOG("houdini", errs() << "VALUE: " << *value << "\n";);
-			  equations.push_back(mk<EQ>(var, value));
-		  }
-		  Expr state_assignment;
-		  if(equations.size() > 1)
-		  {
-			  state_assignment = mknary<AND>(equations.begin(), equations.end());
-		  }
-		  else
-		  {
-			  state_assignment = equations[0];
-		  }
-		  LOG("houdini", errs() << "STATE ASSIGNMENT: " << *state_assignment << "\n";);
-
-		  if(relationToPositiveStateMap.find(bind::fname(r.head())) == relationToPositiveStateMap.end())
-		  {
-			  ExprVector states;
-			  states.push_back(state_assignment);
-			  relationToPositiveStateMap.insert(std::make_pair(bind::fname(r.head()), states));
-		  }
-		  else
-		  {
-			  ExprVector &states = relationToPositiveStateMap.find(bind::fname(r.head()))->second;
-			  states.push_back(state_assignment);
-		  }
-		  /*LOG("houdini", errs() << "STATE MAP:\n";);
-		  for(std::map<Expr, ExprVector>::iterator itr = relationToPositiveStateMap.begin(); itr != relationToPositiveStateMap.end(); ++itr)
-		  {
-			  LOG("houdini", errs() << "KEY: " << *(itr->first) << "\n";);
-			  LOG("houdini", errs() << "VALUE: [";);
-			  for(ExprVector::iterator itr2 = itr->second.begin(); itr2 != itr->second.end(); ++itr2)
-			  {
-				  LOG("houdini", errs() << *(*itr2) << ", ";);
-			  }
-			  LOG("houdini", errs() << "]\n";);
-		  }*/
-		  getReachableStates(relationToPositiveStateMap, r.head(), state_assignment);
-		}
-		else
+		if(!isSat || boost::indeterminate(isSat))
 		{
 		  LOG("houdini", errs() << "UNSAT\n";);
-		  return;
+		  return Expr();
 		}
+
+		ZModel<EZ3> model = solver.getModel();
+		ExprVector values;
+		for(unsigned i = 0, sz = bind::domainSz(bind::fname(head)); i < sz; i++)
+			values.push_back(model.eval(head->arg(i + 1), true));
+		Expr state = bind::fapp(bind::fname(head), values);
+		LOG("houdini", errs() << "STATE: " << *state << "\n";);
+		return state;
   }
 
 }
@@ -0,0 +1,371 @@
+#include "seahorn/IncChecker.hh"
+#include "seahorn/HornifyModule.hh"
+#include "seahorn/HornClauseDB.hh"
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/DebugLoc.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include "ufo/Smt/EZ3.hh"
+#include "ufo/Stats.hh"
+#include "avy/AvyDebug.h"
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <thread>
+
+static llvm::cl::opt<unsigned>
+IncJobs ("horn-inc-jobs",
+         llvm::cl::desc ("Number of functions checked in parallel (0 = number of cores)"),
+         llvm::cl::init (0));
+
+static llvm::cl::opt<unsigned>
+IncTimeout ("horn-inc-timeout",
+            llvm::cl::desc ("Timeout per function in seconds (0 = no timeout)"),
+            llvm::cl::init (20));
+
+static llvm::cl::opt<unsigned>
+IncMinBlocks ("horn-inc-min-blocks",
+              llvm::cl::desc ("Only check functions with at least this many blocks"),
+              llvm::cl::init (0));
+
+namespace seahorn
+{
+  char IncChecker::ID = 0;
+
+  namespace
+  {
+    typedef std::chrono::steady_clock clock_type;
+
+    double secondsSince (clock_type::time_point start)
+    {return std::chrono::duration<double> (clock_type::now () - start).count ();}
+
+    /// Feasibility check of a single function.
+    ///
+    /// The job owns its expression factory and Z3 context. Everything
+    /// it needs from the HornClauseDB is copied in the constructor
+    /// (on the main thread) so that run() can execute on a worker
+    /// thread.
+    class IncJob
+    {
+    public:
+      enum Result {FEASIBLE, INFEASIBLE, TIMEOUT, UNKNOWN};
+
+    private:
+      const Function &m_fn;
+      ExprFactory m_efac;
+      EZ3 m_zctx;
+
+      ExprVector m_rels;
+      std::vector<std::pair<ExprVector, Expr> > m_rules;
+      ExprVector m_coverPreds;
+      ExprVector m_covers;
+      /// -- exit(flags, live) with entry and exit flags set to true
+      Expr m_query;
+      /// -- one crumb flag per basic block
+      unsigned m_nflags;
+      /// -- source lines of each basic block, indexed by crumb flag
+      std::vector<std::set<unsigned> > m_lines;
+
+      Result m_result;
+      std::set<unsigned> m_feasible;
+      std::set<unsigned> m_infeasible;
+      unsigned m_rounds;
+      double m_queryTime;
+
+      void check ();
+
+    public:
+      IncJob (const Function &fn, HornClauseDB &db, Expr query);
+
+      void run ();
+      void print (raw_ostream &out) const;
+      Result result () const {return m_result;}
+    };
+
+    IncJob::IncJob (const Function &fn, HornClauseDB &db, Expr query) :
+      m_fn (fn), m_zctx (m_efac), m_nflags (fn.size ()),
+      m_result (UNKNOWN), m_rounds (0), m_queryTime (0.0)
+    {
+      DagVisitCache cache;
+
+      // -- backward cone of the query. With --horn-inter-proc this
+      // -- includes the summaries of all (transitive) callees
+      ExprSet seen;
+      ExprVector worklist;
+      worklist.push_back (bind::fname (query));
+      seen.insert (bind::fname (query));
+      while (!worklist.empty ())
+      {
+        Expr rel = worklist.back ();
+        worklist.pop_back ();
+        m_rels.push_back (copyTo (rel, m_efac, cache));
+
+        for (const HornRule *r : db.def (rel))
+        {
+          ExprVector vars;
+          for (const Expr &v : r->vars ()) vars.push_back (copyTo (v, m_efac, cache));
+          m_rules.push_back (std::make_pair (vars, copyTo (r->get (), m_efac, cache)));
+
+          ExprVector apps;
+          get_all_pred_apps (r->body (), db, std::back_inserter (apps));
+          for (Expr app : apps)
+            if (seen.insert (bind::fname (app)).second)
+              worklist.push_back (bind::fname (app));
+        }
+
+        if (db.hasConstraints (rel))
+        {
+          ExprVector args;
+          for (unsigned i = 0, sz = bind::domainSz (rel); i < sz; ++i)
+          {
+            Expr argName = mkTerm<std::string>
+              ("arg_" + boost::lexical_cast<std::string> (i), db.getExprFactory ());
+            args.push_back (bind::mkConst (argName, bind::domainTy (rel, i)));
+          }
+          Expr pred = bind::fapp (rel, args);
+          m_coverPreds.push_back (copyTo (pred, m_efac, cache));
+          m_covers.push_back (copyTo (db.getConstraints (pred), m_efac, cache));
+        }
+      }
+
+      m_query = copyTo (query, m_efac, cache);
+
+      for (const BasicBlock &bb : fn)
+      {
+        m_lines.push_back (std::set<unsigned> ());
+        for (const Instruction &inst : bb)
+        {
+          const DebugLoc &dloc = inst.getDebugLoc ();
+          if (dloc.get () && dloc.getLine () > 0)
+            m_lines.back ().insert (dloc.getLine ());
+        }
+      }
+    }
+
+    void IncJob::run ()
+    {
+      try
+      { check (); }
+      catch (z3::exception &e)
+      {
+        LOG ("inc", errs () << "IncChecker: " << m_fn.getName ()
+             << ": " << e.msg () << "\n";);
+        m_result = UNKNOWN;
+      }
+    }
+
+    void IncJob::check ()
+    {
+      clock_type::time_point start = clock_type::now ();
+
+      ZFixedPoint<EZ3> fp (m_zctx);
+      ZParams<EZ3> params (m_zctx);
+      params.set (":engine", "spacer");
+      params.set (":xform.slice", false);
+      params.set (":xform.inline-linear", false);
+      params.set (":xform.inline-eager", false);
+      params.set (":use_heavy_mev", true);
+      params.set (":pdr.flexible_trace", true);
+      // -- keep obligations and lemmas from one round to the next
+      params.set (":reset_obligation_queue", false);
+      fp.set (params);
+
+      for (Expr r : m_rels) fp.registerRelation (r);
+      for (auto &r : m_rules) fp.addRule (r.first, r.second);
+      for (unsigned i = 0, sz = m_coverPreds.size (); i < sz; ++i)
+        fp.addCover (m_coverPreds [i], m_covers [i]);
+
+      Expr exitRel = bind::fname (m_query);
+      // -- the query fixes the flags of the entry and exit blocks
+      std::set<unsigned> ee;
+      for (unsigned i = 0; i < m_nflags; ++i)
+        if (isOpX<TRUE> (m_query->arg (i + 1))) ee.insert (i);
+
+      Expr q = m_query;
+      double queryTime = 0.0;
+      for (m_rounds = 1; ; ++m_rounds)
+      {
+        // -- the timeout bounds all the rounds of the function
+        if (IncTimeout > 0)
+        {
+          double left = IncTimeout - secondsSince (start);
+          if (left <= 0)
+          {
+            m_result = TIMEOUT;
+            break;
+          }
+          params.set (":timeout", std::max (1U, (unsigned) (left * 1000)));
+          fp.set (params);
+        }
+
+        clock_type::time_point qstart = clock_type::now ();
+        // -- all rounds share the same fixedpoint object. Lemmas
+        // -- learned while answering earlier queries are reused.
+        fp.resetQueries ();
+        boost::tribool res = fp.query (q);
+        queryTime += secondsSince (qstart);
+
+        if (boost::indeterminate (res))
+        {
+          m_result = IncTimeout > 0 && secondsSince (start) >= IncTimeout ?
+            TIMEOUT : UNKNOWN;
+          break;
+        }
+
+        if (!res)
+        {
+          if (m_rounds == 1)
+          {
+            // -- the exit is not reachable at all
+            m_feasible.insert (0);
+            for (unsigned i : ee) if (i != 0) m_infeasible.insert (i);
+          }
+          else
+          {
+            // -- every path has been enumerated. Flags that were
+            // -- never set are blocks that are not on any path.
+            for (unsigned i = 0; i < m_nflags; ++i)
+              if (m_feasible.count (i) <= 0) m_infeasible.insert (i);
+          }
+          m_result = m_infeasible.empty () ? FEASIBLE : INFEASIBLE;
+          break;
+        }
+
+        m_feasible.insert (ee.begin (), ee.end ());
+
+        // -- find the instance of the exit predicate in the derivation
+        Expr ground = fp.getGroundSatAnswer ();
+        ExprVector conj;
+        if (isOpX<AND> (ground)) conj.assign (ground->args_begin (), ground->args_end ());
+        else conj.push_back (ground);
+
+        Expr exitApp;
+        for (Expr c : conj)
+          if (bind::isFapp (c) && bind::fname (c) == exitRel)
+          { exitApp = c; break; }
+
+        if (!exitApp)
+        {
+          m_result = UNKNOWN;
+          break;
+        }
+
+        ExprVector cube;
+        for (unsigned i = 0; i < m_nflags; ++i)
+        {
+          if (ee.count (i) > 0) continue;
+          Expr val = exitApp->arg (i + 1);
+          Expr flag = m_query->arg (i + 1);
+          if (isOpX<TRUE> (val))
+          {
+            m_feasible.insert (i);
+            cube.push_back (flag);
+          }
+          else if (isOpX<FALSE> (val))
+            cube.push_back (mk<NEG> (flag));
+        }
+
+        if (m_feasible.size () == m_nflags)
+        {
+          m_result = FEASIBLE;
+          break;
+        }
+
+        // -- block this combination of flags and look for another path
+        q = boolop::land (q, boolop::lneg (mknary<AND> (mk<TRUE> (m_efac), cube)));
+      }
+
+      m_queryTime = queryTime;
+    }
+
+    void IncJob::print (raw_ostream &out) const
+    {
+      std::set<unsigned> lines;
+      for (unsigned i : m_infeasible)
+        lines.insert (m_lines [i].begin (), m_lines [i].end ());
+
+      std::string slines;
+      for (unsigned l : lines)
+      {
+        if (!slines.empty ()) slines += "-";
+        slines += boost::lexical_cast<std::string> (l);
+      }
+      if (slines.empty ()) slines = "--";
+
+      const char *res = "UNKNOWN";
+      switch (m_result)
+      {
+      case FEASIBLE: res = "FEASIBLE"; break;
+      case INFEASIBLE: res = "INFEASIBLE"; break;
+      case TIMEOUT: res = "TIMEOUT"; break;
+      case UNKNOWN: break;
+      }
+
+      out << "\n  -----------------\n"
+          << "  FUNCTION NAME: " << m_fn.getName () << "\n"
+          << "      N. BLOCKS: " << m_nflags << "\n"
+          << "         RESULT: " << res << "\n"
+          << "   LINE NUMBERS: " << slines << "\n"
+          << "  ANALYSIS TIME: " << format ("%.2f", m_queryTime) << "\n"
+          << " ------------------\n";
+    }
+  }
+
+  bool IncChecker::runOnModule (Module &M)
+  {
+    ScopedStats _st_ ("IncChecker");
+
+    HornifyModule &hm = getAnalysis<HornifyModule> ();
+    HornClauseDB &db = hm.getHornClauseDB ();
+    db.buildIndexes ();
+
+    // -- one query per function (see IncSmallHornifyFunction)
+    std::vector<std::unique_ptr<IncJob> > jobs;
+    for (Expr q : db.getQueries ())
+    {
+      if (!bind::isFapp (q) || !hm.isBbPredicate (q)) continue;
+      const Function &F = *hm.predicateBb (q).getParent ();
+      if (F.size () < IncMinBlocks) continue;
+      jobs.push_back (std::unique_ptr<IncJob> (new IncJob (F, db, q)));
+    }
+
+    unsigned threads = IncJobs > 0 ?
+      (unsigned) IncJobs : std::thread::hardware_concurrency ();
+    {
+      ScopedStats _st_ ("IncChecker.solve");
+      llvm::ThreadPool pool (std::max (threads, 1U));
+      for (auto &job : jobs)
+      {
+        IncJob *j = job.get ();
+        pool.async ([j] { j->run (); });
+      }
+      pool.wait ();
+    }
+
+    outs () << "\n\t =========  SEAHORN INCONSISTENCY CHECKS   ========\n";
+    unsigned infeasible = 0;
+    for (auto &job : jobs)
+    {
+      job->print (outs ());
+      if (job->result () == IncJob::INFEASIBLE) ++infeasible;
+    }
+    outs ().flush ();
+
+    Stats::uset ("IncFunctions", jobs.size ());
+    Stats::uset ("IncInfeasibleFunctions", infeasible);
+    return false;
+  }
+
+  void IncChecker::getAnalysisUsage (AnalysisUsage &AU) const
+  {
+    AU.addRequired<HornifyModule> ();
+    AU.setPreservesAll ();
+  }
+}
@@ -0,0 +1,461 @@
+#include "seahorn/IntervalPrune.hh"
+
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "ufo/ExprLlvm.hpp"
+#include "avy/AvyDebug.h"
+
+namespace seahorn
+{
+  using namespace llvm;
+  typedef IntervalPrune::Interval Interval;
+
+  namespace
+  {
+    /// passes over the function before giving up
+    const unsigned MaxPasses = 100;
+    /// updates of a cut-point before widening
+    const unsigned WidenDelay = 2;
+
+    Interval atLeast (const mpz_class &v)
+    {
+      Interval r;
+      r.hasLo = true;
+      r.lo = v;
+      return r;
+    }
+
+    Interval atMost (const mpz_class &v)
+    {
+      Interval r;
+      r.hasHi = true;
+      r.hi = v;
+      return r;
+    }
+
+    Interval join (const Interval &a, const Interval &b)
+    {
+      Interval r;
+      r.hasLo = a.hasLo && b.hasLo;
+      if (r.hasLo) r.lo = a.lo < b.lo ? a.lo : b.lo;
+      r.hasHi = a.hasHi && b.hasHi;
+      if (r.hasHi) r.hi = a.hi > b.hi ? a.hi : b.hi;
+      return r;
+    }
+
+    /// false if the intersection of a and b is empty
+    bool meet (const Interval &a, const Interval &b, Interval &r)
+    {
+      r = a;
+      if (b.hasLo && (!r.hasLo || b.lo > r.lo)) { r.hasLo = true; r.lo = b.lo; }
+      if (b.hasHi && (!r.hasHi || b.hi < r.hi)) { r.hasHi = true; r.hi = b.hi; }
+      return !(r.hasLo && r.hasHi && r.lo > r.hi);
+    }
+
+    /// drops the bounds of old that nu does not satisfy
+    Interval widen (const Interval &old, const Interval &nu)
+    {
+      Interval r;
+      r.hasLo = old.hasLo && nu.hasLo && nu.lo >= old.lo;
+      if (r.hasLo) r.lo = old.lo;
+      r.hasHi = old.hasHi && nu.hasHi && nu.hi <= old.hi;
+      if (r.hasHi) r.hi = old.hi;
+      return r;
+    }
+
+    Interval neg (const Interval &a)
+    {
+      Interval r;
+      r.hasLo = a.hasHi;
+      if (r.hasLo) r.lo = -a.hi;
+      r.hasHi = a.hasLo;
+      if (r.hasHi) r.hi = -a.lo;
+      return r;
+    }
+
+    Interval add (const Interval &a, const Interval &b)
+    {
+      Interval r;
+      r.hasLo = a.hasLo && b.hasLo;
+      if (r.hasLo) r.lo = a.lo + b.lo;
+      r.hasHi = a.hasHi && b.hasHi;
+      if (r.hasHi) r.hi = a.hi + b.hi;
+      return r;
+    }
+
+    Interval scale (const Interval &a, const mpz_class &c)
+    {
+      if (c == 0) return Interval::point (0);
+      if (c < 0) return scale (neg (a), -c);
+      Interval r = a;
+      if (r.hasLo) r.lo *= c;
+      if (r.hasHi) r.hi *= c;
+      return r;
+    }
+
+    /// refines a and b so that a < b (strict) or a <= b. false if
+    /// that is impossible
+    bool lessThan (Interval &a, Interval &b, bool strict)
+    {
+      if (b.hasHi && !meet (a, atMost (strict ? mpz_class (b.hi - 1) : b.hi), a))
+        return false;
+      if (a.hasLo && !meet (b, atLeast (strict ? mpz_class (a.lo + 1) : a.lo), b))
+        return false;
+      return true;
+    }
+  }
+
+  Interval Interval::point (const mpz_class &v)
+  {
+    Interval r;
+    r.hasLo = r.hasHi = true;
+    r.lo = r.hi = v;
+    return r;
+  }
+
+  bool Interval::operator== (const Interval &o) const
+  {
+    return hasLo == o.hasLo && hasHi == o.hasHi &&
+      (!hasLo || lo == o.lo) && (!hasHi || hi == o.hi);
+  }
+
+  bool IntervalPrune::State::operator== (const State &o) const
+  {
+    if (bot || o.bot) return bot == o.bot;
+    if (env.size () != o.env.size ()) return false;
+    for (auto &kv : env)
+    {
+      auto it = o.env.find (kv.first);
+      if (it == o.env.end () || it->second != kv.second) return false;
+    }
+    return true;
+  }
+
+  namespace
+  {
+    typedef IntervalPrune::Env Env;
+
+    /// pointwise join. A register missing on either side is dropped
+    void joinEnv (const Env &a, const Env &b, Env &out)
+    {
+      for (auto &kv : a)
+      {
+        auto it = b.find (kv.first);
+        if (it == b.end ()) continue;
+        Interval j = join (kv.second, it->second);
+        if (!j.isTop ()) out [kv.first] = j;
+      }
+    }
+  }
+
+  bool IntervalPrune::isInt (const Value &v) const
+  {
+    Type *ty = v.getType ();
+    return ty->isIntegerTy () && !ty->isIntegerTy (1) && m_sem.isTracked (v);
+  }
+
+  Interval IntervalPrune::eval (const Env &env, const Value &v) const
+  {
+    if (const ConstantInt *c = dyn_cast<const ConstantInt> (&v))
+      return c->getBitWidth () > 1 ? Interval::point (toMpz (c->getValue ())) : Interval ();
+    if (isa<Constant> (v) || !isInt (v)) return Interval ();
+
+    auto it = env.find (&v);
+    return it == env.end () ? Interval () : it->second;
+  }
+
+  void IntervalPrune::set (Env &env, const Value &v, const Interval &i) const
+  {
+    if (i.isTop ()) env.erase (&v);
+    else env [&v] = i;
+  }
+
+  bool IntervalPrune::refine (Env &env, const Value &cond, bool truth,
+                              unsigned depth) const
+  {
+    if (const ConstantInt *c = dyn_cast<const ConstantInt> (&cond))
+      return c->isOne () == truth;
+    if (depth > 8) return true;
+
+    if (const BinaryOperator *bo = dyn_cast<const BinaryOperator> (&cond))
+    {
+      const Value &op0 = *bo->getOperand (0);
+      const Value &op1 = *bo->getOperand (1);
+      if ((bo->getOpcode () == Instruction::And && truth) ||
+          (bo->getOpcode () == Instruction::Or && !truth))
+        return refine (env, op0, truth, depth + 1) &&
+          refine (env, op1, truth, depth + 1);
+
+      const ConstantInt *c = dyn_cast<const ConstantInt> (&op1);
+      if (bo->getOpcode () == Instruction::Xor && c && c->isOne ())
+        return refine (env, op0, !truth, depth + 1);
+      return true;
+    }
+
+    const ICmpInst *cmp = dyn_cast<const ICmpInst> (&cond);
+    if (!cmp) return true;
+
+    const Value &v0 = *cmp->getOperand (0);
+    const Value &v1 = *cmp->getOperand (1);
+    Type *ty = v0.getType ();
+    if (!ty->isIntegerTy () || ty->isIntegerTy (1)) return true;
+
+    Interval a = eval (env, v0);
+    Interval b = eval (env, v1);
+    switch (truth ? cmp->getPredicate () : cmp->getInversePredicate ())
+    {
+    case CmpInst::ICMP_EQ:
+      if (!meet (a, b, a)) return false;
+      b = a;
+      break;
+    case CmpInst::ICMP_NE:
+      return !(a.isPoint () && b.isPoint () && a.lo == b.lo);
+    case CmpInst::ICMP_SLT:
+      if (!lessThan (a, b, true)) return false;
+      break;
+    case CmpInst::ICMP_SLE:
+      if (!lessThan (a, b, false)) return false;
+      break;
+    case CmpInst::ICMP_SGT:
+      if (!lessThan (b, a, true)) return false;
+      break;
+    case CmpInst::ICMP_SGE:
+      if (!lessThan (b, a, false)) return false;
+      break;
+    default:
+      // -- unsigned comparisons are not refined
+      return true;
+    }
+
+    if (!isa<Constant> (v0) && isInt (v0)) set (env, v0, a);
+    if (!isa<Constant> (v1) && isInt (v1)) set (env, v1, b);
+    return true;
+  }
+
+  void IntervalPrune::exec (const Instruction &I, State &st) const
+  {
+    if (isa<PHINode> (I)) return;
+
+    if (const CallInst *ci = dyn_cast<const CallInst> (&I))
+    {
+      const Function *fn = ci->getCalledFunction ();
+      if (fn && fn->getName ().startswith ("verifier.assume") &&
+          ci->getNumArgOperands () > 0 &&
+          !refine (st.env, *ci->getArgOperand (0),
+                   !fn->getName ().equals ("verifier.assume.not")))
+      {
+        st.bot = true;
+        st.env.clear ();
+        return;
+      }
+      if (isInt (I)) set (st.env, I, Interval ());
+      return;
+    }
+
+    if (!isInt (I)) return;
+
+    Interval r;
+    if (const BinaryOperator *bo = dyn_cast<const BinaryOperator> (&I))
+    {
+      const Value &op0 = *bo->getOperand (0);
+      const Value &op1 = *bo->getOperand (1);
+      Interval a = eval (st.env, op0);
+      Interval b = eval (st.env, op1);
+      switch (bo->getOpcode ())
+      {
+      case Instruction::Add:
+        r = add (a, b);
+        break;
+      case Instruction::Sub:
+        r = add (a, neg (b));
+        break;
+      case Instruction::Mul:
+        // -- the encoding is linear, one side must be a constant
+        if (const ConstantInt *c = dyn_cast<const ConstantInt> (&op1))
+          r = scale (a, toMpz (c->getValue ()));
+        else if (const ConstantInt *c = dyn_cast<const ConstantInt> (&op0))
+          r = scale (b, toMpz (c->getValue ()));
+        break;
+      default:
+        break;
+      }
+    }
+    else if (isa<ZExtInst> (I) || isa<SExtInst> (I))
+    {
+      const Value &op = *I.getOperand (0);
+      if (op.getType ()->isIntegerTy (1))
+      {
+        r = Interval::point (0);
+        if (isa<SExtInst> (I)) r.lo = -1;
+        else r.hi = 1;
+      }
+      else
+        r = eval (st.env, op);
+    }
+    else if (isa<TruncInst> (I))
+      r = eval (st.env, *I.getOperand (0));
+    else if (const SelectInst *si = dyn_cast<const SelectInst> (&I))
+      r = join (eval (st.env, *si->getTrueValue ()),
+                eval (st.env, *si->getFalseValue ()));
+
+    set (st.env, I, r);
+  }
+
+  IntervalPrune::State IntervalPrune::edge (const BasicBlock &src,
+                                            const BasicBlock &dst) const
+  {
+    auto it = m_out.find (&src);
+    if (it == m_out.end () || it->second.bot) return State ();
+
+    State st = it->second;
+    const BranchInst *br = dyn_cast<const BranchInst> (src.getTerminator ());
+    if (br && br->isConditional () && br->getSuccessor (0) != br->getSuccessor (1))
+      if (!refine (st.env, *br->getCondition (), br->getSuccessor (0) == &dst))
+        return State ();
+
+    // -- PHI nodes of dst all read the state of src
+    std::vector<std::pair<const PHINode*, Interval> > phis;
+    for (const Instruction &I : dst)
+    {
+      const PHINode *phi = dyn_cast<const PHINode> (&I);
+      if (!phi) break;
+      if (!isInt (*phi)) continue;
+      phis.push_back (std::make_pair (phi, eval (st.env,
+                                                 *phi->getIncomingValueForBlock (&src))));
+    }
+    for (auto &p : phis) set (st.env, *p.first, p.second);
+    return st;
+  }
+
+  bool IntervalPrune::iterate (bool doWiden)
+  {
+    bool changed = false;
+    const BasicBlock *entry = &m_fn.getEntryBlock ();
+
+    for (const BasicBlock *bb : m_order)
+    {
+      State in;
+      if (bb == entry) in.bot = false;
+      else
+        for (const BasicBlock *pred : predecessors (bb))
+        {
+          State e = edge (*pred, *bb);
+          if (e.bot) continue;
+          if (in.bot) { in = e; continue; }
+          State j;
+          j.bot = false;
+          joinEnv (in.env, e.env, j.env);
+          in = j;
+        }
+
+      State &old = m_in [bb];
+      if (doWiden && !old.bot && !in.bot && m_cpg.isCutPoint (*bb) &&
+          ++m_visits [bb] > WidenDelay)
+      {
+        State w;
+        w.bot = false;
+        Env j;
+        joinEnv (old.env, in.env, j);
+        for (auto &kv : j)
+        {
+          Interval i = widen (old.env [kv.first], kv.second);
+          if (!i.isTop ()) w.env [kv.first] = i;
+        }
+        in = w;
+      }
+
+      if (old == in) continue;
+      changed = true;
+      old = in;
+
+      State out = in;
+      for (const Instruction &I : *bb)
+      {
+        if (out.bot) break;
+        exec (I, out);
+      }
+      m_out [bb] = out;
+    }
+    return changed;
+  }
+
+  bool IntervalPrune::run ()
+  {
+    const BasicBlock *exit = nullptr;
+    for (const BasicBlock &bb : m_fn)
+      if (isa<ReturnInst> (bb.getTerminator ()))
+      {
+        exit = &bb;
+        break;
+      }
+    if (!exit) return false;
+
+    ReversePostOrderTraversal<const Function*> rpo (&m_fn);
+    m_order.assign (rpo.begin (), rpo.end ());
+
+    unsigned passes = 0;
+    while (iterate (true))
+      if (++passes >= MaxPasses)
+      {
+        LOG ("interval-prune", errs () << "interval-prune: gave up on "
+             << m_fn.getName () << "\n";);
+        return false;
+      }
+    // -- narrowing: a few more passes from a post-fixpoint
+    iterate (false);
+    iterate (false);
+
+    // -- blocks that reach the exit by feasible edges
+    DenseSet<const BasicBlock*> reach;
+    std::vector<const BasicBlock*> work;
+    reach.insert (exit);
+    work.push_back (exit);
+    while (!work.empty ())
+    {
+      const BasicBlock *bb = work.back ();
+      work.pop_back ();
+      for (const BasicBlock *pred : predecessors (bb))
+        if (!reach.count (pred) && !edge (*pred, *bb).bot)
+        {
+          reach.insert (pred);
+          work.push_back (pred);
+        }
+    }
+
+    for (const BasicBlock &bb : m_fn)
+      if (!reach.count (&bb)) m_dead.insert (&bb);
+
+    LOG ("interval-prune", errs () << "interval-prune: " << m_fn.getName ()
+         << ": " << m_dead.size () << " dead blocks after " << passes
+         << " passes\n";);
+    return true;
+  }
+
+  Expr IntervalPrune::invariant (const BasicBlock &bb, const ExprVector &live,
+                                 ExprFactory &efac) const
+  {
+    Expr trueE = mk<TRUE> (efac);
+    auto it = m_in.find (&bb);
+    if (it == m_in.end () || it->second.bot) return trueE;
+    const Env &env = it->second.env;
+
+    ExprVector conj;
+    for (Expr v : live)
+    {
+      if (!bind::isFapp (v) || !isOpX<INT_TY> (bind::typeOf (v))) continue;
+      Expr u = bind::fname (bind::fname (v));
+      if (!isOpX<VALUE> (u)) continue;
+
+      auto jt = env.find (getTerm<const Value*> (u));
+      if (jt == env.end ()) continue;
+      const Interval &i = jt->second;
+      if (i.hasLo) conj.push_back (mk<GEQ> (v, mkTerm<mpz_class> (i.lo, efac)));
+      if (i.hasHi) conj.push_back (mk<LEQ> (v, mkTerm<mpz_class> (i.hi, efac)));
+    }
+    return mknary<AND> (trueE, conj);
+  }
+}
@@ -0,0 +1,262 @@
+#include "seahorn/KInduction.hh"
+#include "seahorn/UfoSymExec.hh"
+#include "seahorn/Support/ResourceGovernor.hh"
+
+#include "llvm/Support/raw_ostream.h"
+#include "avy/AvyDebug.h"
+
+#include <boost/range/iterator_range.hpp>
+
+#include <string>
+#include <thread>
+
+namespace seahorn
+{
+  CpgUnroller::CpgUnroller (SmallStepSymExec &sem, const CutPointGraph &cpg) :
+    m_sem (sem), m_efac (sem.efac ()), m_cpg (cpg), m_numCps (0),
+    m_store (m_efac)
+  {
+    for (const CutPoint &cp : m_cpg) { (void) cp; ++m_numCps; }
+
+    m_at.resize (1);
+    for (unsigned c = 0; c < m_numCps; ++c)
+      m_at [0].push_back (literal ("kind.at", 0, c));
+  }
+
+  Expr CpgUnroller::literal (const std::string &name, unsigned step, unsigned idx)
+  {
+    Expr n = mkTerm<std::string> (name + "." + std::to_string (idx), m_efac);
+    return bind::boolConst (variant::variant (step, n));
+  }
+
+  /// sequential encoding: s_j is true if one of lits [0..j] is
+  void CpgUnroller::atMostOne (const ExprVector &lits, const std::string &name,
+                               unsigned step, ExprVector &out)
+  {
+    Expr prev;
+    for (unsigned j = 0; j < lits.size (); ++j)
+    {
+      Expr s = literal (name, step, j);
+      out.push_back (boolop::limp (lits [j], s));
+      if (prev)
+      {
+        out.push_back (boolop::limp (prev, s));
+        out.push_back (boolop::limp (lits [j], boolop::lneg (prev)));
+      }
+      prev = s;
+    }
+  }
+
+  void CpgUnroller::initial (const CutPoint &cp, ExprVector &out)
+  {
+    for (const CutPoint &c : m_cpg)
+      out.push_back (&c == &cp ? at (0, c) : boolop::lneg (at (0, c)));
+  }
+
+  void CpgUnroller::anyState (ExprVector &out)
+  {
+    out.push_back (mknary<OR> (mk<FALSE> (m_efac), m_at [0]));
+    atMostOne (m_at [0], "kind.amo.at", 0, out);
+  }
+
+  void CpgUnroller::unroll (ExprVector &out)
+  {
+    unsigned i = depth ();
+    Expr trueE = mk<TRUE> (m_efac);
+    Expr falseE = mk<FALSE> (m_efac);
+    UfoLargeSymExec lsem (m_sem);
+
+    // -- every edge on its own copy of the store
+    std::vector<SymStore> stores;
+    ExprVector takes;
+    std::vector<ExprVector> in (m_numCps), outg (m_numCps);
+    for (const CutPoint &cp : m_cpg)
+      for (const CpEdge *edg : boost::make_iterator_range (cp.succ_begin (),
+                                                           cp.succ_end ()))
+      {
+        Expr take = literal ("kind.take", i, takes.size ());
+        stores.push_back (m_store);
+
+        ExprVector side;
+        lsem.execCpEdg (stores.back (), *edg, side);
+        out.push_back (boolop::limp (take, mknary<AND> (trueE, side)));
+        out.push_back (boolop::limp (take, at (i, cp)));
+
+        outg [cp.id ()].push_back (take);
+        in [edg->target ().id ()].push_back (take);
+        takes.push_back (take);
+      }
+
+    // -- join the stores. A store that does not define a key did
+    // -- not read it, so any value will do on that edge
+    SymStore next (m_store);
+    ExprSet keys;
+    for (const SymStore &s : stores)
+      for (auto &kv : s) keys.insert (kv.first);
+
+    unsigned joins = 0;
+    for (Expr key : keys)
+    {
+      Expr val;
+      bool same = true;
+      for (const SymStore &s : stores)
+      {
+        Expr v = s.at (key);
+        if (!v) continue;
+        if (!val) val = v;
+        else if (v != val) same = false;
+      }
+
+      if (same)
+      {
+        if (next.at (key) != val) next.write (key, val);
+        continue;
+      }
+
+      ++joins;
+      Expr v = next.havoc (key);
+      for (unsigned j = 0; j < stores.size (); ++j)
+        if (Expr sv = stores [j].at (key))
+          out.push_back (boolop::limp (takes [j], mk<EQ> (v, sv)));
+    }
+    m_store = next;
+
+    // -- control: from the current cut-point to the target of the
+    // -- one edge that is taken
+    m_at.push_back (ExprVector ());
+    for (unsigned c = 0; c < m_numCps; ++c)
+      m_at [i + 1].push_back (literal ("kind.at", i + 1, c));
+
+    for (unsigned c = 0; c < m_numCps; ++c)
+    {
+      out.push_back (boolop::limp (m_at [i][c], mknary<OR> (falseE, outg [c])));
+      out.push_back (mk<IFF> (m_at [i + 1][c], mknary<OR> (falseE, in [c])));
+    }
+    atMostOne (takes, "kind.amo.take", i, out);
+
+    LOG ("kind", errs () << "kind: step " << i << ": " << takes.size ()
+         << " edges, " << joins << " joins\n";);
+  }
+
+  KInduction::KInduction (SmallStepSymExec &baseSem, ufo::EZ3 &baseCtx,
+                          SmallStepSymExec &stepSem, ufo::EZ3 &stepCtx,
+                          const CutPoint &src, const CutPoint &dst) :
+    m_base (baseSem, src.parent ()), m_step (stepSem, src.parent ()),
+    m_stepCtx (stepCtx),
+    m_baseSolver (baseCtx), m_stepSolver (stepCtx),
+    m_src (src), m_dst (dst),
+    m_stop (false), m_baseDepth (0), m_stepDepth (0),
+    m_cex (false), m_cexDepth (0) {}
+
+  void KInduction::runBase (unsigned maxDepth)
+  {
+    ExprVector side;
+    {
+      std::lock_guard<std::mutex> lock (m_encode);
+      m_base.initial (m_src, side);
+      for (Expr e : side) m_baseSolver.assertExpr (e);
+    }
+
+    try
+    {
+      for (unsigned k = 0; k <= maxDepth; ++k)
+      {
+        unsigned proved = m_stepDepth;
+        if (proved > 0 && k >= proved) break;
+        if (m_stop || ResourceGovernor::get ().exceeded ()) break;
+
+        Expr bad[1];
+        {
+          std::lock_guard<std::mutex> lock (m_encode);
+          if (k > 0)
+          {
+            side.clear ();
+            m_base.unroll (side);
+            for (Expr e : side) m_baseSolver.assertExpr (e);
+          }
+          bad [0] = m_base.at (k, m_dst);
+        }
+
+        boost::tribool res = m_baseSolver.solveAssuming (bad);
+        LOG ("kind", errs () << "kind: base " << k << ": "
+             << (res ? "sat" : (!res ? "unsat" : "unknown")) << "\n";);
+        if (res)
+        {
+          m_cex = true;
+          m_cexDepth = k;
+          break;
+        }
+        if (boost::indeterminate (res)) break;
+
+        m_baseDepth = k + 1;
+        std::lock_guard<std::mutex> lock (m_encode);
+        m_baseSolver.assertExpr (boolop::lneg (bad [0]));
+      }
+    }
+    catch (z3::exception &e)
+    {
+      errs () << "WARNING: k-induction base case: " << e.msg () << "\n";
+    }
+
+    // -- the step case is of no use once the base case is done
+    m_stop = true;
+    m_stepCtx.interrupt ();
+  }
+
+  void KInduction::runStep (unsigned maxDepth)
+  {
+    ExprVector side;
+    {
+      std::lock_guard<std::mutex> lock (m_encode);
+      m_step.anyState (side);
+      for (Expr e : side) m_stepSolver.assertExpr (e);
+    }
+
+    try
+    {
+      for (unsigned k = 1; k <= maxDepth; ++k)
+      {
+        if (m_stop || ResourceGovernor::get ().exceeded ()) break;
+
+        Expr bad[1];
+        {
+          std::lock_guard<std::mutex> lock (m_encode);
+          side.clear ();
+          side.push_back (boolop::lneg (m_step.at (k - 1, m_dst)));
+          m_step.unroll (side);
+          for (Expr e : side) m_stepSolver.assertExpr (e);
+          bad [0] = m_step.at (k, m_dst);
+        }
+
+        // -- an interrupt that came while encoding, with no check
+        // -- running, is lost
+        if (m_stop) break;
+        boost::tribool res = m_stepSolver.solveAssuming (bad);
+        LOG ("kind", errs () << "kind: step " << k << ": "
+             << (res ? "sat" : (!res ? "unsat" : "unknown")) << "\n";);
+        if (!res)
+        {
+          m_stepDepth = k;
+          break;
+        }
+        if (boost::indeterminate (res)) break;
+      }
+    }
+    catch (z3::exception &e)
+    {
+      errs () << "WARNING: k-induction step case: " << e.msg () << "\n";
+    }
+  }
+
+  boost::tribool KInduction::run (unsigned maxDepth)
+  {
+    std::thread step (&KInduction::runStep, this, maxDepth);
+    runBase (maxDepth);
+    step.join ();
+
+    if (m_cex) return true;
+    unsigned k = m_stepDepth;
+    if (k > 0 && m_baseDepth >= k) return false;
+    return boost::indeterminate;
+  }
+}
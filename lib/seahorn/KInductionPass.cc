@@ -0,0 +1,122 @@
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+
+#include "ufo/Smt/EZ3.hh"
+#include "ufo/Stats.hh"
+#include "ufo/Passes/NameValues.hpp"
+#include "avy/AvyDebug.h"
+
+#include "seahorn/KInduction.hh"
+#include "seahorn/BvSymExec.hh"
+#include "seahorn/Support/ResourceGovernor.hh"
+
+#include "seahorn/Analysis/CanFail.hh"
+#include "seahorn/Analysis/TopologicalOrder.hh"
+
+static llvm::cl::opt<unsigned>
+KIndMaxDepth ("horn-kind-max-depth",
+              llvm::cl::desc ("Maximum number of steps unrolled by k-induction"),
+              llvm::cl::init (100));
+
+namespace
+{
+  using namespace llvm;
+  using namespace seahorn;
+  using namespace ufo;
+
+  class KInductionPass : public llvm::ModulePass
+  {
+  public:
+    static char ID;
+
+    KInductionPass () : llvm::ModulePass (ID) {}
+
+    virtual bool runOnModule (Module &M)
+    {
+      for (Function &F : M)
+        if (F.getName ().equals ("main")) return runOnFunction (F);
+      return false;
+    }
+
+    void getAnalysisUsage (AnalysisUsage &AU) const
+    {
+      AU.setPreservesAll ();
+
+      AU.addRequired<seahorn::CanFail> ();
+      AU.addRequired<ufo::NameValues>();
+      AU.addRequired<seahorn::TopologicalOrder>();
+      AU.addRequired<CutPointGraph> ();
+    }
+
+    virtual bool runOnFunction (Function &F)
+    {
+      const CutPointGraph &cpg = getAnalysis<CutPointGraph> (F);
+      const CutPoint &src = cpg.getCp (F.getEntryBlock ());
+      const CutPoint *dst = nullptr;
+
+      // -- find return instruction. Assume it is unique
+      for (auto &bb : F)
+        if (llvm::isa<llvm::ReturnInst> (bb.getTerminator ()) && cpg.isCutPoint (bb))
+        {
+          dst = &cpg.getCp (bb);
+          break;
+        }
+
+      if (dst == nullptr) return false;
+
+      // -- each case has its own factory and context
+      const DataLayout &dl = F.getParent ()->getDataLayout ();
+      ExprFactory baseEfac;
+      ExprFactory stepEfac;
+      BvSmallSymExec baseSem (baseEfac, *this, dl, MEM);
+      BvSmallSymExec stepSem (stepEfac, *this, dl, MEM);
+      EZ3 baseCtx (baseEfac);
+      EZ3 stepCtx (stepEfac);
+
+      KInduction kind (baseSem, baseCtx, stepSem, stepCtx, src, *dst);
+      LOG ("kind", errs () << "k-induction from: " << src.bb ().getName ()
+           << " to " << dst->bb ().getName () << "\n";);
+
+      Stats::resume ("KInduction");
+      boost::tribool res;
+      {
+        ScopedPhase _phase ("solve");
+        ResourceGovernor::get ().onInterrupt ([&baseCtx, &stepCtx]
+                                              {
+                                                baseCtx.interrupt ();
+                                                stepCtx.interrupt ();
+                                              });
+        res = kind.run (KIndMaxDepth);
+      }
+      Stats::stop ("KInduction");
+
+      if (res) outs () << "sat";
+      else if (!res) outs () << "unsat";
+      else outs () << "unknown";
+      outs () << "\n";
+
+      if (res) Stats::sset ("Result", "FALSE");
+      else if (!res) Stats::sset ("Result", "TRUE");
+      Stats::uset ("KInductionDepth", kind.depth ());
+      Stats::uset ("KInductionBaseDepth", kind.baseDepth ());
+
+      return false;
+    }
+
+    virtual const char *getPassName () const {return "KInductionPass";}
+  };
+
+  char KInductionPass::ID = 0;
+}
+namespace seahorn
+{
+  Pass *createKInductionPass ()
+  {return new KInductionPass ();}
+}
+
+static llvm::RegisterPass<KInductionPass>
+X("kind-pass", "Run BMC and k-induction on the cut-point graph");
@@ -5,6 +5,8 @@
 #include "seahorn/config.h"
 #include "ufo/Smt/EZ3.hh"
 
+#include <string>
+
 namespace seahorn
 {
   using namespace llvm;
@@ -12,21 +14,29 @@ namespace seahorn
   /// Loads Crab invariants into a Horn Solver
   class LoadCrab: public llvm::ModulePass
   {
+    /// -- Crab options on the command line
+    std::string m_crabOpts;
 
   public:
     static char ID;
     
-    LoadCrab () : ModulePass(ID) {}
+    LoadCrab (const std::string &crabOpts = "") :
+      ModulePass(ID), m_crabOpts (crabOpts) {}
     virtual ~LoadCrab () {}
     
     virtual bool runOnModule (Module &M);
     virtual bool runOnFunction (Function &F);
     virtual void getAnalysisUsage (AnalysisUsage &AU) const;
     virtual const char* getPassName () const {return "LoadCrab";}
+
+  private:
+    /// loads the invariants of every function through the cache
+    void runCached (Module &M);
   };
   
   char LoadCrab::ID = 0;
-  Pass* createLoadCrabPass () {return new LoadCrab ();}
+  Pass* createLoadCrabPass (const std::string &crabOpts)
+  {return new LoadCrab (crabOpts);}
 
 } // end namespace seahorn
 
@@ -54,6 +64,18 @@ namespace seahorn
 #include "seahorn/Transforms/Instrumentation/ShadowMemDsa.hh"
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include "ufo/Stats.hh"
+#include "avy/AvyDebug.h"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
 
 #include "crab_llvm/CrabLlvm.hh"
 #include "crab_llvm/HeapAbstraction.hh"
@@ -472,11 +494,197 @@ namespace crab_llvm {
 } // end namespace crab_llvm
 
 
+static llvm::cl::opt<std::string>
+CrabCache ("horn-crab-cache",
+           llvm::cl::desc ("Directory of Crab invariants cached per function. "
+                           "Crab still analyzes the whole module, the cache "
+                           "only saves translating its invariants. Not used "
+                           "with --crab-inter"),
+           llvm::cl::init (""), llvm::cl::value_desc ("dir"));
+
+static llvm::cl::opt<unsigned>
+CrabCacheJobs ("horn-crab-cache-jobs",
+               llvm::cl::desc ("Threads that hash functions and read and write "
+                               "the Crab cache (0 means one per core)"),
+               llvm::cl::init (0), llvm::cl::Hidden);
+
 namespace seahorn
 {
   using namespace llvm;
   using namespace crab_llvm;
   using namespace expr;
+
+  namespace
+  {
+    /**
+     * Invariants in the cache are over the live variables of their
+     * block, one line per block:
+     *
+     *    <number of live variables> <invariant>
+     *
+     * An invariant is in prefix form, e.g. ( <= ( + v0 v1 ) 10 ), where
+     * vN is the N-th live variable. The live vector is ordered by Expr
+     * id, which other functions can change, so the names of the live
+     * variables in order are part of the key.
+     */
+    const char *CACHE_MAGIC = "seahorn-crab-inv 1";
+
+    /// true if the Crab options ask for an inter-procedural analysis
+    bool interProc (const std::string &opts)
+    {
+      std::istringstream in (opts);
+      std::string arg;
+      while (in >> arg)
+      {
+        StringRef a = StringRef (arg).ltrim ('-');
+        if (a.equals ("crab-inter") || a.equals ("crab-inter=true") ||
+            a.equals ("crab-inter=1"))
+          return true;
+      }
+      return false;
+    }
+
+    /// An invariant read from the cache. No Exprs are built while
+    /// reading, so that it can run on any thread
+    struct InvTerm
+    {
+      enum Kind {VAR, NUM, TT, FF, APP};
+      Kind kind;
+      unsigned var;
+      mpz_class num;
+      std::string op;
+      std::vector<InvTerm> args;
+    };
+
+    const char *opName (Expr e)
+    {
+      if (isOpX<AND> (e)) return "and";
+      if (isOpX<OR> (e)) return "or";
+      if (isOpX<NEG> (e)) return "not";
+      if (isOpX<EQ> (e)) return "=";
+      if (isOpX<NEQ> (e)) return "!=";
+      if (isOpX<LEQ> (e)) return "<=";
+      if (isOpX<GEQ> (e)) return ">=";
+      if (isOpX<LT> (e)) return "<";
+      if (isOpX<GT> (e)) return ">";
+      if (isOpX<PLUS> (e)) return "+";
+      if (isOpX<MINUS> (e)) return "-";
+      if (isOpX<MULT> (e)) return "*";
+      return nullptr;
+    }
+
+    /// Appends e to out. Returns false if e is not over live variables
+    bool writeInv (Expr e, const std::map<Expr, unsigned> &live, std::string &out)
+    {
+      auto it = live.find (e);
+      if (it != live.end ()) { out += " v" + std::to_string (it->second); return true; }
+      if (isOpX<MPZ> (e)) { out += " " + getTerm<mpz_class> (e).get_str (); return true; }
+      if (isOpX<TRUE> (e)) { out += " true"; return true; }
+      if (isOpX<FALSE> (e)) { out += " false"; return true; }
+
+      const char *op = opName (e);
+      if (!op || e->arity () == 0) return false;
+      out += " ( ";
+      out += op;
+      for (auto it = e->args_begin (), end = e->args_end (); it != end; ++it)
+        if (!writeInv (*it, live, out)) return false;
+      out += " )";
+      return true;
+    }
+
+    bool readInv (std::istream &in, unsigned nlive, InvTerm &t)
+    {
+      std::string tok;
+      if (!(in >> tok)) return false;
+      if (tok == "true") { t.kind = InvTerm::TT; return true; }
+      if (tok == "false") { t.kind = InvTerm::FF; return true; }
+      if (tok [0] == 'v')
+      {
+        t.kind = InvTerm::VAR;
+        t.var = std::strtoul (tok.c_str () + 1, nullptr, 10);
+        return t.var < nlive;
+      }
+      if (tok == "(")
+      {
+        t.kind = InvTerm::APP;
+        if (!(in >> t.op)) return false;
+        while (true)
+        {
+          std::streampos pos = in.tellg ();
+          if (!(in >> tok)) return false;
+          if (tok == ")") return !t.args.empty ();
+          in.seekg (pos);
+          t.args.push_back (InvTerm ());
+          if (!readInv (in, nlive, t.args.back ())) return false;
+        }
+      }
+      t.kind = InvTerm::NUM;
+      return t.num.set_str (tok, 10) == 0;
+    }
+
+    /// Reads the invariants of the blocks of a function. Returns
+    /// false if they are not cached
+    bool readInvs (const std::string &file, const std::vector<unsigned> &nlive,
+                   std::vector<InvTerm> &invs)
+    {
+      std::ifstream in (file);
+      std::string line;
+      if (!in || !std::getline (in, line) || line != CACHE_MAGIC) return false;
+
+      invs.assign (nlive.size (), InvTerm ());
+      for (unsigned i = 0, sz = nlive.size (); i < sz; ++i)
+      {
+        if (!std::getline (in, line)) return false;
+        std::istringstream ls (line);
+        unsigned n;
+        if (!(ls >> n) || n != nlive [i] || !readInv (ls, n, invs [i])) return false;
+      }
+      return true;
+    }
+
+    Expr toExpr (const InvTerm &t, const ExprVector &live, ExprFactory &efac)
+    {
+      switch (t.kind)
+      {
+      case InvTerm::VAR: return live [t.var];
+      case InvTerm::NUM: return mkTerm (t.num, efac);
+      case InvTerm::TT: return mk<TRUE> (efac);
+      case InvTerm::FF: return mk<FALSE> (efac);
+      default: break;
+      }
+
+      ExprVector args;
+      for (const InvTerm &a : t.args) args.push_back (toExpr (a, live, efac));
+      if (t.op == "not") return mk<NEG> (args [0]);
+      if (t.op == "and") return mknary<AND> (args);
+      if (t.op == "or") return mknary<OR> (args);
+      if (t.op == "+") return mknary<PLUS> (args);
+      if (t.op == "-") return mknary<MINUS> (args);
+      if (t.op == "*") return mknary<MULT> (args);
+      if (t.op == "=") return mk<EQ> (args [0], args [1]);
+      if (t.op == "!=") return mk<NEQ> (args [0], args [1]);
+      if (t.op == "<=") return mk<LEQ> (args [0], args [1]);
+      if (t.op == ">=") return mk<GEQ> (args [0], args [1]);
+      if (t.op == "<") return mk<LT> (args [0], args [1]);
+      if (t.op == ">") return mk<GT> (args [0], args [1]);
+      // -- unknown operators are not written
+      return mk<TRUE> (efac);
+    }
+
+    /// Writes through a temporary file, so that a concurrent run never
+    /// reads half a file
+    void writeInvs (const std::string &file, const std::string &text)
+    {
+      std::string tmp = file + ".tmp" +
+        std::to_string (std::hash<std::thread::id> () (std::this_thread::get_id ()));
+      {
+        std::ofstream out (tmp);
+        out << CACHE_MAGIC << "\n" << text;
+        if (!out) return;
+      }
+      if (sys::fs::rename (tmp, file)) sys::fs::remove (tmp);
+    }
+  }
   
   // Translate a range of Expr variables to Crab variables but only
   // those that can be mapped to llvm value.
@@ -543,6 +751,14 @@ namespace seahorn
   }
 
   bool LoadCrab::runOnModule (Module &M) {
+    if (!CrabCache.empty () && interProc (m_crabOpts))
+      errs () << "WARNING: --horn-crab-cache ignored with --crab-inter. "
+              << "The invariants of a function depend on other functions\n";
+    else if (!CrabCache.empty ()) {
+      runCached (M);
+      return false;
+    }
+    
     for (auto &F : M) {
       runOnFunction (F);
     }
@@ -581,6 +797,141 @@ namespace seahorn
   }
   
   
+  /// Functions whose text, the text of the globals, the live
+  /// variables of their blocks (by name, in order) and the Crab
+  /// options are unchanged reuse their cached invariants. Only
+  /// intra-procedural invariants are cached since they depend on
+  /// nothing else. Crab itself still runs in CrabLlvmPass on the
+  /// whole module, a hit only saves translating its invariants. Its
+  /// domains are not thread-safe, and neither is building Exprs. Only
+  /// hashing and the cache files are handled on the pool.
+  void LoadCrab::runCached (Module &M)
+  {
+    HornifyModule &hm = getAnalysis<HornifyModule> ();
+    CrabLlvmPass &crab = getAnalysis<CrabLlvmPass> ();
+    auto &db = hm.getHornClauseDB ();
+    ExprFactory &efac = hm.getExprFactory ();
+
+    if (std::error_code ec = sys::fs::create_directories (CrabCache.getValue ()))
+      errs () << "WARNING: cannot create Crab cache " << CrabCache
+              << ": " << ec.message () << "\n";
+
+    struct FnInvs
+    {
+      std::vector<const BasicBlock*> blocks;
+      std::vector<unsigned> nlive;
+      std::string key, file, text;
+      std::vector<InvTerm> invs;
+      bool hit, store;
+    };
+
+    // -- the globals might change the invariants of any function
+    std::string globals;
+    {
+      raw_string_ostream os (globals);
+      for (const GlobalVariable &gv : M.globals ()) os << gv << "\n";
+    }
+
+    std::vector<FnInvs> fns;
+    for (Function &F : M)
+    {
+      FnInvs fi;
+      for (const BasicBlock &BB : F)
+        if (hm.hasBbPredicate (BB))
+        {
+          fi.blocks.push_back (&BB);
+          fi.nlive.push_back (hm.live (BB).size ());
+        }
+      if (fi.blocks.empty ()) continue;
+
+      raw_string_ostream os (fi.key);
+      // -- defaults of the options that are not given depend on the build
+      os << SEAHORN_VERSION_INFO << "\n" << m_crabOpts << "\n";
+      os << globals << F;
+      // -- a name that is not unique does not identify its variable
+      bool unique = true;
+      for (const BasicBlock *bb : fi.blocks)
+      {
+        std::set<std::string> names;
+        for (Expr v : hm.live (*bb))
+        {
+          std::string name;
+          raw_string_ostream ns (name);
+          ns << *v;
+          unique &= names.insert (ns.str ()).second;
+          os << name << " ";
+        }
+        os << "\n";
+      }
+      os.flush ();
+      fi.hit = fi.store = false;
+      if (!unique)
+      {
+        fi.key.clear ();
+        ufo::Stats::count ("CrabCacheSkipped");
+      }
+      fns.push_back (std::move (fi));
+    }
+
+    unsigned threads = CrabCacheJobs > 0 ?
+      (unsigned) CrabCacheJobs : std::thread::hardware_concurrency ();
+    {
+      ThreadPool pool (std::max (threads, 1U));
+      for (FnInvs &fi : fns)
+        if (!fi.key.empty ()) pool.async ([&fi] {
+            MD5 md5;
+            md5.update (fi.key);
+            MD5::MD5Result res;
+            md5.final (res);
+            SmallString<32> hex;
+            MD5::stringifyResult (res, hex);
+            SmallString<256> path (CrabCache.getValue ());
+            sys::path::append (path, hex.str () + ".inv");
+            fi.file = path.str ();
+            fi.hit = readInvs (fi.file, fi.nlive, fi.invs);
+          });
+      pool.wait ();
+    }
+
+    for (FnInvs &fi : fns)
+    {
+      fi.store = !fi.hit && !fi.key.empty ();
+      if (!fi.key.empty ())
+        ufo::Stats::count (fi.hit ? "CrabCacheHits" : "CrabCacheMisses");
+      for (unsigned i = 0, sz = fi.blocks.size (); i < sz; ++i)
+      {
+        const BasicBlock &BB = *fi.blocks [i];
+        const ExprVector &live = hm.live (BB);
+        Expr exp = fi.hit ? toExpr (fi.invs [i], live, efac) :
+          CrabInvToExpr (&BB, &crab, live, hm.getZContext (), efac);
+        Expr pred = hm.bbPredicate (BB);
+
+        LOG ("crab",
+             errs () << "Loading " << (fi.hit ? "cached " : "")
+                     << "invariant " << *bind::fname (pred);
+             errs () << "("; for (auto v: live) errs () << *v << " ";
+             errs () << ")  "  << *exp << "\n"; );
+
+        db.addConstraint (bind::fapp (pred, live), exp);
+
+        if (!fi.store) continue;
+        std::map<Expr, unsigned> idx;
+        for (unsigned j = 0, n = live.size (); j < n; ++j) idx [live [j]] = j;
+        fi.text += std::to_string (live.size ());
+        // -- e.g., a shadow variable that is not live. Not cached
+        fi.store = writeInv (exp, idx, fi.text);
+        fi.text += "\n";
+      }
+    }
+
+    {
+      ThreadPool pool (std::max (threads, 1U));
+      for (FnInvs &fi : fns)
+        if (fi.store) pool.async ([&fi] { writeInvs (fi.file, fi.text); });
+      pool.wait ();
+    }
+  }
+  
   void LoadCrab::getAnalysisUsage (AnalysisUsage &AU) const
   {
     AU.setPreservesAll ();
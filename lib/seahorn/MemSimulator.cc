@@ -368,6 +368,9 @@ namespace seahorn
     // extract module from trace
     if (m_trace.size () == 0) return false;
     const Module &M = *m_trace.bb (0)->getParent ()->getParent ();
+    // -- the visitor asks for the value of most instructions
+    m_trace.evalAll ();
+
     ExprVector side;
     MemSimVisitor v (*this, side);
     v.setPrev (nullptr);
@@ -403,6 +406,7 @@ namespace seahorn
       LOG ("memsim",
            errs () << "Memory simulation: Success\n";);
       m_model = solver.getModel ();
+      m_values.clear ();
       LOG ("memsim", errs () << m_model << "\n";);
       return true;
     }
@@ -427,8 +431,58 @@ namespace seahorn
     if (!inst.getType ()->isPointerTy ())
       return m_trace.eval (loc, inst, complete);
       
+    auto key = std::make_tuple (loc, &inst, complete);
+    auto it = m_values.find (key);
+    if (it != m_values.end ()) return it->second;
+
     Expr v = m_trace.symb (loc, inst);
     if (v) v = m_model.eval (v, complete);
+    m_values [key] = v;
     return v;
-  }  
+  }
+
+  void MemSimulator::eval (const std::vector<BmcTrace::Point> &pts,
+                           ExprVector &out, bool complete)
+  {
+    // -- everything but pointers comes from the trace
+    std::vector<BmcTrace::Point> other;
+    ExprVector terms;
+    std::vector<std::tuple<unsigned, const Instruction*, bool> > pending;
+    for (const BmcTrace::Point &pt : pts)
+    {
+      const Instruction *inst = dyn_cast<const Instruction> (pt.second);
+      if (!inst || !inst->getType ()->isPointerTy ())
+      {
+        other.push_back (pt);
+        continue;
+      }
+
+      auto key = std::make_tuple (pt.first, inst, complete);
+      if (m_values.count (key) > 0) continue;
+      Expr v = m_trace.symb (pt.first, *inst);
+      m_values [key] = Expr ();
+      if (!v) continue;
+      terms.push_back (v);
+      pending.push_back (key);
+    }
+
+    ExprVector vals;
+    m_model.eval (terms, vals, complete);
+    for (unsigned i = 0, sz = pending.size (); i < sz; ++i)
+      m_values [pending [i]] = vals [i];
+
+    ExprVector otherVals;
+    m_trace.eval (other, otherVals, complete);
+
+    out.clear ();
+    unsigned j = 0;
+    for (const BmcTrace::Point &pt : pts)
+    {
+      const Instruction *inst = dyn_cast<const Instruction> (pt.second);
+      if (!inst || !inst->getType ()->isPointerTy ())
+        out.push_back (otherVals [j++]);
+      else
+        out.push_back (m_values [std::make_tuple (pt.first, inst, complete)]);
+    }
+  }
 }
@@ -1,4 +1,5 @@
 #include "seahorn/PredicateAbstraction.hh"
+#include "seahorn/Houdini.hh"
 #include "seahorn/HornifyModule.hh"
 #include "seahorn/HornClauseDBTransf.hh"
 #include "seahorn/HornClauseDB.hh"
@@ -28,6 +29,12 @@ UserCandidatesFile ("pa-candidates-file",
 		    cl::init ("preds_temp"),
 		    cl::Hidden);
 
+static llvm::cl::opt<bool>
+TemplateCandidates ("pa-templates",
+		    llvm::cl::desc ("Guess candidates from interval, equality and "
+				    "octagon templates instead of a file"),
+		    cl::init (false));
+
 namespace seahorn
 {
   char PredicateAbstraction::ID = 0;
@@ -378,6 +385,15 @@ namespace seahorn
 
   void PredicateAbstractionAnalysis::guessCandidate(HornClauseDB &db)
   {
+    if (TemplateCandidates)
+    {
+      Houdini houdini(m_hm);
+      TemplateCands tc(db);
+      houdini.sampleStates(tc);
+      tc.candidates(m_currentCandidates);
+      return;
+    }
+
     for(Expr rel : db.getRelations())
     {
       if(bind::isFdecl(rel))
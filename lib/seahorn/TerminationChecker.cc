@@ -0,0 +1,686 @@
+#include "seahorn/TerminationChecker.hh"
+#include "seahorn/HornifyModule.hh"
+#include "seahorn/HornClauseDB.hh"
+#include "seahorn/Analysis/CutPointGraph.hh"
+
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include "ufo/Smt/EZ3.hh"
+#include "ufo/Stats.hh"
+#include "avy/AvyDebug.h"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+
+static llvm::cl::opt<unsigned>
+TermJobs ("horn-term-jobs",
+          llvm::cl::desc ("Number of loops checked in parallel (0 = number of cores)"),
+          llvm::cl::init (0));
+
+static llvm::cl::opt<unsigned>
+TermTimeout ("horn-term-timeout",
+             llvm::cl::desc ("Timeout per loop in seconds (0 = no timeout)"),
+             llvm::cl::init (60));
+
+static llvm::cl::opt<unsigned>
+TermMaxRounds ("horn-term-max-rounds",
+               llvm::cl::desc ("Maximum number of refinements of a ranking function candidate"),
+               llvm::cl::init (100));
+
+static llvm::cl::opt<unsigned>
+TermMaxDisjuncts ("horn-term-max-disjuncts",
+                  llvm::cl::desc ("Maximum number of paths a transition is split into"),
+                  llvm::cl::init (32));
+
+namespace seahorn
+{
+  char TerminationChecker::ID = 0;
+
+  namespace
+  {
+    typedef std::chrono::steady_clock clock_type;
+
+    double secondsSince (clock_type::time_point start)
+    {return std::chrono::duration<double> (clock_type::now () - start).count ();}
+
+    /// Non-trivial strongly connected components of a cut-point graph
+    /// (Tarjan). Each component is sorted by cut-point id so that the
+    /// first cut-point is the loop header.
+    class CpSccs
+    {
+      typedef std::vector<const CutPoint*> CpVector;
+
+      std::vector<unsigned> m_index;
+      std::vector<unsigned> m_low;
+      std::vector<bool> m_onStack;
+      CpVector m_stack;
+      unsigned m_next;
+      std::vector<CpVector> &m_out;
+
+      void visit (const CutPoint &cp)
+      {
+        unsigned v = cp.id ();
+        m_index [v] = m_low [v] = ++m_next;
+        m_stack.push_back (&cp);
+        m_onStack [v] = true;
+
+        bool selfLoop = false;
+        for (const CpEdge *edg : boost::make_iterator_range (succ_begin (cp), succ_end (cp)))
+        {
+          unsigned w = edg->target ().id ();
+          if (w == v) selfLoop = true;
+          if (m_index [w] == 0)
+          {
+            visit (edg->target ());
+            m_low [v] = std::min (m_low [v], m_low [w]);
+          }
+          else if (m_onStack [w])
+            m_low [v] = std::min (m_low [v], m_index [w]);
+        }
+
+        if (m_low [v] != m_index [v]) return;
+
+        CpVector scc;
+        const CutPoint *top;
+        do
+        {
+          top = m_stack.back ();
+          m_stack.pop_back ();
+          m_onStack [top->id ()] = false;
+          scc.push_back (top);
+        } while (top != &cp);
+
+        if (scc.size () == 1 && !selfLoop) return;
+        std::sort (scc.begin (), scc.end (),
+                   [] (const CutPoint *a, const CutPoint *b)
+                   {return a->id () < b->id ();});
+        m_out.push_back (scc);
+      }
+
+    public:
+      CpSccs (const CutPointGraph &cpg, std::vector<CpVector> &out) :
+        m_next (0), m_out (out)
+      {
+        unsigned sz = std::distance (cpg.begin (), cpg.end ());
+        m_index.assign (sz, 0);
+        m_low.assign (sz, 0);
+        m_onStack.assign (sz, false);
+        for (const CutPoint &cp : cpg)
+          if (m_index [cp.id ()] == 0) visit (cp);
+      }
+    };
+
+    /// coefficients of a linear function over the integer arguments
+    /// of a predicate. The last element is the constant term.
+    typedef std::vector<mpz_class> Coeffs;
+    /// one linear function per predicate of a loop
+    typedef std::vector<Coeffs> RankFn;
+    /// values of the integer arguments before and after a transition
+    typedef std::pair<std::vector<mpz_class>, std::vector<mpz_class> > Sample;
+
+    /// A rule P(pre) /\ body -> Q(post) with P and Q in the loop
+    struct Transition
+    {
+      unsigned src;
+      unsigned dst;
+      ExprVector pre;
+      ExprVector post;
+      Expr body;
+    };
+
+    /// Termination check of a single loop.
+    ///
+    /// Like IncChecker jobs, the job owns its expression factory and
+    /// Z3 context and copies the rules of the loop on construction so
+    /// that run() can execute on a worker thread.
+    class TermJob
+    {
+    public:
+      enum Verdict {TERMINATES, UNKNOWN, TIMEOUT};
+
+    private:
+      const Function &m_fn;
+      const BasicBlock &m_header;
+      ExprFactory m_efac;
+      EZ3 m_zctx;
+
+      /// -- predicates of the loop. The first one is the header
+      ExprVector m_preds;
+      /// -- positions of the integer arguments of each predicate
+      std::vector<std::vector<unsigned> > m_intArgs;
+      /// -- names of the integer arguments of the header, for printing
+      std::vector<std::string> m_headerArgs;
+      std::vector<Transition> m_trans;
+      /// -- false if some rule has more than one loop predicate in its body
+      bool m_supported;
+
+      /// -- unknown coefficients, same shape as RankFn
+      std::vector<ExprVector> m_unknowns;
+      /// -- counterexamples to earlier candidates, per transition
+      std::vector<std::vector<Sample> > m_samples;
+      /// -- one incremental solver per transition with its body asserted
+      std::vector<std::unique_ptr<ZSolver<EZ3> > > m_validators;
+
+      clock_type::time_point m_start;
+      Verdict m_verdict;
+      std::vector<RankFn> m_ranks;
+      double m_time;
+
+      bool timedOut () const
+      {return TermTimeout > 0 && secondsSince (m_start) >= TermTimeout;}
+
+      Expr mkNum (const mpz_class &v) {return mkTerm<mpz_class> (v, m_efac);}
+
+      /// -- the ranking function of predicate p applied to args
+      Expr symRank (unsigned p, const ExprVector &args, const Coeffs &c)
+      {
+        ExprVector terms (1, mkNum (c.back ()));
+        const std::vector<unsigned> &ints = m_intArgs [p];
+        for (unsigned k = 0; k < ints.size (); ++k)
+          if (c [k] != 0) terms.push_back (mk<MULT> (mkNum (c [k]), args [ints [k]]));
+        return mknary<PLUS> (terms);
+      }
+
+      /// -- the template of predicate p applied to concrete values
+      Expr unknownRank (unsigned p, const std::vector<mpz_class> &vals)
+      {
+        const ExprVector &unknowns = m_unknowns [p];
+        ExprVector terms (1, unknowns.back ());
+        for (unsigned k = 0; k < vals.size (); ++k)
+          if (vals [k] != 0) terms.push_back (mk<MULT> (mkNum (vals [k]), unknowns [k]));
+        return mknary<PLUS> (terms);
+      }
+
+      /// -- strict: bounded and decreasing by at least one, otherwise
+      /// -- non-increasing
+      Expr rankCond (Expr pre, Expr post, bool strict)
+      {
+        Expr diff = mk<MINUS> (pre, post);
+        if (!strict) return mk<GEQ> (diff, mkNum (0));
+        return boolop::land (mk<GEQ> (pre, mkNum (0)), mk<GEQ> (diff, mkNum (1)));
+      }
+
+      bool evalInts (ZSolver<EZ3>::Model &model, const ExprVector &args,
+                     const std::vector<unsigned> &ints, std::vector<mpz_class> &out)
+      {
+        for (unsigned i : ints)
+        {
+          Expr v = model.eval (args [i], true);
+          if (!isOpX<MPZ> (v)) return false;
+          out.push_back (getTerm<mpz_class> (v));
+        }
+        return true;
+      }
+
+      boost::tribool validate (unsigned t, const RankFn &r, bool strict);
+      boost::tribool synthesize (unsigned target, const std::vector<bool> &active,
+                                 RankFn &out);
+      bool cyclic (const std::vector<bool> &active, std::vector<bool> &onCycle) const;
+      void split (ZParams<EZ3> &params);
+      void check ();
+
+    public:
+      TermJob (const Function &fn, const BasicBlock &header, const ExprVector &preds,
+               HornifyModule &hm, HornClauseDB &db);
+
+      void run ();
+      void print (raw_ostream &out) const;
+      Verdict verdict () const {return m_verdict;}
+    };
+
+    TermJob::TermJob (const Function &fn, const BasicBlock &header,
+                      const ExprVector &preds, HornifyModule &hm, HornClauseDB &db) :
+      m_fn (fn), m_header (header), m_zctx (m_efac), m_supported (true),
+      m_verdict (UNKNOWN), m_time (0.0)
+    {
+      DagVisitCache cache;
+
+      std::map<Expr, unsigned> idx;
+      for (Expr p : preds)
+      {
+        idx [p] = m_preds.size ();
+        m_preds.push_back (copyTo (p, m_efac, cache));
+        m_intArgs.push_back (std::vector<unsigned> ());
+        for (unsigned i = 0, sz = bind::domainSz (p); i < sz; ++i)
+          if (isOpX<INT_TY> (bind::domainTy (p, i))) m_intArgs.back ().push_back (i);
+      }
+
+      const ExprVector &lv = hm.live (hm.predicateBb (preds [0]));
+      for (unsigned i : m_intArgs [0])
+      {
+        std::ostringstream name;
+        if (i < lv.size ()) name << *lv [i];
+        else name << "arg_" << i;
+        m_headerArgs.push_back (name.str ());
+      }
+
+      for (Expr p : preds)
+        for (const HornRule *r : db.def (p))
+        {
+          ExprVector apps;
+          get_all_pred_apps (r->body (), db, std::back_inserter (apps));
+
+          Expr src;
+          unsigned inLoop = 0;
+          for (Expr app : apps)
+            if (idx.count (bind::fname (app)) > 0) { src = app; ++inLoop; }
+
+          // -- entry into the loop
+          if (inLoop == 0) continue;
+          if (inLoop > 1) { m_supported = false; continue; }
+
+          // -- calls are abstracted away; invariants of the source
+          // -- (if any) strengthen the transition
+          ExprMap sub;
+          for (Expr app : apps) sub [app] = mk<TRUE> (db.getExprFactory ());
+          Expr body = boolop::land (replace (r->body (), sub), db.getConstraints (src));
+
+          Transition t;
+          t.src = idx [bind::fname (src)];
+          t.dst = idx [p];
+          for (auto it = ++src->args_begin (), end = src->args_end (); it != end; ++it)
+            t.pre.push_back (copyTo (*it, m_efac, cache));
+          Expr head = r->head ();
+          for (auto it = ++head->args_begin (), end = head->args_end (); it != end; ++it)
+            t.post.push_back (copyTo (*it, m_efac, cache));
+          t.body = copyTo (body, m_efac, cache);
+          m_trans.push_back (t);
+        }
+    }
+
+    void TermJob::run ()
+    {
+      m_start = clock_type::now ();
+      try
+      {
+        if (m_supported) check ();
+      }
+      catch (z3::exception &e)
+      {
+        LOG ("term", errs () << "TerminationChecker: " << m_fn.getName ()
+             << ": " << e.msg () << "\n";);
+        m_verdict = UNKNOWN;
+      }
+      m_time = secondsSince (m_start);
+    }
+
+    boost::tribool TermJob::validate (unsigned t, const RankFn &r, bool strict)
+    {
+      const Transition &tr = m_trans [t];
+      ZSolver<EZ3> &solver = *m_validators [t];
+
+      solver.push ();
+      solver.assertExpr (mk<NEG> (rankCond (symRank (tr.src, tr.pre, r [tr.src]),
+                                            symRank (tr.dst, tr.post, r [tr.dst]),
+                                            strict)));
+      boost::tribool res = solver.solve ();
+      if (res)
+      {
+        Sample s;
+        ZSolver<EZ3>::Model model = solver.getModel ();
+        if (evalInts (model, tr.pre, m_intArgs [tr.src], s.first) &&
+            evalInts (model, tr.post, m_intArgs [tr.dst], s.second))
+          m_samples [t].push_back (s);
+        else
+          res = boost::indeterminate;
+      }
+      solver.pop ();
+
+      return !res;
+    }
+
+    boost::tribool TermJob::synthesize (unsigned target,
+                                        const std::vector<bool> &active,
+                                        RankFn &out)
+    {
+      ZSolver<EZ3> synth (m_zctx);
+      if (TermTimeout > 0)
+      {
+        ZParams<EZ3> params (m_zctx);
+        params.set (":timeout", TermTimeout * 1000U);
+        synth.set (params);
+      }
+
+      auto addSample = [&] (unsigned t, const Sample &s)
+        {
+          const Transition &tr = m_trans [t];
+          synth.assertExpr (rankCond (unknownRank (tr.src, s.first),
+                                      unknownRank (tr.dst, s.second),
+                                      t == target));
+        };
+
+      for (unsigned t = 0; t < m_trans.size (); ++t)
+        if (active [t])
+          for (const Sample &s : m_samples [t]) addSample (t, s);
+
+      for (unsigned round = 0; round < TermMaxRounds; ++round)
+      {
+        if (timedOut ()) return boost::indeterminate;
+
+        boost::tribool res = synth.solve ();
+        if (boost::indeterminate (res)) return res;
+        // -- no linear function decreases on target
+        if (!res) return false;
+
+        ZSolver<EZ3>::Model model = synth.getModel ();
+        RankFn r;
+        for (const ExprVector &unknowns : m_unknowns)
+        {
+          r.push_back (Coeffs ());
+          for (Expr u : unknowns)
+          {
+            Expr v = model.eval (u, true);
+            if (!isOpX<MPZ> (v)) return boost::indeterminate;
+            r.back ().push_back (getTerm<mpz_class> (v));
+          }
+        }
+
+        bool valid = true;
+        for (unsigned t = 0; t < m_trans.size (); ++t)
+        {
+          if (!active [t]) continue;
+          boost::tribool v = validate (t, r, t == target);
+          if (boost::indeterminate (v)) return v;
+          if (!v)
+          {
+            valid = false;
+            addSample (t, m_samples [t].back ());
+          }
+        }
+
+        if (valid)
+        {
+          out = r;
+          return true;
+        }
+      }
+
+      // -- give up on this target
+      return false;
+    }
+
+    /// A large-step transition merges several paths of the loop, and a
+    /// disjunction of paths seldom has a linear ranking function even
+    /// when each path has one. Replace every transition by the cubes of
+    /// its body over its Boolean constants, which fix the path. A
+    /// transition with more than TermMaxDisjuncts cubes is kept whole.
+    void TermJob::split (ZParams<EZ3> &params)
+    {
+      std::vector<Transition> out;
+      for (const Transition &tr : m_trans)
+      {
+        ExprVector consts, bools;
+        filter (tr.body, bind::IsConst (), std::back_inserter (consts));
+        for (Expr c : consts)
+          if (bind::isBoolConst (c)) bools.push_back (c);
+        if (bools.empty ())
+        {
+          out.push_back (tr);
+          continue;
+        }
+
+        ZSolver<EZ3> solver (m_zctx);
+        solver.set (params);
+        solver.assertExpr (tr.body);
+
+        std::vector<Transition> parts;
+        bool complete = false;
+        while (!timedOut ())
+        {
+          boost::tribool res = solver.solve ();
+          if (!res) complete = true;
+          if (!res || boost::indeterminate (res)) break;
+          if (parts.size () >= TermMaxDisjuncts) break;
+
+          ZSolver<EZ3>::Model model = solver.getModel ();
+          ExprVector cube;
+          for (Expr b : bools)
+            cube.push_back (isOpX<TRUE> (model.eval (b, true)) ? b : mk<NEG> (b));
+          Expr c = mknary<AND> (mk<TRUE> (m_efac), cube);
+
+          parts.push_back (tr);
+          parts.back ().body = boolop::land (tr.body, c);
+          solver.assertExpr (mk<NEG> (c));
+        }
+
+        // -- an infeasible transition is dropped altogether
+        if (complete) out.insert (out.end (), parts.begin (), parts.end ());
+        else out.push_back (tr);
+      }
+
+      LOG ("term", errs () << "TerminationChecker: " << m_fn.getName () << ": "
+           << m_trans.size () << " transitions split into " << out.size () << "\n";);
+      m_trans.swap (out);
+    }
+
+    bool TermJob::cyclic (const std::vector<bool> &active,
+                          std::vector<bool> &onCycle) const
+    {
+      unsigned n = m_preds.size ();
+      // -- reach [i][j] iff j is reachable from i by active transitions
+      std::vector<std::vector<bool> > reach (n, std::vector<bool> (n, false));
+      for (unsigned i = 0; i < n; ++i)
+      {
+        std::vector<unsigned> wl (1, i);
+        while (!wl.empty ())
+        {
+          unsigned u = wl.back ();
+          wl.pop_back ();
+          for (unsigned t = 0; t < m_trans.size (); ++t)
+            if (active [t] && m_trans [t].src == u && !reach [i][m_trans [t].dst])
+            {
+              reach [i][m_trans [t].dst] = true;
+              wl.push_back (m_trans [t].dst);
+            }
+        }
+      }
+
+      bool res = false;
+      onCycle.assign (m_trans.size (), false);
+      for (unsigned t = 0; t < m_trans.size (); ++t)
+        if (active [t] && reach [m_trans [t].dst][m_trans [t].src])
+          onCycle [t] = res = true;
+      return res;
+    }
+
+    void TermJob::check ()
+    {
+      unsigned n = 0;
+      for (unsigned p = 0; p < m_preds.size (); ++p)
+      {
+        m_unknowns.push_back (ExprVector ());
+        for (unsigned k = 0; k <= m_intArgs [p].size (); ++k)
+        {
+          Expr name = mkTerm<std::string>
+            ("c_" + boost::lexical_cast<std::string> (n++), m_efac);
+          m_unknowns.back ().push_back (bind::intConst (name));
+        }
+      }
+
+      ZParams<EZ3> params (m_zctx);
+      if (TermTimeout > 0) params.set (":timeout", TermTimeout * 1000U);
+      split (params);
+      m_samples.resize (m_trans.size ());
+      for (const Transition &tr : m_trans)
+      {
+        m_validators.push_back
+          (std::unique_ptr<ZSolver<EZ3> > (new ZSolver<EZ3> (m_zctx)));
+        m_validators.back ()->set (params);
+        m_validators.back ()->assertExpr (tr.body);
+      }
+
+      std::vector<bool> active (m_trans.size (), true);
+      std::vector<bool> onCycle;
+      while (cyclic (active, onCycle))
+      {
+        bool found = false;
+        for (unsigned t = 0; t < m_trans.size () && !found; ++t)
+        {
+          if (!onCycle [t]) continue;
+
+          RankFn r;
+          boost::tribool res = synthesize (t, active, r);
+          if (boost::indeterminate (res))
+          {
+            m_verdict = timedOut () ? TIMEOUT : UNKNOWN;
+            return;
+          }
+          if (!res) continue;
+
+          // -- drop every transition on which r is a ranking function
+          for (unsigned u = 0; u < m_trans.size (); ++u)
+            if (active [u] && (u == t || validate (u, r, true)))
+              active [u] = false;
+
+          m_ranks.push_back (r);
+          found = true;
+        }
+
+        if (!found)
+        {
+          m_verdict = timedOut () ? TIMEOUT : UNKNOWN;
+          return;
+        }
+      }
+
+      m_verdict = TERMINATES;
+    }
+
+    void TermJob::print (raw_ostream &out) const
+    {
+      const char *res = "UNKNOWN";
+      switch (m_verdict)
+      {
+      case TERMINATES: res = "TERMINATES"; break;
+      case TIMEOUT: res = "TIMEOUT"; break;
+      case UNKNOWN: break;
+      }
+
+      // -- lexicographic ranking function at the loop header
+      std::string ranking;
+      for (const RankFn &r : m_ranks)
+      {
+        const Coeffs &c = r [0];
+        std::string comp;
+        for (unsigned k = 0; k < m_headerArgs.size (); ++k)
+        {
+          if (c [k] == 0) continue;
+          if (!comp.empty ()) comp += " + ";
+          if (c [k] != 1) comp += c [k].get_str () + "*";
+          comp += m_headerArgs [k];
+        }
+        if (comp.empty () || c.back () != 0)
+          comp += (comp.empty () ? "" : " + ") + c.back ().get_str ();
+        ranking += (ranking.empty () ? "" : ", ") + comp;
+      }
+
+      out << "\n  -----------------\n"
+          << "  FUNCTION NAME: " << m_fn.getName () << "\n"
+          << "    LOOP HEADER: " << m_header.getName () << "\n"
+          << "    TRANSITIONS: " << m_trans.size () << "\n"
+          << "         RESULT: " << res << "\n"
+          << "        RANKING: (" << ranking << ")\n"
+          << "  ANALYSIS TIME: " << format ("%.2f", m_time) << "\n"
+          << " ------------------\n";
+    }
+  }
+
+  bool TerminationChecker::runOnModule (Module &M)
+  {
+    ScopedStats _st_ ("TerminationChecker");
+
+    HornifyModule &hm = getAnalysis<HornifyModule> ();
+    HornClauseDB &db = hm.getHornClauseDB ();
+    db.buildIndexes ();
+
+    std::map<const BasicBlock*, Expr> bbPred;
+    for (Expr rel : db.getRelations ())
+      if (hm.isBbPredicate (rel)) bbPred [&hm.predicateBb (rel)] = rel;
+
+    std::vector<std::unique_ptr<TermJob> > jobs;
+    for (Function &F : M)
+    {
+      if (F.isDeclaration ()) continue;
+
+      const CutPointGraph &cpg = getAnalysis<CutPointGraph> (F);
+      std::vector<std::vector<const CutPoint*> > sccs;
+      CpSccs sccFinder (cpg, sccs);
+
+      for (auto &scc : sccs)
+      {
+        // -- predicates of the cut-points of the loop, and of the
+        // -- blocks in between with a small-step encoding
+        ExprVector preds;
+        ExprSet seen;
+        auto addBlock = [&] (const BasicBlock &bb)
+          {
+            auto it = bbPred.find (&bb);
+            if (it != bbPred.end () && seen.insert (it->second).second)
+              preds.push_back (it->second);
+          };
+
+        std::set<unsigned> ids;
+        for (const CutPoint *cp : scc)
+        {
+          ids.insert (cp->id ());
+          addBlock (cp->bb ());
+        }
+        if (preds.empty ()) continue;
+
+        for (const CutPoint *cp : scc)
+          for (const CpEdge *edg : boost::make_iterator_range (succ_begin (*cp),
+                                                               succ_end (*cp)))
+            if (ids.count (edg->target ().id ()) > 0)
+              for (const BasicBlock &bb : *edg) addBlock (bb);
+
+        jobs.push_back (std::unique_ptr<TermJob>
+                        (new TermJob (F, scc.front ()->bb (), preds, hm, db)));
+      }
+    }
+
+    unsigned threads = TermJobs > 0 ?
+      (unsigned) TermJobs : std::thread::hardware_concurrency ();
+    {
+      ScopedStats _st_ ("TerminationChecker.solve");
+      llvm::ThreadPool pool (std::max (threads, 1U));
+      for (auto &job : jobs)
+      {
+        TermJob *j = job.get ();
+        pool.async ([j] { j->run (); });
+      }
+      pool.wait ();
+    }
+
+    outs () << "\n\t =========  SEAHORN TERMINATION CHECKS   ========\n";
+    unsigned proved = 0;
+    for (auto &job : jobs)
+    {
+      job->print (outs ());
+      if (job->verdict () == TermJob::TERMINATES) ++proved;
+    }
+    outs ().flush ();
+
+    Stats::uset ("TermLoops", jobs.size ());
+    Stats::uset ("TermProved", proved);
+    Stats::sset ("TermResult", proved == jobs.size () ? "TRUE" : "UNKNOWN");
+    return false;
+  }
+
+  void TerminationChecker::getAnalysisUsage (AnalysisUsage &AU) const
+  {
+    AU.setPreservesAll ();
+    AU.addRequired<CutPointGraph> ();
+    AU.addRequired<HornifyModule> ();
+  }
+}
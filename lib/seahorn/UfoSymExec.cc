@@ -1,5 +1,6 @@
 // Symbolic execution (loosely) based on semantics used in UFO
 #include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/Analysis/ValueTracking.h"
 
 #include "seahorn/UfoSymExec.hh"
 #include "seahorn/Support/CFG.hh"
@@ -12,6 +13,8 @@
 #include "ufo/Smt/EZ3.hh"
 #include "ufo/Stats.hh"
 
+#include <set>
+
 //#include <queue>
 
 using namespace seahorn;
@@ -88,6 +91,18 @@ LargeStepReduce ("horn-large-reduce",
                  cl::init (false),
                  cl::Hidden);
 
+static llvm::cl::opt<bool>
+SplitMem ("horn-split-mem",
+          llvm::cl::desc ("Encode memory regions accessed only at known offsets "
+                          "of one object as scalar cells instead of arrays"),
+          cl::init (false));
+
+static llvm::cl::opt<unsigned>
+SplitMemMaxCells ("horn-split-mem-max-cells",
+                  llvm::cl::desc ("Largest number of cells of a split region"),
+                  cl::init (16),
+                  cl::Hidden);
+
 static const Value *extractUniqueScalar (CallSite &cs)
 {
    if (!EnableUniqueScalars)
@@ -133,6 +148,12 @@ namespace
     /// --- true if the current read/write is to unique memory location
     bool m_uniq;
 
+    /// -- the current read/write is to a region split into cells
+    const UfoSmallSymExec::MemRegion *m_region;
+    /// -- versions of that region read and written
+    const Value *m_cellIn;
+    const Value *m_cellOut;
+
     /// -- parameters for a function call
     ExprVector m_fparams;
 
@@ -150,6 +171,8 @@ namespace
       zeroE = mkTerm<mpz_class> (0, m_efac);
       oneE = mkTerm<mpz_class> (1, m_efac);
       m_uniq = false;
+      m_region = nullptr;
+      m_cellIn = m_cellOut = nullptr;
       resetActiveLit ();
       // -- first two arguments are reserved for error flag
       m_fparams.push_back (falseE);
@@ -829,6 +852,20 @@ namespace
       }
       else if (F.getName ().startswith ("shadow.mem"))
       {
+        if (const UfoSmallSymExec::MemRegion *r = m_sem.splitRegion (I))
+        {
+          // -- the cells are read and written by the load or store
+          // -- that follows. A fresh region needs nothing
+          if (F.getName ().equals ("shadow.mem.load") ||
+              F.getName ().equals ("shadow.mem.store"))
+          {
+            m_region = r;
+            m_cellIn = CS.getArgument (1);
+            if (F.getName ().equals ("shadow.mem.store")) m_cellOut = &I;
+          }
+          return;
+        }
+
         if (!m_sem.isTracked (I))
           return;
 
@@ -930,10 +967,27 @@ namespace
         }
       }
 
+      const UfoSmallSymExec::MemRegion *region = m_region;
+      const Value *cellIn = m_cellIn;
+      m_region = nullptr;
+      m_cellIn = nullptr;
+
       if (!m_sem.isTracked (I)) return;
 
       // -- define (i.e., use) the value of the instruction
       Expr lhs = havoc (I);
+      if (region)
+      {
+        int64_t off = m_sem.cellOffset (*I.getPointerOperand ());
+        Expr rhs = m_sem.cellInit (*region, off);
+        if (!rhs) rhs = m_s.read (m_sem.cell (*cellIn, off));
+        if (I.getType ()->isIntegerTy (1))
+          // -- convert to Boolean
+          rhs = mk<NEQ> (rhs, mkTerm (mpz_class(0), m_efac));
+
+        side (lhs, rhs);
+        return;
+      }
       if (!m_inMem) return;
 
       if (m_uniq)
@@ -974,6 +1028,12 @@ namespace
         }
       }
 
+      if (m_region && m_cellOut)
+      {
+        storeCell (I);
+        return;
+      }
+
       if (!m_inMem || !m_outMem || !m_sem.isTracked (*I.getOperand (0))) return;
 
       Expr act = GlobalConstraints ? trueE : m_activeLit;
@@ -998,6 +1058,30 @@ namespace
     }
 
 
+    /// Store into a region that is split into cells. Every other cell
+    /// keeps its value in the new version of the region
+    void storeCell (StoreInst &I)
+    {
+      int64_t off = m_sem.cellOffset (*I.getPointerOperand ());
+      Expr v = lookup (*I.getOperand (0));
+      if (v && I.getOperand (0)->getType ()->isIntegerTy (1))
+        // -- convert to int
+        v = boolop::lite (v, mkTerm (mpz_class (1), m_efac),
+                          mkTerm (mpz_class (0), m_efac));
+
+      for (auto &c : m_region->cells)
+      {
+        Expr out = m_sem.cell (*m_cellOut, c.first);
+        if (c.first == off)
+          side (m_s.havoc (out), v);
+        else
+          m_s.write (out, m_s.read (m_sem.cell (*m_cellIn, c.first)));
+      }
+
+      m_region = nullptr;
+      m_cellIn = m_cellOut = nullptr;
+    }
+
     void visitCastInst (CastInst &I)
     {
       if (!m_sem.isTracked (I)) return;
@@ -1047,12 +1131,26 @@ namespace
       // -- evaluate all phi-nodes atomically. First read all incoming
       // -- values, then update phi-nodes all together.
       ExprVector ops;
+      // -- cells of split regions and their incoming values
+      ExprVector cells;
+      ExprVector cellOps;
 
       auto curr = BB.begin ();
       if (!isa<PHINode> (curr)) return;
 
       for (; PHINode *phi = dyn_cast<PHINode> (curr); ++curr)
       {
+        if (const UfoSmallSymExec::MemRegion *r = m_sem.splitRegion (*phi))
+        {
+          const Value &v = *phi->getIncomingValueForBlock (&m_dst);
+          for (auto &c : r->cells)
+          {
+            cells.push_back (m_sem.cell (*phi, c.first));
+            cellOps.push_back (m_s.read (m_sem.cell (v, c.first)));
+          }
+          continue;
+        }
+
         // skip phi nodes that are not tracked
         if (!m_sem.isTracked (*phi)) continue;
         const Value &v = *phi->getIncomingValueForBlock (&m_dst);
@@ -1069,6 +1167,9 @@ namespace
         Expr op0 = ops[i++];
         side (lhs, op0);
       }
+
+      for (unsigned i = 0, sz = cells.size (); i < sz; ++i)
+        side (m_s.havoc (cells [i]), cellOps [i]);
     }
   };
 }
@@ -1154,6 +1255,213 @@ namespace seahorn
     return m_td->getStructLayout (const_cast<StructType*>(t))->getElementOffset (field);
   }
 
+  /// The shadow.mem call that defines a shadow value
+  static const CallInst *shadowDef (const Value &V)
+  {
+    SmallPtrSet<const Value*, 8> seen;
+    SmallVector<const Value*, 8> wl;
+    wl.push_back (&V);
+    while (!wl.empty ())
+    {
+      const Value *val = wl.pop_back_val ();
+      if (!seen.insert (val).second) continue;
+
+      if (const CallInst *ci = dyn_cast<const CallInst> (val))
+      {
+        const Function *fn = ci->getCalledFunction ();
+        return fn && fn->getName ().startswith ("shadow.mem") ? ci : nullptr;
+      }
+      else if (const PHINode *phi = dyn_cast<const PHINode> (val))
+      {
+        for (unsigned i = 0; i < phi->getNumIncomingValues (); ++i)
+          wl.push_back (phi->getIncomingValue (i));
+      }
+      else return nullptr;
+    }
+    return nullptr;
+  }
+
+  /// The object a pointer points into, if it is a global or a static
+  /// alloca and the offset is a constant
+  static const Value *cellBase (const Value &ptr, int64_t &off,
+                                const DataLayout &dl)
+  {
+    off = 0;
+    const Value *base = GetPointerBaseWithConstantOffset (&ptr, off, dl);
+    if (isa<GlobalVariable> (base)) return base;
+    if (const AllocaInst *ai = dyn_cast<const AllocaInst> (base))
+      if (ai->isStaticAlloca ()) return base;
+    return nullptr;
+  }
+
+  void UfoSmallSymExec::splitRegions (const Function &F)
+  {
+    std::map<int64_t, MemRegion> &regions = m_regions [&F];
+
+    std::set<int64_t> bad;
+    std::set<int64_t> written;
+    for (const BasicBlock &bb : F)
+      for (const Instruction &inst : bb)
+      {
+        const CallInst *ci = dyn_cast<const CallInst> (&inst);
+        if (!ci) continue;
+        const Function *fn = ci->getCalledFunction ();
+        if (!fn || !fn->getName ().startswith ("shadow.mem")) continue;
+
+        int64_t id = shadow_dsa::getShadowId (ImmutableCallSite (ci));
+        if (id < 0) continue;
+        // -- singleton regions are already scalars
+        if (extractUniqueScalar (ci)) { bad.insert (id); continue; }
+        if (fn->getName ().equals ("shadow.mem.init")) continue;
+
+        // -- the access that follows the call. Anything else (a call,
+        // -- memset, calloc, ...) keeps the region an array
+        const Value *ptr = nullptr;
+        Type *ty = nullptr;
+        const Instruction *next = ci->getNextNode ();
+        if (fn->getName ().equals ("shadow.mem.load"))
+        {
+          if (const LoadInst *li = dyn_cast_or_null<const LoadInst> (next))
+          {
+            ptr = li->getPointerOperand ();
+            ty = li->getType ();
+          }
+        }
+        else if (fn->getName ().equals ("shadow.mem.store"))
+        {
+          if (const StoreInst *si = dyn_cast_or_null<const StoreInst> (next))
+          {
+            ptr = si->getPointerOperand ();
+            ty = si->getValueOperand ()->getType ();
+            written.insert (id);
+          }
+        }
+
+        int64_t off;
+        const Value *base = ptr ? cellBase (*ptr, off, *m_td) : nullptr;
+        if (!base || !(ty->isIntegerTy () || ty->isPointerTy ()))
+        {
+          bad.insert (id);
+          continue;
+        }
+
+        MemRegion &r = regions [id];
+        unsigned sz = storageSize (ty);
+        auto it = r.cells.find (off);
+        if ((r.base && r.base != base) || (it != r.cells.end () && it->second != sz))
+          bad.insert (id);
+        r.base = base;
+        r.cells [off] = sz;
+      }
+
+    for (int64_t id : bad) regions.erase (id);
+
+    for (auto it = regions.begin (); it != regions.end (); )
+    {
+      MemRegion &r = it->second;
+
+      // -- cells must not overlap
+      bool ok = r.cells.size () <= SplitMemMaxCells;
+      int64_t end = 0;
+      for (auto &c : r.cells)
+      {
+        if (c.first < end) ok = false;
+        end = c.first + c.second;
+      }
+      if (r.cells.begin ()->first < 0) ok = false;
+      if (!ok) { it = regions.erase (it); continue; }
+
+      // -- a global that main never writes (neither do its callees,
+      // -- since the region is not passed to them) keeps its initial
+      // -- value
+      if (const GlobalVariable *gv = dyn_cast<const GlobalVariable> (r.base))
+        if (written.count (it->first) <= 0 && F.getName ().equals ("main") &&
+            gv->hasDefinitiveInitializer ())
+          r.init = gv->getInitializer ();
+
+      Stats::count ("SplitMemRegions");
+      ++it;
+    }
+  }
+
+  const UfoSmallSymExec::MemRegion *UfoSmallSymExec::splitRegion (const Value &v)
+  {
+    if (!SplitMem || m_trackLvl < MEM) return nullptr;
+
+    auto it = m_shadowRegion.find (&v);
+    if (it != m_shadowRegion.end ()) return it->second;
+
+    const MemRegion *res = nullptr;
+    const CallInst *ci = shadowDef (v);
+    if (ci)
+    {
+      const Function &F = *ci->getParent ()->getParent ();
+      if (m_regions.count (&F) <= 0) splitRegions (F);
+      std::map<int64_t, MemRegion> &regions = m_regions [&F];
+      auto r = regions.find (shadow_dsa::getShadowId (ImmutableCallSite (ci)));
+      if (r != regions.end ()) res = &r->second;
+    }
+    m_shadowRegion [&v] = res;
+    return res;
+  }
+
+  int64_t UfoSmallSymExec::cellOffset (const Value &ptr)
+  {
+    int64_t off;
+    const Value *base = cellBase (ptr, off, *m_td);
+    assert (base && "Access to a split region at an unknown offset");
+    (void)base;
+    return off;
+  }
+
+  Expr UfoSmallSymExec::cell (const Value &shadow, int64_t off)
+  {
+    // -- a constant with the name v[off]
+    Expr v = mkTerm<const Value*> (&shadow, m_efac);
+    return bind::intConst
+      (op::array::select (v, mkTerm<mpz_class> (mpz_class ((signed long) off), m_efac)));
+  }
+
+  Expr UfoSmallSymExec::cellInit (const MemRegion &r, int64_t off)
+  {
+    if (!r.init) return Expr ();
+
+    // -- descend into the initializer to the cell
+    const Constant *c = r.init;
+    unsigned sz = r.cells.at (off);
+    while (c)
+    {
+      if (c->isNullValue () && off + sz <= storageSize (c->getType ()))
+        return mkTerm<mpz_class> (0, m_efac);
+
+      Type *ty = c->getType ();
+      if (const ConstantInt *ci = dyn_cast<const ConstantInt> (c))
+      {
+        if (off != 0 || storageSize (ty) != sz) return Expr ();
+        return mkTerm<mpz_class> (toMpz (ci->getValue ()), m_efac);
+      }
+      else if (StructType *st = dyn_cast<StructType> (ty))
+      {
+        const StructLayout *sl = m_td->getStructLayout (st);
+        unsigned idx = sl->getElementContainingOffset (off);
+        off -= sl->getElementOffset (idx);
+        c = c->getAggregateElement (idx);
+      }
+      else if (SequentialType *seqt = dyn_cast<SequentialType> (ty))
+      {
+        if (!seqt->isArrayTy () && !seqt->isVectorTy ()) return Expr ();
+        uint64_t esz = m_td->getTypeAllocSize (seqt->getElementType ());
+        if (esz == 0) return Expr ();
+        unsigned idx = off / esz;
+        off -= idx * esz;
+        c = c->getAggregateElement (idx);
+      }
+      // -- e.g., the address of another global
+      else return Expr ();
+    }
+    return Expr ();
+  }
+
   Expr UfoSmallSymExec::symb (const Value &I)
   {
     if (isa<UndefValue> (&I)) return Expr(0);
@@ -1207,7 +1515,7 @@ namespace seahorn
         return bind::intConst
           (op::array::select (v, mkTerm<const Value*> (scalar, m_efac)));
 
-      if (m_trackLvl >= MEM)
+      if (m_trackLvl >= MEM && !splitRegion (I))
       {
         Expr intTy = sort::intTy (m_efac);
         Expr ty = sort::arrayTy (intTy, intTy);
@@ -1244,7 +1552,7 @@ namespace seahorn
     // -- shadow values represent memory regions
     // -- only track them when memory is tracked
     if (isShadowMem (v, &scalar))
-      return scalar != nullptr || m_trackLvl >= MEM;
+      return scalar != nullptr || (m_trackLvl >= MEM && !splitRegion (v));
 
 
     // -- a pointer
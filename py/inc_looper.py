@@ -61,6 +61,8 @@ def parseOpt (argv):
     parser.add_option ('--single', help='Check inconsistency of the whole program', action='store_true', default=False, dest="single")
     parser.add_option ('--inv', help='Get Invariants', action='store_true', default=False, dest="inv")
     parser.add_option ('--spacer_verbose', help='Spacer Verbose', action='store_true', default=False, dest="spacer_verbose")
+    parser.add_option ('--native', help='Check all functions in-process with the native checker', action='store_true', default=False, dest="native")
+    parser.add_option ('--jobs', help='Number of parallel jobs of the native checker (0 = all cores)', default=0, type=int, dest="jobs")
 
     (options, args) = parser.parse_args (argv)
     return (options, args)
@@ -170,6 +172,28 @@ def run_single(fname, opt):
     print result
     return
 
+def run_native(fname, opt):
+    """ Check inconsistency of all functions with a single seahorn process """
+    sea_cmd = getSea()
+    save_temps = ['--save-temps'] if opt.save_temps else []
+    tmp_dir = ['--temp-dir=' + opt.temp_dir] if opt.temp_dir else []
+    boa = ['--abc=2','--abc-escape-ptr','--abc-use-deref'] if opt.boa else []
+    null = ['--null-check'] if opt.null else []
+    cmd = [sea_cmd, 'smt',
+           '--horn-no-verif', '--lower-invoke', '--lower-assert'
+           , '--devirt-functions', '--step=incsmall'
+           , '--horn-one-assume-per-block'
+           , '--horn-inc-check'
+           , '--horn-inc-jobs=' + str(opt.jobs)
+           , '--horn-inc-timeout=' + str(int(opt.timeout))
+           , '--horn-inc-min-blocks=' + str(opt.num_blks)
+           , '-g', '-O0', fname] + boa + null + save_temps + tmp_dir
+    if verbose: print " ".join(cmd)
+    p = sub.Popen(cmd, shell=False, stdout=sub.PIPE, stderr=sub.STDOUT)
+    result, _ = p.communicate()
+    print result
+    return
+
 def run_one_function(function_name, fname, opt):
     """ Check inconsistency of one function """
     sea_cmd = getSea()
@@ -351,6 +375,8 @@ def main (argv):
     if opt.spacer_verbose: verbose = True
     if opt.single:
         run_single(fname, opt)
+    elif opt.native:
+        run_native(fname, opt)
     else:
         if opt.only_func is None:
             funcInfos = getFuncInfo(workdir, fname, opt)
@@ -277,6 +277,10 @@ class Seapp(sea.LimitedCmd):
                          help='Devirtualize indirect functions',
                          dest='devirt_funcs', default=False,
                          action='store_true')
+        ap.add_argument ('--devirt-functions-with-dsa',
+                         help='Devirtualize indirect functions using sea-dsa',
+                         dest='devirt_funcs_dsa', default=False,
+                         action='store_true')
         ap.add_argument ('--lower-assert',
                          help='Replace assertions with assumptions',
                          dest='lower_assert', default=False,
@@ -289,9 +293,19 @@ class Seapp(sea.LimitedCmd):
         ap.add_argument ('--slice-functions',
                          help='Slice program onto these functions',
                          dest='slice_funcs', type=str, metavar='str,...')
+        ap.add_argument ('--lazy-load',
+                         help='Load only the functions reachable from main ' +
+                         '(or from --slice-functions)',
+                         dest='lazy_load', default=False, action='store_true')
         ap.add_argument ('--internalize', help='Create dummy definitions for all ' +
                          'external functions', default=self._internalize,
                          action='store_true', dest='internalize')
+        ap.add_argument ('--pp-jobs', dest='pp_jobs', type=int, default=0,
+                         metavar='N',
+                         help='Run function-local transformations on N threads')
+        ap.add_argument ('--pp-time-passes', dest='pp_time_passes', default=False,
+                         action='store_true',
+                         help='Print the time spent in each transformation')
         ap.add_argument ('--log', dest='log', default=None,
                          metavar='STR', help='Log level')
         add_in_out_args (ap)
@@ -348,8 +362,10 @@ class Seapp(sea.LimitedCmd):
             if args.lower_invoke:
                 argv.append ('--lower-invoke')
 
-            if args.devirt_funcs:
+            if args.devirt_funcs or args.devirt_funcs_dsa:
                 argv.append ('--devirt-functions')
+            if args.devirt_funcs_dsa:
+                argv.append ('--devirt-functions-with-dsa')
 
             if args.enable_ext_funcs:
                 argv.append ('--externalize-addr-taken-funcs')
@@ -364,6 +380,12 @@ class Seapp(sea.LimitedCmd):
                 for f in args.slice_funcs.split(','):
                     argv.append ('--slice-function={0}'.format(f))
 
+            if args.lazy_load:
+                argv.append ('--lazy-load')
+                if args.slice_funcs:
+                    for f in args.slice_funcs.split(','):
+                        argv.append ('--lazy-entry={0}'.format(f))
+
             if args.enum_verifier_calls:
                 argv.append ('--enum-verifier-calls')
 
@@ -375,9 +397,17 @@ class Seapp(sea.LimitedCmd):
             else:
                 argv.append('--kill-vaarg=false')
 
+            if args.pp_jobs > 0:
+                argv.append ('--pp-jobs={0}'.format (args.pp_jobs))
+            if args.pp_time_passes:
+                argv.append ('--pp-time-passes')
+
         if args.log is not None:
             for l in args.log.split (':'): argv.extend (['-log', l])
 
+        # -- the budget of the pp phase is enforced by seapp itself
+        argv.extend (filter (_is_budget_opt, extra))
+
         argv.extend (args.in_files)
         return self.seappCmd.run (args, argv)
 
@@ -897,11 +927,15 @@ class Unroll(sea.LimitedCmd):
         if args.llvm_asm: argv.append ('-S')
         return self.seaoptCmd.run (args, argv)
 
+def _is_budget_opt (x):
+    return x.startswith ('-') and x.strip ('-').startswith ('sea-budget')
+
 def _is_seahorn_opt (x):
     if x.startswith ('-'):
         y = x.strip ('-')
         return y.startswith ('horn') or \
-            y.startswith ('crab') or y.startswith ('log')
+            y.startswith ('crab') or y.startswith ('log') or \
+            y.startswith ('sea-budget')
     return False
 
 class Seahorn(sea.LimitedCmd):
@@ -962,6 +996,9 @@ class Seahorn(sea.LimitedCmd):
         ap.add_argument ('--bmc',
                          help='Use BMC engine',
                          dest='bmc', default=False, action='store_true')
+        ap.add_argument ('--kind',
+                         help='Use BMC and k-induction engine',
+                         dest='kind', default=False, action='store_true')
         ap.add_argument ('--max-depth',
                          help='Maximum depth of exploration',
                          dest='max_depth', default=sys.maxint)
@@ -980,6 +1017,9 @@ class Seahorn(sea.LimitedCmd):
         if args.bmc:
             argv.append ('--horn-bmc')
 
+        if args.kind:
+            argv.append ('--horn-kind')
+
         if args.crab:
             argv.append ('--horn-crab')
 
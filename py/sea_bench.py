@@ -0,0 +1,203 @@
+#!/usr/bin/env python
+"""
+End-to-end and micro benchmarks with a stored baseline.
+
+Every test program (a .c file whose RUN line is a `%sea pf` command) is
+verified with its own options and --horn-stats. The per-phase wall
+times and peak RSS reported by the ResourceGovernor are recorded
+together with the answer. The front end is everything outside of
+hornify, solve and cex. Results of the microbenchmarks (units_bench)
+are recorded as well.
+
+The results are compared with a baseline. A metric that is slower (or
+bigger) than its baseline by more than the threshold, and by more than
+a small absolute amount, is a regression, and so is a changed answer.
+The exit code is 1 if there is any regression.
+"""
+
+import argparse
+import fcntl
+import json
+import os
+import re
+import select
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+# -- below these, differences are noise. A microbenchmark iteration
+# -- is short, so a few ns are within the jitter of the timer
+MIN_DELTA = {'WallMs': 100.0, 'PeakRssMb': 16.0, 'ns': 20.0}
+
+
+def parse_brunch (out):
+    stats = {}
+    for line in out.splitlines ():
+        if not line.startswith ('BRUNCH_STAT '): continue
+        parts = line.split ()
+        if len (parts) < 3: continue
+        stats [parts [1]] = parts [2]
+    return stats
+
+
+def run_cmd (argv, timeout):
+    """ Runs argv. Returns (output, wall seconds, peak rss in MB, killed) """
+    start = time.time ()
+    p = subprocess.Popen (argv, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                          preexec_fn=os.setsid)
+    out = []
+    killed = False
+    fd = p.stdout.fileno ()
+    fl = fcntl.fcntl (fd, fcntl.F_GETFL)
+    fcntl.fcntl (fd, fcntl.F_SETFL, fl | os.O_NONBLOCK)
+    while True:
+        r, _, _ = select.select ([fd], [], [], 0.5)
+        if r:
+            chunk = os.read (fd, 65536)
+            if not chunk: break
+            out.append (chunk)
+        if timeout and time.time () - start > timeout and not killed:
+            os.killpg (p.pid, 9)
+            killed = True
+    # -- unlike Popen.wait, wait4 gives the peak RSS, which includes
+    # -- the children of the child
+    _, status, ru = os.wait4 (p.pid, 0)
+    p.returncode = status
+    wall = time.time () - start
+    return (b''.join (out).decode ('utf-8', 'replace'), wall,
+            ru.ru_maxrss / 1024.0, killed)
+
+
+def sea_command (path, tmp):
+    """ Options of the `%sea pf` RUN line of a test, or None. As in
+        lit, %t is a path for temporary files, here prefixed by tmp """
+    with open (path) as f:
+        for line in f:
+            m = re.match (r'\s*//\s*RUN:\s*%sea\s+pf\s+(.*?)(\||$)', line)
+            if not m: continue
+            args = [a for a in shlex.split (m.group (1)) if a != '%s']
+            return [a.replace ('%t', tmp) for a in args if a not in ('2>&1',)]
+    return None
+
+
+def bench_program (sea, path, timeout):
+    tmpdir = tempfile.mkdtemp (prefix='sea_bench.')
+    try:
+        tmp = os.path.join (tmpdir, os.path.basename (path) + '.tmp')
+        opts = sea_command (path, tmp)
+        if opts is None: return None
+        out, wall, rss, killed = run_cmd ([sea, 'pf'] + opts +
+                                          ['--horn-stats', path], timeout)
+    finally:
+        shutil.rmtree (tmpdir, ignore_errors=True)
+
+    res = {'Result': 'TIMEOUT' if killed else 'UNKNOWN'}
+    for line in out.splitlines ():
+        if line.strip () in ('sat', 'unsat', 'unknown'):
+            res ['Result'] = line.strip ()
+    stats = parse_brunch (out)
+
+    total = wall * 1000.0
+    horn = 0.0
+    for phase in ('hornify', 'solve', 'cex'):
+        key = phase + '.WallMs'
+        if key in stats:
+            res [key] = float (stats [key])
+            horn += res [key]
+    res ['frontend.WallMs'] = max (total - horn, 0.0)
+    res ['total.WallMs'] = total
+    res ['PeakRssMb'] = rss
+    return res
+
+
+def bench_micro (micro, flt):
+    argv = [micro]
+    if flt: argv.append (flt)
+    out, _, _, _ = run_cmd (argv, 0)
+    res = {}
+    for k, v in parse_brunch (out).items ():
+        res [k] = float (v)
+    return res
+
+
+def compare (name, cur, base, threshold):
+    """ Returns the regressions of cur over base """
+    regs = []
+    if 'Result' in base and cur.get ('Result') != base ['Result']:
+        regs.append ('{0}: answer {1} (was {2})'.format (name, cur.get ('Result'),
+                                                        base ['Result']))
+    for k, v in sorted (cur.items ()):
+        if k == 'Result' or k not in base: continue
+        b = base [k]
+        unit = k.split ('.') [-1]
+        if v > b * (1.0 + threshold) and v - b > MIN_DELTA.get (unit, 0.0):
+            regs.append ('{0}: {1} {2:.1f} (was {3:.1f}, +{4:.0f}%)'.format (
+                name, k, v, b, 100.0 * (v - b) / b if b > 0 else 100.0))
+    return regs
+
+
+def main (argv):
+    ap = argparse.ArgumentParser (description=__doc__.strip ().split ('\n') [0])
+    ap.add_argument ('dirs', nargs='*', help='Directories of test programs')
+    ap.add_argument ('--sea', default='sea', help='sea executable')
+    ap.add_argument ('--micro', default=None, help='units_bench executable')
+    ap.add_argument ('--micro-filter', default=None,
+                     help='Only run microbenchmarks whose name contains this')
+    ap.add_argument ('--baseline', default=None, help='Baseline (JSON)')
+    ap.add_argument ('--save', default=None,
+                     help='Write the results (JSON). Use the baseline file to update it')
+    ap.add_argument ('--threshold', type=float, default=0.2,
+                     help='Relative increase reported as a regression')
+    ap.add_argument ('--timeout', type=int, default=300,
+                     help='Timeout of every program in seconds')
+    args = ap.parse_args (argv)
+
+    results = {'programs': {}, 'micro': {}}
+    for d in args.dirs:
+        for fname in sorted (os.listdir (d)):
+            if not fname.endswith ('.c'): continue
+            path = os.path.join (d, fname)
+            res = bench_program (args.sea, path, args.timeout)
+            if res is None: continue
+            name = os.path.join (os.path.basename (os.path.normpath (d)), fname)
+            results ['programs'] [name] = res
+            print ('{0:40} {1:8} {2:10.0f} ms {3:8.1f} MB'.format (
+                name, res ['Result'], res ['total.WallMs'], res ['PeakRssMb']))
+            sys.stdout.flush ()
+
+    if args.micro:
+        results ['micro'] = bench_micro (args.micro, args.micro_filter)
+        for k, v in sorted (results ['micro'].items ()):
+            print ('{0:40} {1:12.1f} ns'.format (k, v))
+
+    regs = []
+    if args.baseline and os.path.exists (args.baseline):
+        with open (args.baseline) as f:
+            base = json.load (f)
+        for name, res in sorted (results ['programs'].items ()):
+            if name in base.get ('programs', {}):
+                regs += compare (name, res, base ['programs'] [name], args.threshold)
+        regs += compare ('micro', results ['micro'], base.get ('micro', {}),
+                         args.threshold)
+    elif args.baseline:
+        print ('No baseline at {0}. Saving these results as the baseline'.format (
+            args.baseline))
+        args.save = args.save or args.baseline
+
+    if args.save:
+        with open (args.save, 'w') as f:
+            json.dump (results, f, indent=2, sort_keys=True)
+
+    if regs:
+        print ('\nREGRESSIONS:')
+        for r in regs: print ('  ' + r)
+        return 1
+    print ('\nNo regressions')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit (main (sys.argv [1:]))
@@ -98,6 +98,110 @@ def initProfiles():
 
 profiles = initProfiles ()
 
+## Stages of a command as (sea sub-command, fixed arguments). Profiles
+## of a command share the stages up to the first one whose options
+## differ. Other commands are run as a whole
+pipelines = {'pf': [('clang', []), ('pp', []), ('ms', []), ('opt', []),
+                    ('horn', ['--solve'])]}
+
+## Options that a stage does not parse but passes on
+forwarded = {'clang': lambda x: x.startswith ('-D'),
+             'horn': lambda x: True}
+
+def getSeaCommands ():
+    """ The sea.commands module, or None """
+    path = os.path.join (root, 'lib', 'seapy')
+    if path not in sys.path: sys.path.insert (0, path)
+    try:
+        import sea.commands
+        return sea.commands
+    except ImportError:
+        return None
+
+def stageKey (stage, opts):
+    """ Everything the output of a stage depends on besides its input """
+    import argparse
+    name, fixed = stage
+    cmds = getSeaCommands ()
+    if cmds is None: return (name, tuple (fixed + opts))
+
+    stage_cmds = {'clang': cmds.Clang, 'pp': cmds.Seapp, 'ms': cmds.MixedSem,
+                  'opt': cmds.Seaopt, 'horn': cmds.Seahorn}
+    ap = argparse.ArgumentParser (add_help=False)
+    ap = stage_cmds [name] ().mk_arg_parser (ap)
+    args, extra = ap.parse_known_args (fixed + opts + ['-o', 'out', 'in'])
+    vals = dict (vars (args))
+    del vals ['in_files']
+    del vals ['out_file']
+    fwd = forwarded.get (name, lambda x: False)
+    return (name, repr (sorted (vals.items ())), tuple (filter (fwd, extra)))
+
+class Stage (object):
+    """ A sea sub-command run once for all the profiles that share it """
+    def __init__ (self, key, argv, parent=None):
+        self.key = key
+        self.argv = argv
+        self.parent = parent
+        self.children = list ()
+        self.profs = list ()
+        self.input = None
+        self.out = None
+        self.stdout = None
+        self.stderr = None
+
+    def path (self):
+        """ Stages from the root down to this one """
+        res = list ()
+        s = self
+        while s is not None:
+            res.append (s)
+            s = s.parent
+        res.reverse ()
+        return res
+
+def buildStages (workdir, fname, sea_cmd, base_args, profs, cex_base, share):
+    """ Builds the forest of stages of the profiles. Returns the roots
+    and the leaf of every profile """
+    name = os.path.splitext (os.path.basename (fname))[0]
+    roots = list ()
+    leaves = dict ()
+    count = itertools.count ()
+
+    for prof in profs:
+        cmd = profiles [prof][0]
+        opts = base_args + profiles [prof][1:]
+        if cex_base is not None:
+            opts = opts + ['--cex={0}.{1}.trace'.format (cex_base, prof)]
+
+        if share and cmd in pipelines:
+            stages = [(stageKey (st, opts), [sea_cmd, st [0]] + st [1] + opts)
+                      for st in pipelines [cmd]]
+        else:
+            stages = [((cmd, tuple (opts), prof), [sea_cmd] + base_args + profiles [prof])]
+            if cex_base is not None:
+                stages [0][1].append ('--cex={0}.{1}.trace'.format (cex_base, prof))
+
+        parent = None
+        siblings = roots
+        for key, argv in stages:
+            node = None
+            for s in siblings:
+                if s.key == key: node = s
+            if node is None:
+                node = Stage (key, argv, parent)
+                n = next (count)
+                node.stdout = os.path.join (workdir, name + '_seahorn{0}.stdout'.format (n))
+                node.stderr = os.path.join (workdir, name + '_seahorn{0}.stderr'.format (n))
+                node.out = os.path.join (workdir, name + '.s{0}.bc'.format (n))
+                node.input = fname if parent is None else parent.out
+                siblings.append (node)
+            node.profs.append (prof)
+            parent = node
+            siblings = node.children
+        leaves [prof] = parent
+
+    return (roots, leaves)
+
 def listProfiles ():
     for (k, v) in profiles.iteritems ():
         print k, ':', ' '.join (v)
@@ -134,6 +238,9 @@ def parseOpt (argv):
     parser.add_option ('--spec', default=None, help='Property file')
     parser.add_option ('--version', default=None, action='store_true')
     parser.add_option ('--no-line-pragma', default=False, dest='line_pragma', action='store_true')
+    parser.add_option ('--no-share', default=True, dest='share', action='store_false',
+                       help='Run every profile from scratch instead of sharing '
+                       'the stages that profiles have in common')
 
     (options, args) = parser.parse_args (argv)
 
@@ -208,7 +315,7 @@ def getAnswer(out_file):
 
 
 def run (workdir, fname, sea_args = [], profs = [],
-         cex = None, arch=32, cpu=-1, mem=-1):
+         cex = None, arch=32, cpu=-1, mem=-1, share=True):
 
     print "BRUNCH_STAT Result UNKNOWN"
     sys.stdout.flush ()
@@ -217,59 +324,56 @@ def run (workdir, fname, sea_args = [], profs = [],
 
     if cex is None: cex = fname + '.xml' # forcing a cex output
 
-    base_args = [sea_cmd, '--mem={0}'.format(mem),
-                 '-m{0}'.format (arch)]
+    base_args = ['--mem={0}'.format(mem), '-m{0}'.format (arch)]
     if arch == 64:
         base_args.append ('--horn-svcomp-cex-arch=64bit')
     base_args.extend (sea_args)
 
+    cex_base = None
     if cex is not None:
         cex_base = os.path.basename (fname)
         cex_base = os.path.splitext (cex_base)[0]
         cex_base = os.path.join (workdir, cex_base)
 
+    (roots, leaves) = buildStages (workdir, fname, sea_cmd, base_args, profs,
+                                   cex_base, share)
 
-    conf_name = list ()
-    sea = list ()
-
-    for prof in profs:
-        conf_name.append (prof)
-        p_args = base_args + profiles [prof]
-        if cex is not None:
-            cex_name = '{0}.{1}.trace'.format (cex_base, prof)
-            p_args.append ('--cex={0}'.format (cex_name))
-        sea.append (p_args)
-
-    name = os.path.splitext (os.path.basename (fname))[0]
-    stdout = [os.path.join (workdir, name + '_seahorn{0}.stdout'.format (i))
-              for i in range(len (sea))]
-    stderr = [os.path.join (workdir, name + '_seahorn{0}.stderr'.format (i))
-              for i in range (len (sea))]
     global running
-    running.extend ([runSeahorn (sea [i], fname, stdout[i], stderr [i])
-                     for i in range (len (sea))])
+    stages = dict ()
+    def launch (st):
+        # -- the last stage of a pipeline names its own output
+        argv = st.argv if len (st.children) == 0 else st.argv + ['-o', st.out]
+        p = runSeahorn (argv, st.input, st.stdout, st.stderr)
+        running.append (p)
+        stages [p.pid] = st
 
+    for st in roots: launch (st)
 
-    orig_pids = [p.pid for p in running]
-    pids = [p.pid for p in running ]
+    winner = None
     pid = -1
     returnvalue = -1
-    while len (pids) != 0:
-        print 'Running: ', pids
+    while len (stages) != 0:
+        print 'Running: ', stages.keys ()
 
         (pid, returnvalue, ru_child) = os.wait4 (-1, 0)
 
         print 'Finished pid {0} with'.format (pid),
         print ' code {0} and signal {1}'.format((returnvalue // 256),
                                                 (returnvalue % 256))
-        pids.remove (pid)
-        idx = orig_pids.index (pid)
-        out_f = stdout[idx]
+        st = stages.pop (pid, None)
+        if st is None: continue
+
+        # a shared stage hands its output to the stages that follow
+        if len (st.children) > 0:
+            if returnvalue == 0:
+                for c in st.children: launch (c)
+            continue
 
         # if a process terminated successfully and produced True/False
         # answer kill all other processes
-        if returnvalue == 0 and getAnswer (out_f) is not None:
-            for p in pids:
+        if returnvalue == 0 and getAnswer (st.stdout) is not None:
+            winner = st
+            for p in stages.keys ():
                 try:
                     os.kill (p, signal.SIGTERM)
                 except OSError: pass
@@ -279,30 +383,33 @@ def run (workdir, fname, sea_args = [], profs = [],
                     except OSError: pass
             break
 
-    if returnvalue == 0 and getAnswer(out_f) is not None:
-        cat (open (out_f), sys.stdout)
-        cat (open (stderr[idx]), sys.stderr)
+    if winner is not None:
+        prof = winner.profs [0]
+        for s in winner.path ():
+            cat (open (s.stdout), sys.stdout)
+            cat (open (s.stderr), sys.stderr)
         if cex is not None:
-            cex_name = '{0}.{1}.trace'.format (cex_base, conf_name [idx])
+            cex_name = '{0}.{1}.trace'.format (cex_base, prof)
             if os.path.isfile (cex_name):
                 print 'Copying {0} to {1}'.format (cex_name, cex)
                 shutil.copy2 (cex_name, cex)
                 print 'Counterexample trace is in {0}'.format (cex)
 
 
-        print 'WINNER: ', ' '.join (sea [idx])
-        print 'BRUNCH_STAT config {0}'.format (idx)
-        print 'BRUNCH_STAT config_name {0}'.format (conf_name [idx])
+        print 'WINNER: ', ' '.join (winner.argv)
+        print 'BRUNCH_STAT config {0}'.format (profs.index (prof))
+        print 'BRUNCH_STAT config_name {0}'.format (prof)
 
     else:
         # print failed logs if we do not have a good one
         # useful for debugging
-        for idx, cname, std, err in zip (itertools.count (), conf_name, stdout, stderr):
+        for cname in profs:
+            logs = [s for s in leaves [cname].path () if os.path.isfile (s.stdout)]
             print >> sys.stdout, 'LOG BEGIN', cname
-            cat (open (std), sys.stdout)
+            for s in logs: cat (open (s.stdout), sys.stdout)
             print >> sys.stdout, 'LOG END', cname
             print >> sys.stderr, 'LOG BEGIN', cname
-            cat (open (err), sys.stderr)
+            for s in logs: cat (open (s.stderr), sys.stderr)
             print >> sys.stderr, 'LOG END', cname
         print "ALL INSTANCES FAILED"
         print 'Calling sys.exit with {0}'.format (returnvalue // 256)
@@ -349,7 +456,7 @@ def main (argv):
                 print "HERE"
                 fname = strain.removeLinePragma(workdir, fname)
             returnvalue = run (workdir, fname, seahorn_args, opt.profiles.split (':'),
-                               opt.cex, opt.arch, opt.cpu, opt.mem)
+                               opt.cex, opt.arch, opt.cpu, opt.mem, opt.share)
         else:
             print "BRUNCH_STAT Result UNKNOWN"
     return returnvalue
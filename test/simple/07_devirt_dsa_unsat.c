@@ -0,0 +1,21 @@
+// RUN: %sea pf --devirt-functions-with-dsa "%s"  2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+
+#include "seahorn/seahorn.h"
+extern int nd();
+
+// -- same signature, but never called through fp
+int h(int x) { return x - 10; }
+int (*volatile handler)(int);
+
+int f(int x) { return x + 1; }
+int g(int x) { return x + 2; }
+
+int main()
+{
+  handler = h;
+  int (*fp)(int) = nd() ? f : g;
+  int r = fp(1);
+  sassert(r >= 2);
+  return 0;
+}
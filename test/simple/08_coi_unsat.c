@@ -0,0 +1,24 @@
+// RUN: %sea pf --horn-coi "%s"  2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+
+#include "seahorn/seahorn.h"
+extern int nd();
+
+int a[10];
+int b[10];
+
+int main()
+{
+  int i, x = 0, s = 0;
+  // -- irrelevant to the property
+  for (i = 0; i < 10; i++) {
+    b[i] = nd();
+    s += b[i];
+  }
+  // -- relevant
+  for (i = 0; i < 10; i++) a[i] = i;
+  if (nd()) x = a[3];
+  else x = a[5];
+  sassert(x >= 3);
+  return s;
+}
@@ -0,0 +1,22 @@
+// RUN: %sea pf --pp-jobs=2 "%s"  2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+
+#include "seahorn/seahorn.h"
+extern int nd();
+
+static int g;
+
+__attribute__((noinline)) int inc(int x) { g++; return x + 1; }
+__attribute__((noinline)) int dec(int x) { g--; return x - 1; }
+
+int main()
+{
+  int x = 0, n = nd();
+  g = 0;
+  while (n-- > 0) {
+    x = inc(x);
+    x = dec(x);
+  }
+  sassert(x == 0 && g == 0);
+  return 0;
+}
@@ -0,0 +1,23 @@
+// RUN: %sea pf --horn-split-mem "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+struct counter { int lo; int hi; };
+
+struct counter c;
+// -- read-only, folded into its initial values
+const int limits[2] = {10, 20};
+
+int main()
+{
+  c.lo = 0;
+  c.hi = 0;
+  while (nd ()) {
+    if (c.lo < limits[0]) c.lo++;
+    else if (c.hi < limits[1]) c.hi++;
+  }
+  sassert(c.lo <= 10 && c.hi <= 20);
+  return 0;
+}
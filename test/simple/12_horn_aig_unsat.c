@@ -0,0 +1,21 @@
+// RUN: %sea pf -O0 --horn-aig --horn-aig-jobs=2 --horn-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+// CHECK: ^BRUNCH_STAT HornAigRules [1-9][0-9]*$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+// -- -O0 so that seaopt does not fold the redundant condition before
+// -- the rules are built
+int main()
+{
+  int x = 0, y = 0;
+  while (nd ()) {
+    int a = nd (), b = nd ();
+    // -- the same condition, written twice
+    if ((a > 0 && b > 0) || (a > 0 && !(b > 0))) x++;
+    if (a > 0) y++;
+  }
+  sassert(x == y);
+  return 0;
+}
@@ -0,0 +1,24 @@
+// RUN: %sea pf --horn-elim-args --horn-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+// CHECK: ^BRUNCH_STAT HornElimArgs [1-9][0-9]*$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+extern void use(int);
+
+int main()
+{
+  // -- t is live at the loop head, so it survives opt as an argument
+  // -- of the loop predicate. Its only use is a call to an external
+  // -- function, which the encoding does not constrain, so the
+  // -- argument is dead at the Horn level
+  int t = nd ();
+  int i = 0;
+  while (nd ())
+  {
+    if (i < 100) i += 3;
+    use (t);
+  }
+  sassert(i <= 102);
+  return 0;
+}
@@ -0,0 +1,18 @@
+// RUN: %sea pf --horn-slice --horn-inline --horn-stats --horn-answer "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+// CHECK: ^BRUNCH_STAT HornInlinedRels [1-9][0-9]*$
+// CHECK: ^BRUNCH_STAT HornSliceRels [1-9][0-9]*$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  int x = nd ();
+  if (x < 0) x = -x;
+  // -- straight-line blocks with one predecessor are inlined
+  int y = x + 1;
+  while (nd ()) y++;
+  sassert(y > 0);
+  return 0;
+}
@@ -0,0 +1,18 @@
+// RUN: %sea pf --horn-houdini --horn-houdini-templates --horn-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+// CHECK: ^BRUNCH_STAT HornTemplateCands [1-9][0-9]*$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- x >= 0 and x - y <= 0 are template candidates
+  int x = 0, y = 0;
+  while (nd ()) {
+    x++;
+    y += 2;
+  }
+  sassert(x <= y);
+  return 0;
+}
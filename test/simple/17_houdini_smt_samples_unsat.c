@@ -0,0 +1,16 @@
+// RUN: %sea pf --horn-houdini --horn-houdini-templates --horn-houdini-simulate=false "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- states come from SMT queries instead of simulation
+  int n = nd ();
+  assume (n >= 0 && n <= 10);
+  int i = 0;
+  while (i < n) i++;
+  sassert(i >= 0);
+  return 0;
+}
@@ -0,0 +1,20 @@
+// RUN: %sea pf --horn-dump-db=%t.hdb --horn-stats "%s" 2>&1 | OutputCheck %s
+// RUN: %sea pf --horn-resume-db=%t.hdb --horn-stats "%s" 2>&1 | OutputCheck %s
+// CHECK-NOT: WARNING
+// CHECK: ^unsat$
+// CHECK: ^BRUNCH_STAT HornClauseDBNodes [1-9][0-9]*$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- the second run solves the clauses written by the first one. A
+  // -- rejected file falls back to hornifying with a WARNING
+  int n = nd ();
+  assume (n >= 0 && n <= 10);
+  int i = 0, s = 0;
+  while (i < n) { i++; s += 2; }
+  sassert(s == 2 * i);
+  return 0;
+}
@@ -0,0 +1,21 @@
+// RUN: %sea pf --kind "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- not 1-inductive, but 2-inductive: the assertion held in the
+  // -- previous iteration
+  int x = 0, y = 0;
+  while (nd ())
+  {
+    int d = nd ();
+    assume (d >= 0 && d <= 1);
+    x += d;
+    y += 2 * d;
+    sassert (y == 2 * x);
+  }
+  return 0;
+}
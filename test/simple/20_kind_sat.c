@@ -0,0 +1,16 @@
+// RUN: %sea pf --kind "%s" 2>&1 | OutputCheck %s
+// CHECK: ^sat$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  int x = 0;
+  while (nd ())
+  {
+    x++;
+    sassert (x < 5);
+  }
+  return 0;
+}
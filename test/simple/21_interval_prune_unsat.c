@@ -0,0 +1,25 @@
+// RUN: %sea pf --horn-interval-prune --horn-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+// CHECK: ^BRUNCH_STAT IntervalPruneConstraints [1-9][0-9]*$
+// CHECK: ^BRUNCH_STAT IntervalPruneRelations [1-9][0-9]*$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  int x = 0;
+  while (nd ())
+  {
+    if (x < 10) x++;
+    // -- the call keeps the branch, so opt cannot turn it into a select
+    else { x = 0; nd (); }
+  }
+  // -- x is in [0, 10] after the loop. Opt does not bound a variable
+  // -- that is updated conditionally, so this loop survives until
+  // -- hornification, and its head is a dead cut-point
+  if (x > 10)
+    while (nd ()) x++;
+  sassert(x <= 10);
+  return 0;
+}
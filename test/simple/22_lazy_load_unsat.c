@@ -0,0 +1,21 @@
+// RUN: %sea pf --lazy-load --log=lazy-load "%s" 2>&1 | OutputCheck %s
+// CHECK: ^lazy-load: dropped body of unreachable$
+// CHECK: ^unsat$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+// -- not called from main, so its body is never materialized
+int unreachable (int x)
+{
+  return x + 2;
+}
+
+int main()
+{
+  int x = nd ();
+  assume (x > 0);
+  int y = x + 1;
+  sassert(y > 1);
+  return 0;
+}
@@ -0,0 +1,18 @@
+// RUN: %sea pf --cex=%t.ll --bv-cex --horn-cex-replay --horn-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^sat$
+// CHECK: ^BRUNCH_STAT CexReplay REACHED$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- with --bv-cex the integer trace is replayed first and, once it
+  // -- reaches the error, is used without bit-precise validation
+  int x = nd ();
+  assume (x > 5 && x < 10);
+  int y = nd ();
+  assume (y > x);
+  sassert(y != x + 1);
+  return 0;
+}
@@ -0,0 +1,23 @@
+// RUN: %sea pf --devirt-functions-with-dsa "%s"  2>&1 | OutputCheck %s
+// CHECK: ^sat$
+
+#include "seahorn/seahorn.h"
+extern int nd();
+
+// -- external code that can store g and hand it back
+extern void register_handler(int (*)(int));
+extern int (*lookup_handler(void))(int);
+
+int f(int x) { return x + 1; }
+int g(int x) { return x - 10; }
+
+int main()
+{
+  register_handler(g);
+  // -- the points-to set of fp only has f, but the external call can
+  // -- return g
+  int (*fp)(int) = nd() ? f : lookup_handler();
+  int r = fp(1);
+  sassert(r >= 2);
+  return 0;
+}
@@ -0,0 +1,20 @@
+// RUN: %sea fe "%s" -o %t.bc
+// RUN: %python %S/server_client.py %seahorn %t.bc --horn-solve -horn-inter-proc -horn-sem-lvl=mem --horn-step=large 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+// CHECK: ^SEAHORN_EXIT 0$
+// CHECK: ^unsat$
+// CHECK: ^SEAHORN_EXIT 0$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- the second request gets the reply of the first one
+  int n = nd ();
+  assume (n >= 0 && n <= 10);
+  int i = 0, s = 0;
+  while (i < n) { i++; s += 2; }
+  sassert(s == 2 * i);
+  return 0;
+}
@@ -0,0 +1,18 @@
+// RUN: %sea smt --step=incsmall --horn-inc-check --horn-no-verif "%s" -o %t.smt2 2>&1 | OutputCheck %s
+// CHECK: SEAHORN INCONSISTENCY CHECKS
+// CHECK: FUNCTION NAME: main
+// CHECK: RESULT: FEASIBLE
+// CHECK: ANALYSIS TIME: [0-9]+\.[0-9]+
+
+extern int nd(void);
+
+int main()
+{
+  // -- every block is on some path. No assertion, so that no block
+  // -- ends in an error
+  int x = nd ();
+  int y = 0;
+  if (x > 0) y = x;
+  else y = -x;
+  return y;
+}
@@ -0,0 +1,20 @@
+// RUN: %sea pf --horn-houdini --horn-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+// CHECK: ^BRUNCH_STAT HornSamplerStates [1-9][0-9]*$
+// CHECK: ^BRUNCH_STAT HoudiniCandsRefuted [1-9][0-9]*$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- by default states come from simulation. The candidates i < n
+  // -- and n < i of the loop head are refuted by its first and last
+  // -- states
+  int n = nd ();
+  assume (n >= 1 && n <= 10);
+  int i = 0;
+  while (i < n) i++;
+  sassert(i == n);
+  return 0;
+}
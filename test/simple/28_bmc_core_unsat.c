@@ -0,0 +1,22 @@
+// RUN: %sea pf --bmc --log=bmc --horn-bmc-core-timeout=60 --horn-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+// CHECK: ^CORE BEGIN$
+// CHECK: ^CORE END$
+// CHECK: ^BRUNCH_STAT BmcCoreEdgeChecks [1-9][0-9]*$
+// CHECK: ^BRUNCH_STAT BmcCoreSize [1-9][0-9]*$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- with -log=bmc the core of the unsat path is minimized
+  int x = nd ();
+  int y = nd ();
+  int z = nd ();
+  assume (x > 0);
+  assume (y > x);
+  assume (z != y);
+  sassert(y > 1);
+  return 0;
+}
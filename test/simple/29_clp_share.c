@@ -0,0 +1,19 @@
+// RUN: %sea clp "%s" -o %t.pl
+// RUN: cat %t.pl | OutputCheck %s
+// CHECK: ^aux__0\(.*\) :- .*\.$
+// CHECK: aux__0\(
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- both selects test the disjunction c, which is printed once as
+  // -- an auxiliary predicate
+  int a = nd (), b = nd ();
+  int c = (a > 0) | (b > 0);
+  int x = c ? a : b;
+  int y = c ? b : a;
+  sassert(x != y + nd ());
+  return 0;
+}
@@ -0,0 +1,18 @@
+// RUN: %sea pf --sea-budget=hornify:0:1 "%s" 2>&1 | OutputCheck %s
+// CHECK: ^WARNING: hornify exceeded its budget$
+// CHECK: ^BRUNCH_STAT hornify.Budget EXCEEDED$
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- any process is over a budget of 1MB, so hornify is reported
+  // -- over budget and the stats are printed without --horn-stats
+  int n = nd ();
+  assume (n >= 0 && n <= 10);
+  int i = 0;
+  while (i < n) i++;
+  sassert(i == n);
+  return 0;
+}
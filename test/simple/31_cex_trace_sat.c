@@ -0,0 +1,18 @@
+// RUN: %sea pf --cex=%t.ll --log=cex "%s" 2>&1 | OutputCheck %s
+// CHECK: ^sat$
+// CHECK: ^  %[^ ]+ 42(\s|$)
+// CHECK: ^  %[^ ]+ 43(\s|$)
+
+#include "seahorn/seahorn.h"
+extern int nd(void);
+
+int main()
+{
+  // -- the values of the whole trace are evaluated in one batch
+  int x = nd ();
+  assume (x == 42);
+  int y = nd ();
+  assume (y == x + 1);
+  sassert(y != 43);
+  return 0;
+}
@@ -0,0 +1,41 @@
+# Starts seahorn --server, sends it the same file twice and prints the
+# replies. Usage: server_client.py <seahorn> <bitcode> [seahorn options]
+import os
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+def request (path, line):
+    s = socket.socket (socket.AF_UNIX, socket.SOCK_STREAM)
+    s.connect (path)
+    s.sendall ((line + '\n').encode ())
+    reply = b''
+    while True:
+        data = s.recv (4096)
+        if not data: break
+        reply += data
+    s.close ()
+    return reply.decode ()
+
+def main (argv):
+    seahorn, bc = argv[1], os.path.abspath (argv[2])
+    tmp = tempfile.mkdtemp ()
+    path = os.path.join (tmp, 'sock')
+    server = subprocess.Popen ([seahorn, '--server=' + path] + argv[3:])
+    try:
+        for _ in range (600):
+            if os.path.exists (path): break
+            time.sleep (0.1)
+        sys.stdout.write (request (path, bc))
+        sys.stdout.write (request (path, bc))
+        request (path, 'quit')
+        return server.wait ()
+    finally:
+        if server.poll () is None: server.kill ()
+        shutil.rmtree (tmp, ignore_errors=True)
+
+if __name__ == '__main__':
+    sys.exit (main (sys.argv))
@@ -0,0 +1,23 @@
+// RUN: %sea smt --horn-term "%s" 2>&1 | OutputCheck %s
+// CHECK: RESULT: TERMINATES
+
+// The loop needs a lexicographic ranking function (x, y)
+
+extern int nd (void);
+
+int main (void)
+{
+  int x = nd ();
+  int y = nd ();
+  while (x > 0 && y > 0)
+  {
+    if (nd ())
+    {
+      x--;
+      y = nd ();
+    }
+    else
+      y--;
+  }
+  return x + y;
+}
@@ -19,6 +19,9 @@
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Transforms/IPO.h"
 
 #include "seahorn/config.h"
@@ -29,10 +32,14 @@
 #include "seahorn/Houdini.hh"
 #include "seahorn/PredicateAbstraction.hh"
 #include "seahorn/HornCex.hh"
+#include "seahorn/IncChecker.hh"
+#include "seahorn/TerminationChecker.hh"
 #include "seahorn/Transforms/Scalar/PromoteVerifierCalls.hh"
 #include "seahorn/Transforms/Scalar/LowerGvInitializers.hh"
 #include "seahorn/Transforms/Scalar/LowerCstExpr.hh"
 #include "seahorn/Transforms/Utils/RemoveUnreachableBlocksPass.hh"
+#include "seahorn/Support/ResourceGovernor.hh"
+#include "seahorn/Support/LazyLoad.hh"
 
 #include "sea_dsa/DsaAnalysis.hh"
 
@@ -45,6 +52,15 @@
 #include "ufo/Passes/NameValues.hpp"
 #include "ufo/Stats.hh"
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 void print_seahorn_version()
 {
   llvm::outs () << "SeaHorn (http://seahorn.github.io/):\n"
@@ -87,7 +103,13 @@ VerboseOption ("zverbose",
 
 static llvm::cl::opt<std::string>
 InputFilename(llvm::cl::Positional, llvm::cl::desc("<input LLVM bitcode file>"),
-              llvm::cl::Required, llvm::cl::value_desc("filename"));
+              llvm::cl::init(""), llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string>
+ServerSocket("server",
+             llvm::cl::desc("Serve verification requests on a local socket. "
+                            "Unchanged files are not verified again"),
+             llvm::cl::init(""), llvm::cl::value_desc("path"));
 
 static llvm::cl::opt<std::string>
 OutputFilename("o", llvm::cl::desc("Override output filename"),
@@ -130,11 +152,33 @@ Bmc ("horn-bmc",
      llvm::cl::desc ("Use BMC engine. Currently restricted to intra-procedural analysis"),
      llvm::cl::init (false));
 
+static llvm::cl::opt<bool>
+KInd ("horn-kind",
+      llvm::cl::desc ("Use BMC and k-induction on the cut-point graph. "
+                      "Currently restricted to intra-procedural analysis"),
+      llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+IncCheck ("horn-inc-check",
+          llvm::cl::desc ("Check every function for inconsistent code. "
+                          "Requires --horn-step=incsmall"),
+          llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+TermCheck ("horn-term",
+           llvm::cl::desc ("Prove termination of every loop with linear ranking functions"),
+           llvm::cl::init (false));
+
 static llvm::cl::opt<bool>
 OneAssumePerBlock ("horn-one-assume-per-block", 
                    llvm::cl::desc ("Make sure there is at most one call to verifier.assume per block"), 
                    llvm::cl::init (false));
 
+static llvm::cl::opt<bool>
+Coi ("horn-coi",
+     llvm::cl::desc ("Slice the program to the cone of influence of verifier.error"),
+     llvm::cl::init (false));
+
 // To switch between llvm-dsa and sea-dsa
 static llvm::cl::opt<bool>
 SeaHornDsa ("horn-sea-dsa",
@@ -165,35 +209,17 @@ std::string getFileName(const std::string &str) {
   return filename;
 }
 
-int main(int argc, char **argv) {
-  ufo::ScopedStats _st ("seahorn_total");
+/// Crab options on the command line, the key of the Crab cache
+static std::string CrabOpts;
 
-  llvm::llvm_shutdown_obj shutdown;  // calls llvm_shutdown() on exit
-  llvm::cl::AddExtraVersionPrinter (print_seahorn_version);
-  llvm::cl::ParseCommandLineOptions(argc, argv,
-                                    "SeaHorn -- LLVM bitcode to Horn/SMT2 transformation\n");
-
-  llvm::sys::PrintStackTraceOnErrorSignal();
-  llvm::PrettyStackTraceProgram PSTP(argc, argv);
-  llvm::EnableDebugBuffering = true;
+/// Runs the whole pipeline on one module
+static int verify (std::unique_ptr<llvm::Module> module) {
+  ufo::ScopedStats _st ("seahorn_total");
 
   std::error_code error_code;
-  llvm::SMDiagnostic err;
-  llvm::LLVMContext &context = llvm::getGlobalContext();
-  std::unique_ptr<llvm::Module> module;
   std::unique_ptr<llvm::tool_output_file> output;
   std::unique_ptr<llvm::tool_output_file> asmOutput;
 
-
-  module = llvm::parseIRFile(InputFilename, err, context);
-  if (module.get() == 0)
-  {
-    if (llvm::errs().has_colors()) llvm::errs().changeColor(llvm::raw_ostream::RED);
-    llvm::errs() << "error: "
-                 << "Bitcode was not properly read; " << err.getMessage() << "\n";
-    if (llvm::errs().has_colors()) llvm::errs().resetColor();
-    return 3;
-  }
   if (!AsmOutputFilename.empty ())
     asmOutput =
       llvm::make_unique<llvm::tool_output_file>(AsmOutputFilename.c_str(), error_code,
@@ -288,6 +314,9 @@ int main(int argc, char **argv) {
   pass_manager.add (seahorn::createStripLifetimePass ());
   pass_manager.add (seahorn::createDeadNondetElimPass ());
 
+  // -- needs shadow memory in SSA form
+  if (Coi) pass_manager.add (seahorn::createConeOfInfluencePass ());
+
   if (OneAssumePerBlock) {
     // -- it must be called after all the cfg simplifications
     pass_manager.add (seahorn::createOneAssumePerBlockPass ());
@@ -307,7 +336,7 @@ int main(int argc, char **argv) {
   pass_manager.add (seahorn::createCanReadUndefPass ());
 
 
-  if (!Bmc)
+  if (!Bmc && !KInd)
     pass_manager.add (new seahorn::HornifyModule ());
 
   // FIXME: if StripShadowMemPass () is executed then DsaPrinterPass
@@ -338,12 +367,16 @@ int main(int argc, char **argv) {
     if (!OutputFilename.empty ()) out = &output->os ();
     pass_manager.add (seahorn::createBmcPass (out, Solve));
   }
+  else if (KInd)
+    pass_manager.add (seahorn::createKInductionPass ());
   else
   {
     if (!OutputFilename.empty ()) pass_manager.add (new seahorn::HornWrite (output->os ()));
-    if (Crab) pass_manager.add (seahorn::createLoadCrabPass ());
+    if (Crab) pass_manager.add (seahorn::createLoadCrabPass (CrabOpts));
     if (HoudiniInv) pass_manager.add (new seahorn::HoudiniPass ());
     if (PredAbs) pass_manager.add(new seahorn::PredicateAbstraction());
+    if (IncCheck) pass_manager.add (new seahorn::IncChecker ());
+    if (TermCheck) pass_manager.add (new seahorn::TerminationChecker ());
     if (Solve)
     { 	  pass_manager.add (new seahorn::HornSolver ());
           if (Cex) pass_manager.add (new seahorn::HornCex ());
@@ -355,6 +388,221 @@ int main(int argc, char **argv) {
 
   if (!AsmOutputFilename.empty ()) asmOutput->keep ();
   if (!OutputFilename.empty ()) output->keep();
-  if (PrintStats) ufo::Stats::PrintBrunch (llvm::outs ());
+  // -- always report what was done when a phase ran out of budget
+  if (PrintStats || seahorn::ResourceGovernor::get ().anyExceeded ())
+    ufo::Stats::PrintBrunch (llvm::outs ());
   return 0;
 }
+
+static void readError (const llvm::SMDiagnostic &err) {
+  if (llvm::errs().has_colors()) llvm::errs().changeColor(llvm::raw_ostream::RED);
+  llvm::errs() << "error: "
+               << "Bitcode was not properly read; " << err.getMessage() << "\n";
+  if (llvm::errs().has_colors()) llvm::errs().resetColor();
+}
+
+/// Verifies a module in a child process, with the standard output and
+/// error of the child in out. An exit or a crash in the pipeline only
+/// ends the child, and no module or analysis outlives the request.
+/// keep is false if the result might change in another run, i.e.,
+/// the child crashed or a budget ran out
+static int verifyInChild (std::unique_ptr<llvm::MemoryBuffer> buf,
+                          std::string &out, bool &keep) {
+  keep = false;
+  llvm::outs ().flush ();
+  llvm::errs ().flush ();
+  std::fflush (stdout);
+  std::fflush (stderr);
+
+  FILE *tmp = std::tmpfile ();
+  int fds [2];
+  if (!tmp || pipe (fds) < 0) {
+    if (tmp) std::fclose (tmp);
+    out = std::string ("error: cannot start a request: ") + std::strerror (errno) + "\n";
+    return 3;
+  }
+
+  pid_t pid = fork ();
+  if (pid == 0) {
+    close (fds [0]);
+    dup2 (fileno (tmp), STDOUT_FILENO);
+    dup2 (fileno (tmp), STDERR_FILENO);
+    int code = 3;
+    llvm::SMDiagnostic err;
+    std::unique_ptr<llvm::Module> module =
+      seahorn::readModule (std::move (buf), err, llvm::getGlobalContext ());
+    if (!module) readError (err);
+    else code = verify (std::move (module));
+    llvm::outs ().flush ();
+    llvm::errs ().flush ();
+    std::fflush (stdout);
+    std::fflush (stderr);
+    char exceeded = seahorn::ResourceGovernor::get ().anyExceeded ();
+    if (write (fds [1], &exceeded, 1) != 1) code = 3;
+    _exit (code);
+  }
+
+  close (fds [1]);
+  int status = 0;
+  if (pid > 0)
+    while (waitpid (pid, &status, 0) < 0 && errno == EINTR);
+  // -- no byte if the child did not get to the end
+  char exceeded = 1;
+  if (pid > 0 && read (fds [0], &exceeded, 1) == 1 && !exceeded &&
+      WIFEXITED (status))
+    keep = true;
+  close (fds [0]);
+
+  std::rewind (tmp);
+  char data [4096];
+  size_t n;
+  while ((n = std::fread (data, 1, sizeof (data), tmp)) > 0) out.append (data, n);
+  std::fclose (tmp);
+
+  if (pid < 0) {
+    out += std::string ("error: cannot start a request: ") + std::strerror (errno) + "\n";
+    return 3;
+  }
+  if (WIFSIGNALED (status)) {
+    out += "error: seahorn was killed by signal " +
+      std::to_string (WTERMSIG (status)) + "\n";
+    return 3;
+  }
+  return WIFEXITED (status) ? WEXITSTATUS (status) : 3;
+}
+
+/// Serves verification requests on a local (unix) socket.
+///
+/// A request is a line with the path of a bitcode file, or "quit".
+/// The reply is what seahorn prints for that file, on both standard
+/// output and error, followed by a line "SEAHORN_EXIT <code>".
+///
+/// Every request is verified in a forked child, so that an exit or a
+/// crash in the pipeline does not stop the server. This saves the
+/// start-up of the process and the parsing of the options, and the
+/// last reply of every file is reused while the file is unchanged.
+/// It is not incremental: any change to a file verifies the whole
+/// module again, and no module, analysis or Z3 context outlives a
+/// request.
+static int serve (const std::string &path) {
+  sockaddr_un addr;
+  std::memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size () >= sizeof (addr.sun_path)) {
+    llvm::errs () << "error: socket path is too long: " << path << "\n";
+    return 3;
+  }
+  std::strncpy (addr.sun_path, path.c_str (), sizeof (addr.sun_path) - 1);
+
+  int sock = socket (AF_UNIX, SOCK_STREAM, 0);
+  unlink (path.c_str ());
+  if (sock < 0 ||
+      bind (sock, reinterpret_cast<sockaddr*> (&addr), sizeof (addr)) < 0 ||
+      listen (sock, 8) < 0) {
+    llvm::errs () << "error: could not listen on " << path << ": "
+                  << std::strerror (errno) << "\n";
+    return 3;
+  }
+  llvm::errs () << "seahorn: listening on " << path << "\n";
+
+  struct Result {
+    std::string hash;
+    std::string output;
+    int code;
+  };
+  std::map<std::string, Result> cache;
+
+  while (true) {
+    int client = accept (sock, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    std::string request;
+    char c;
+    while (read (client, &c, 1) == 1 && c != '\n') request += c;
+    request = llvm::StringRef (request).trim ().str ();
+    if (request == "quit") {
+      close (client);
+      break;
+    }
+
+    std::string reply;
+    int code = 3;
+    auto buf = llvm::MemoryBuffer::getFile (request);
+    if (!buf) {
+      reply = "error: could not read " + request + "\n";
+    } else {
+      llvm::MD5 md5;
+      md5.update ((*buf)->getBuffer ());
+      llvm::MD5::MD5Result digest;
+      md5.final (digest);
+      llvm::SmallString<32> hash;
+      llvm::MD5::stringifyResult (digest, hash);
+
+      Result &last = cache [request];
+      if (last.hash == hash.str ()) {
+        reply = last.output;
+        code = last.code;
+      } else {
+        bool keep;
+        code = verifyInChild (std::move (*buf), reply, keep);
+        // -- a run that was cut short might finish next time
+        if (keep) {
+          last.hash = hash.str ();
+          last.output = reply;
+          last.code = code;
+        }
+      }
+    }
+
+    reply += "SEAHORN_EXIT " + std::to_string (code) + "\n";
+    for (size_t off = 0; off < reply.size (); ) {
+      ssize_t n = write (client, reply.data () + off, reply.size () - off);
+      if (n <= 0) break;
+      off += n;
+    }
+    close (client);
+  }
+
+  close (sock);
+  unlink (path.c_str ());
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  llvm::llvm_shutdown_obj shutdown;  // calls llvm_shutdown() on exit
+  llvm::cl::AddExtraVersionPrinter (print_seahorn_version);
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "SeaHorn -- LLVM bitcode to Horn/SMT2 transformation\n");
+
+  // -- an option might take the next argument as its value
+  for (int i = 1; i < argc; ++i)
+    if (argv [i][0] == '-' &&
+        llvm::StringRef (argv [i]).ltrim ('-').startswith ("crab")) {
+      CrabOpts += std::string (argv [i]) + " ";
+      if (i + 1 < argc && argv [i + 1][0] != '-')
+        CrabOpts += std::string (argv [i + 1]) + " ";
+    }
+
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  llvm::PrettyStackTraceProgram PSTP(argc, argv);
+  llvm::EnableDebugBuffering = true;
+
+  if (!ServerSocket.empty ()) return serve (ServerSocket);
+
+  if (InputFilename.empty ()) {
+    llvm::errs () << "error: no input file\n";
+    return 3;
+  }
+
+  llvm::SMDiagnostic err;
+  std::unique_ptr<llvm::Module> module =
+    seahorn::readModule(InputFilename, err, llvm::getGlobalContext());
+  if (!module) {
+    readError (err);
+    return 3;
+  }
+  return verify (std::move (module));
+}
@@ -38,6 +38,9 @@
 #include "ufo/Passes/NameValues.hpp"
 #include "ufo/Smt/EZ3.hh"
 #include "ufo/Stats.hh"
+#include "seahorn/Support/ResourceGovernor.hh"
+#include "seahorn/Support/PassPipeline.hh"
+#include "seahorn/Support/LazyLoad.hh"
 
 #include "seahorn/config.h"
 
@@ -217,6 +220,18 @@ static llvm::cl::opt<bool>
                    llvm::cl::desc("Abstract memory instructions"),
                    llvm::cl::init(false));
 
+static llvm::cl::opt<unsigned> PPJobs(
+    "pp-jobs",
+    llvm::cl::desc("Run function-local passes on this many threads "
+                   "(0 = in a single pass manager)"),
+    llvm::cl::init(0));
+
+static llvm::cl::opt<bool>
+    PPTimePasses("pp-time-passes",
+                 llvm::cl::desc("Print the time spent in each pass "
+                                "(requires --pp-jobs)"),
+                 llvm::cl::init(false));
+
 // removes extension from filename if there is one
 std::string getFileName(const std::string &str) {
   std::string filename = str;
@@ -242,7 +257,7 @@ int main(int argc, char **argv) {
   std::unique_ptr<llvm::Module> module;
   std::unique_ptr<llvm::tool_output_file> output;
 
-  module = llvm::parseIRFile(InputFilename, err, context);
+  module = seahorn::readModule(InputFilename, err, context);
   if (!module) {
     if (llvm::errs().has_colors())
       llvm::errs().changeColor(llvm::raw_ostream::RED);
@@ -272,7 +287,7 @@ int main(int argc, char **argv) {
   // initialise and run passes //
   ///////////////////////////////
 
-  llvm::legacy::PassManager pass_manager;
+  seahorn::PassPipeline pass_manager(PPJobs);
   llvm::PassRegistry &Registry = *llvm::PassRegistry::getPassRegistry();
   llvm::initializeCore(Registry);
   llvm::initializeTransformUtils(Registry);
@@ -377,7 +392,7 @@ int main(int argc, char **argv) {
     pass_manager.add(seahorn::createPromoteMallocPass());
 
     // -- turn loads from _Bool from truc to sgt
-    pass_manager.add(seahorn::createPromoteBoolLoadsPass());
+    pass_manager.addLocal([] { return seahorn::createPromoteBoolLoadsPass(); });
 
     if (KillVaArg)
       pass_manager.add(seahorn::createKillVarArgFnPass());
@@ -394,9 +409,9 @@ int main(int argc, char **argv) {
 
     if (LowerInvoke) {
       // -- lower invoke's
-      pass_manager.add(llvm::createLowerInvokePass());
+      pass_manager.addLocal([] { return llvm::createLowerInvokePass(); });
       // cleanup after lowering invoke's
-      pass_manager.add(llvm::createCFGSimplificationPass());
+      pass_manager.addLocal([] { return llvm::createCFGSimplificationPass(); });
     }
 
     // -- resolve indirect calls
@@ -418,45 +433,47 @@ int main(int argc, char **argv) {
     pass_manager.add(seahorn::createLowerGvInitializersPass());
 
     // -- SSA
-    pass_manager.add(llvm::createPromoteMemoryToRegisterPass());
+    pass_manager.addLocal([] { return llvm::createPromoteMemoryToRegisterPass(); });
     // -- Turn undef into nondet
     pass_manager.add (seahorn::createNondetInitPass());
 
     // -- Promote memcpy to loads-and-stores for easier alias analysis.
-    pass_manager.add (seahorn::createPromoteMemcpyPass());
+    pass_manager.addLocal([] { return seahorn::createPromoteMemcpyPass(); });
 
     // -- cleanup after SSA
-    pass_manager.add(seahorn::createInstCombine());
-    pass_manager.add(llvm::createCFGSimplificationPass());
+    pass_manager.addLocal([] { return seahorn::createInstCombine(); });
+    pass_manager.addLocal([] { return llvm::createCFGSimplificationPass(); });
 
     // -- break aggregates
-    pass_manager.add(llvm::createScalarReplAggregatesPass(
-        SROA_Threshold, true, SROA_StructMemThreshold,
-        SROA_ArrayElementThreshold, SROA_ScalarLoadThreshold));
+    pass_manager.addLocal([] {
+      return llvm::createScalarReplAggregatesPass(
+          SROA_Threshold, true, SROA_StructMemThreshold,
+          SROA_ArrayElementThreshold, SROA_ScalarLoadThreshold);
+    });
     // -- Turn undef into nondet (undef are created by SROA when it calls
     // mem2reg)
     pass_manager.add(seahorn::createNondetInitPass());
 
     // -- cleanup after break aggregates
-    pass_manager.add(seahorn::createInstCombine());
-    pass_manager.add(llvm::createCFGSimplificationPass());
+    pass_manager.addLocal([] { return seahorn::createInstCombine(); });
+    pass_manager.addLocal([] { return llvm::createCFGSimplificationPass(); });
 
     // eliminate unused calls to verifier.nondet() functions
-    pass_manager.add(seahorn::createDeadNondetElimPass());
+    pass_manager.addLocal([] { return seahorn::createDeadNondetElimPass(); });
 
-    pass_manager.add(llvm::createLowerSwitchPass());
+    pass_manager.addLocal([] { return llvm::createLowerSwitchPass(); });
 
-    pass_manager.add(llvm::createDeadInstEliminationPass());
-    pass_manager.add(seahorn::createRemoveUnreachableBlocksPass());
+    pass_manager.addLocal([] { return llvm::createDeadInstEliminationPass(); });
+    pass_manager.addLocal([] { return seahorn::createRemoveUnreachableBlocksPass(); });
 
     // lower arithmetic with overflow intrinsics
-    pass_manager.add(seahorn::createLowerArithWithOverflowIntrinsicsPass());
+    pass_manager.addLocal([] { return seahorn::createLowerArithWithOverflowIntrinsicsPass(); });
     // lower libc++abi functions
     pass_manager.add(seahorn::createLowerLibCxxAbiFunctionsPass());
 
     // cleanup after lowering
-    pass_manager.add(seahorn::createInstCombine());
-    pass_manager.add(llvm::createCFGSimplificationPass());
+    pass_manager.addLocal([] { return seahorn::createInstCombine(); });
+    pass_manager.addLocal([] { return llvm::createCFGSimplificationPass(); });
 
     if (UnfoldLoopsForDsa) {
     // --- help DSA to be more precise
@@ -468,7 +485,7 @@ int main(int argc, char **argv) {
 
     if (SimplifyPointerLoops) {
       // --- simplify loops that iterate over pointers
-      pass_manager.add(seahorn::createSimplifyPointerLoopsPass());
+      pass_manager.addLocal([] { return seahorn::createSimplifyPointerLoopsPass(); });
     }
 
     // XXX: AG: Should not be part of standard pipeline
@@ -478,7 +495,7 @@ int main(int argc, char **argv) {
       pass_manager.add(seahorn::createAbstractMemoryPass());
       // -- abstract memory pass generates a lot of dead load/store
       // -- instructions
-      pass_manager.add(llvm::createDeadInstEliminationPass());
+      pass_manager.addLocal([] { return llvm::createDeadInstEliminationPass(); });
     }
 
     // AG: Used for inconsistency analysis
@@ -486,9 +503,9 @@ int main(int argc, char **argv) {
     if (LowerAssert) {
       pass_manager.add(seahorn::createLowerAssertPass());
       // LowerAssert might generate some dead code
-      pass_manager.add(llvm::createDeadInstEliminationPass());
+      pass_manager.addLocal([] { return llvm::createDeadInstEliminationPass(); });
     }
-    pass_manager.add(seahorn::createRemoveUnreachableBlocksPass());
+    pass_manager.addLocal([] { return seahorn::createRemoveUnreachableBlocksPass(); });
 
     // -- request seaopt to inline all functions
     if (InlineAll)
@@ -509,16 +526,16 @@ int main(int argc, char **argv) {
       pass_manager.add(
           llvm::createGlobalDCEPass()); // kill unused internal global
       pass_manager.add(seahorn::createPromoteMallocPass());
-      pass_manager.add(seahorn::createRemoveUnreachableBlocksPass());
+      pass_manager.addLocal([] { return seahorn::createRemoveUnreachableBlocksPass(); });
     }
 
     // -- EVERYTHING IS MORE EXPENSIVE AFTER INLINING
     // -- BEFORE SCHEDULING PASSES HERE, THINK WHETHER THEY BELONG BEFORE
     // INLINE!
-    pass_manager.add(llvm::createDeadInstEliminationPass());
+    pass_manager.addLocal([] { return llvm::createDeadInstEliminationPass(); });
     pass_manager.add(
         llvm::createGlobalDCEPass()); // kill unused internal global
-    pass_manager.add(llvm::createUnifyFunctionExitNodesPass());
+    pass_manager.addLocal([] { return llvm::createUnifyFunctionExitNodesPass(); });
 
     // -- moves loop initialization up
     // AG: After inline because cheap and loop initialization is moved higher up
@@ -529,7 +546,7 @@ int main(int argc, char **argv) {
     if (EnumVerifierCalls)
       pass_manager.add(seahorn::createEnumVerifierCallsPass());
 
-    pass_manager.add(seahorn::createRemoveUnreachableBlocksPass());
+    pass_manager.addLocal([] { return seahorn::createRemoveUnreachableBlocksPass(); });
     pass_manager.add(seahorn::createPromoteMallocPass());
     pass_manager.add(
         llvm::createGlobalDCEPass()); // kill unused internal global
@@ -558,7 +575,12 @@ int main(int argc, char **argv) {
       pass_manager.add(createBitcodeWriterPass(output->os()));
   }
 
-  pass_manager.run(*module.get());
+  {
+    seahorn::ScopedPhase _phase("pp");
+    pass_manager.run(module);
+  }
+  if (PPTimePasses)
+    pass_manager.printTimes(llvm::errs());
 
   if (!OutputFilename.empty())
     output->keep();
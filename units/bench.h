@@ -0,0 +1,45 @@
+#ifndef __SEA_BENCH_H_
+#define __SEA_BENCH_H_
+
+/**
+ * A minimal microbenchmark harness.
+ *
+ * A benchmark is a function that runs its body a given number of
+ * times. The driver (bench_main.cpp) picks the number of iterations so
+ * that a run takes long enough to time, keeps the fastest of a few
+ * runs, and prints the time of one iteration as a BRUNCH_STAT line so
+ * that the usual stats scripts (and py/sea_bench.py) can read it.
+ */
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace seabench
+{
+  typedef std::function<void (unsigned)> BenchFn;
+
+  inline std::vector<std::pair<std::string, BenchFn> > &registry ()
+  {
+    static std::vector<std::pair<std::string, BenchFn> > r;
+    return r;
+  }
+
+  struct Register
+  {
+    Register (const char *name, BenchFn fn)
+    { registry ().push_back (std::make_pair (std::string (name), fn)); }
+  };
+
+  /// keeps the compiler from optimizing away a computed value
+  template <typename T> inline void keep (const T &v)
+  { asm volatile ("" : : "g" (&v) : "memory"); }
+}
+
+#define SEA_BENCH(NAME)                                             \
+  static void NAME##_bench (unsigned iters);                        \
+  static seabench::Register NAME##_reg (#NAME, NAME##_bench);       \
+  static void NAME##_bench (unsigned iters)
+
+#endif
@@ -0,0 +1,43 @@
+#include "bench.h"
+#include "ufo/Expr.hpp"
+
+using namespace expr;
+
+namespace
+{
+  Expr chain (ExprFactory &efac, unsigned n)
+  {
+    Expr y = bind::intConst (mkTerm<std::string> ("y", efac));
+    Expr res = bind::intConst (mkTerm<std::string> ("x", efac));
+    for (unsigned i = 0; i < n; ++i)
+      res = mk<PLUS> (res, mk<MULT> (y, mkTerm (mpz_class (i), efac)));
+    return res;
+  }
+}
+
+// -- every node is new
+SEA_BENCH (expr_mk_new)
+{
+  for (unsigned i = 0; i < iters; ++i)
+  {
+    ExprFactory efac;
+    seabench::keep (chain (efac, 1000));
+  }
+}
+
+// -- every node is already in the factory
+SEA_BENCH (expr_mk_hit)
+{
+  ExprFactory efac;
+  Expr e = chain (efac, 1000);
+  for (unsigned i = 0; i < iters; ++i)
+    seabench::keep (chain (efac, 1000));
+}
+
+SEA_BENCH (expr_dag_size)
+{
+  ExprFactory efac;
+  Expr e = chain (efac, 1000);
+  for (unsigned i = 0; i < iters; ++i)
+    seabench::keep (dagSize (e));
+}
@@ -0,0 +1,64 @@
+#include "bench.h"
+#include "seahorn/HornClauseDB.hh"
+
+using namespace expr;
+using namespace seahorn;
+
+namespace
+{
+  /// relations P0..Pn-1 over 10 integers. Every Pi has a rule from
+  /// P(i-1) and one from P(i/2)
+  void fill (HornClauseDB &db, unsigned n)
+  {
+    ExprFactory &efac = db.getExprFactory ();
+    ExprVector vars, sorts;
+    for (unsigned i = 0; i < 10; ++i)
+    {
+      vars.push_back (bind::intConst (variant::variant (i, mkTerm<std::string> ("v", efac))));
+      sorts.push_back (mk<INT_TY> (efac));
+    }
+    sorts.push_back (mk<BOOL_TY> (efac));
+
+    ExprVector rels;
+    for (unsigned i = 0; i < n; ++i)
+    {
+      rels.push_back (bind::fdecl (variant::variant (i, mkTerm<std::string> ("P", efac)), sorts));
+      db.registerRelation (rels.back ());
+    }
+
+    db.addRule (vars, bind::fapp (rels [0], vars));
+    for (unsigned i = 1; i < n; ++i)
+    {
+      Expr guard = mk<LT> (vars [i % 10], mkTerm (mpz_class (i), efac));
+      db.addRule (vars, mk<IMPL> (mk<AND> (bind::fapp (rels [i - 1], vars), guard),
+                                  bind::fapp (rels [i], vars)));
+      db.addRule (vars, mk<IMPL> (mk<AND> (bind::fapp (rels [i / 2], vars), guard),
+                                  bind::fapp (rels [i], vars)));
+    }
+  }
+}
+
+SEA_BENCH (horn_db_index)
+{
+  ExprFactory efac;
+  HornClauseDB db (efac);
+  fill (db, 2000);
+  for (unsigned i = 0; i < iters; ++i)
+  {
+    db.buildIndexes ();
+    seabench::keep (db.use (bind::fname (db.getRules ().front ().head ())));
+  }
+}
+
+SEA_BENCH (horn_db_callgraph)
+{
+  ExprFactory efac;
+  HornClauseDB db (efac);
+  fill (db, 2000);
+  for (unsigned i = 0; i < iters; ++i)
+  {
+    HornClauseDBCallGraph cg (db);
+    cg.buildCallGraph ();
+    seabench::keep (cg.hasEntry ());
+  }
+}
@@ -0,0 +1,108 @@
+#include "bench.h"
+#include "seahorn/LiveSymbols.hh"
+#include "seahorn/UfoSymExec.hh"
+
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include <sstream>
+
+using namespace llvm;
+using namespace seahorn;
+
+namespace
+{
+  /// a loop whose body is a chain of n diamonds. Each diamond updates
+  /// one of 20 loop-carried variables
+  std::string mkFunction (unsigned n)
+  {
+    std::ostringstream os;
+    os << "declare i1 @nd()\n"
+       << "define i32 @main() {\n"
+       << "entry:\n  br label %head\n"
+       << "head:\n";
+    for (unsigned v = 0; v < 20; ++v)
+      os << "  %x" << v << " = phi i32 [0, %entry], [%d" << n - 1 << "_" << v << ", %latch]\n";
+    os << "  %c = call i1 @nd()\n  br i1 %c, label %b0, label %exit\n";
+
+    for (unsigned i = 0; i < n; ++i)
+    {
+      // -- the current value of every variable before diamond i
+      auto cur = [&] (unsigned v)
+        {
+          std::ostringstream s;
+          if (i == 0) s << "%x" << v;
+          else s << "%d" << i - 1 << "_" << v;
+          return s.str ();
+        };
+      unsigned upd = i % 20;
+      os << "b" << i << ":\n"
+         << "  %c" << i << " = call i1 @nd()\n"
+         << "  br i1 %c" << i << ", label %t" << i << ", label %j" << i << "\n"
+         << "t" << i << ":\n"
+         << "  %a" << i << " = add i32 " << cur (upd) << ", 1\n"
+         << "  br label %j" << i << "\n"
+         << "j" << i << ":\n";
+      for (unsigned v = 0; v < 20; ++v)
+      {
+        if (v == upd)
+          os << "  %d" << i << "_" << v << " = phi i32 [" << cur (v) << ", %b" << i
+             << "], [%a" << i << ", %t" << i << "]\n";
+        else
+          os << "  %d" << i << "_" << v << " = add i32 " << cur (v) << ", 0\n";
+      }
+      os << "  br label %" << (i + 1 < n ? "b" + std::to_string (i + 1) : std::string ("latch")) << "\n";
+    }
+    os << "latch:\n  br label %head\n"
+       << "exit:\n  ret i32 %x0\n}\n";
+    return os.str ();
+  }
+
+  /// LiveSymbols needs a symbolic execution, which needs a pass
+  struct LiveSymbolsBench : public ModulePass
+  {
+    static char ID;
+    unsigned m_iters;
+    LiveSymbolsBench (unsigned iters) : ModulePass (ID), m_iters (iters) {}
+
+    bool runOnModule (Module &M) override
+    {
+      ExprFactory efac;
+      UfoSmallSymExec sem (efac, *this, M.getDataLayout (), REG);
+      const Function &F = *M.getFunction ("main");
+      for (unsigned i = 0; i < m_iters; ++i)
+      {
+        LiveSymbols ls (F, efac, sem);
+        ls.run ();
+        seabench::keep (ls.live (&F.getEntryBlock ()));
+      }
+      return false;
+    }
+    void getAnalysisUsage (AnalysisUsage &AU) const override
+    {AU.setPreservesAll ();}
+  };
+  char LiveSymbolsBench::ID = 0;
+}
+
+SEA_BENCH (live_symbols)
+{
+  static LLVMContext ctx;
+  static std::unique_ptr<Module> M;
+  if (!M)
+  {
+    SMDiagnostic err;
+    M = parseAssemblyString (mkFunction (200), err, ctx);
+    if (!M)
+    {
+      err.print ("units_bench", errs ());
+      return;
+    }
+  }
+
+  legacy::PassManager pm;
+  pm.add (new LiveSymbolsBench (iters));
+  pm.run (*M);
+}
@@ -0,0 +1,58 @@
+// Driver for the microbenchmarks. Usage: units_bench [filter] [--min-time=secs]
+#include "bench.h"
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+  typedef std::chrono::steady_clock clock_type;
+
+  double timeRun (const seabench::BenchFn &fn, unsigned iters)
+  {
+    clock_type::time_point start = clock_type::now ();
+    fn (iters);
+    return std::chrono::duration<double> (clock_type::now () - start).count ();
+  }
+}
+
+int main (int argc, char **argv)
+{
+  std::string filter;
+  double minTime = 0.2;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strncmp (argv [i], "--min-time=", 11) == 0)
+      minTime = std::atof (argv [i] + 11);
+    else
+      filter = argv [i];
+  }
+
+  for (auto &b : seabench::registry ())
+  {
+    if (!filter.empty () && b.first.find (filter) == std::string::npos) continue;
+
+    // -- grow the number of iterations until a run is long enough
+    unsigned iters = 1;
+    double t = timeRun (b.second, iters);
+    while (t < minTime && iters < (1U << 30))
+    {
+      iters *= 2;
+      t = timeRun (b.second, iters);
+    }
+
+    // -- the fastest of a few runs is the least noisy
+    double best = t;
+    for (unsigned r = 0; r < 2; ++r)
+      best = std::min (best, timeRun (b.second, iters));
+
+    llvm::outs () << "BRUNCH_STAT bench." << b.first << ".ns "
+                  << llvm::format ("%.1f", best * 1e9 / iters) << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include "bench.h"
+#include "ufo/Smt/EZ3.hh"
+
+using namespace expr;
+using namespace ufo;
+
+namespace
+{
+  /// a conjunction of 500 linear constraints over 50 variables
+  Expr formula (ExprFactory &efac)
+  {
+    ExprVector vars;
+    for (unsigned i = 0; i < 50; ++i)
+      vars.push_back (bind::intConst (variant::variant (i, mkTerm<std::string> ("x", efac))));
+
+    ExprVector conjs;
+    for (unsigned i = 0; i < 500; ++i)
+    {
+      Expr lhs = mk<PLUS> (vars [i % 50], vars [(i * 7 + 3) % 50]);
+      conjs.push_back (mk<LEQ> (lhs, mkTerm (mpz_class (i), efac)));
+    }
+    return mknary<AND> (conjs);
+  }
+}
+
+// -- includes creating a context, since the cache lives in it
+SEA_BENCH (zctx_marshal)
+{
+  ExprFactory efac;
+  Expr e = formula (efac);
+  for (unsigned i = 0; i < iters; ++i)
+  {
+    EZ3 z3 (efac);
+    seabench::keep (z3.toAst (e));
+  }
+}
+
+SEA_BENCH (zctx_roundtrip)
+{
+  ExprFactory efac;
+  Expr e = formula (efac);
+  for (unsigned i = 0; i < iters; ++i)
+  {
+    EZ3 z3 (efac);
+    seabench::keep (z3.toExpr (z3.toAst (e)));
+  }
+}